@@ -0,0 +1,159 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2007 Andreas Obergrusberger <tradiaz@yahoo.de>
+ * Copyright (C) 2008-2010 Valeriy Lyasotskiy <onestep@ukr.net>
+ * Copyright (C) 2010-2011 Jonathan Conder <jonno.conder@gmail.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "pk-alpm-cache.h"
+
+static void
+pk_alpm_test_write (const gchar *dir, const gchar *name, const gchar *contents, gssize length)
+{
+	g_autofree gchar *filename = NULL;
+	g_autofree gchar *parent = NULL;
+	g_autoptr(GError) error = NULL;
+
+	filename = g_build_filename (dir, name, NULL);
+	parent = g_path_get_dirname (filename);
+	g_assert_cmpint (g_mkdir_with_parents (parent, 0755), ==, 0);
+	g_file_set_contents (filename, contents, length, &error);
+	g_assert_no_error (error);
+}
+
+static void
+pk_alpm_test_copy (const gchar *dir, const gchar *name, const gchar *fixture)
+{
+	gsize length;
+	g_autofree gchar *contents = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(GError) error = NULL;
+
+	filename = g_build_filename (TESTDATADIR, "alpm", fixture, NULL);
+	g_file_get_contents (filename, &contents, &length, &error);
+	g_assert_no_error (error);
+	pk_alpm_test_write (dir, name, contents, length);
+}
+
+static void
+pk_alpm_test_remove (const gchar *path)
+{
+	const gchar *name;
+	GDir *dir;
+
+	dir = g_dir_open (path, 0, NULL);
+	if (dir != NULL) {
+		while ((name = g_dir_read_name (dir)) != NULL) {
+			g_autofree gchar *child = g_build_filename (path, name, NULL);
+			pk_alpm_test_remove (child);
+		}
+		g_dir_close (dir);
+	}
+	g_remove (path);
+}
+
+/**
+ * pk_alpm_test_update_func:
+ *
+ * Installs foo-1-1, finds foo-2-1 as an update the way GetUpdates does and
+ * keeps the result, updates foo and then checks the update is not
+ * reported again.
+ **/
+static void
+pk_alpm_test_update_func (void)
+{
+	PkBackendAlpmPrivate priv = { 0 };
+	alpm_errno_t err;
+	alpm_list_t *data = NULL;
+	alpm_pkg_t *pkg;
+	alpm_pkg_t *update;
+	const alpm_list_t *syncdbs;
+	g_autofree gchar *cachedir = NULL;
+	g_autofree gchar *dbpath = NULL;
+	g_autofree gchar *logfile = NULL;
+	g_autofree gchar *root = NULL;
+	const gchar *desc = "%NAME%\nfoo\n\n%VERSION%\n1-1\n\n%ARCH%\nany\n\n";
+
+	root = g_dir_make_tmp ("alpm-self-test-XXXXXX", NULL);
+	g_assert (root != NULL);
+	dbpath = g_build_filename (root, "var", "lib", "pacman", NULL);
+	cachedir = g_build_filename (root, "var", "cache", "pacman", "pkg", NULL);
+	logfile = g_build_filename (root, "pacman.log", NULL);
+	pk_alpm_test_write (dbpath, "local/ALPM_DB_VERSION", "9\n", -1);
+	pk_alpm_test_write (dbpath, "local/foo-1-1/desc", desc, -1);
+	pk_alpm_test_write (dbpath, "local/foo-1-1/files", "", -1);
+	pk_alpm_test_copy (dbpath, "sync/core.db", "core.db");
+	pk_alpm_test_copy (cachedir, "foo-2-1-any.pkg.tar", "foo-2-1-any.pkg.tar");
+
+	priv.alpm = alpm_initialize (root, dbpath, &err);
+	g_assert (priv.alpm != NULL);
+	alpm_option_set_logfile (priv.alpm, logfile);
+	alpm_option_add_cachedir (priv.alpm, cachedir);
+	alpm_option_set_hookdirs (priv.alpm, NULL);
+	g_assert (alpm_register_syncdb (priv.alpm, "core", 0) != NULL);
+	priv.localdb = alpm_get_localdb (priv.alpm);
+	priv.applications = g_hash_table_new_full (g_str_hash, g_str_equal,
+						   g_free, NULL);
+	syncdbs = alpm_get_syncdbs (priv.alpm);
+
+	/* GetUpdates finds foo-2-1 and keeps the result */
+	pkg = alpm_db_get_pkg (priv.localdb, "foo");
+	g_assert (pkg != NULL);
+	update = pk_alpm_pkg_find_update (pkg, syncdbs);
+	g_assert (update != NULL);
+	g_assert_cmpstr (alpm_pkg_get_version (update), ==, "2-1");
+	priv.updates = g_array_new (FALSE, FALSE, sizeof (alpm_pkg_t *));
+	g_array_append_val (priv.updates, update);
+
+	/* update foo without touching anything outside the database */
+	g_assert_cmpint (alpm_trans_init (priv.alpm, ALPM_TRANS_FLAG_DBONLY |
+					  ALPM_TRANS_FLAG_NOSCRIPTLET), ==, 0);
+	g_assert_cmpint (alpm_sync_sysupgrade (priv.alpm, FALSE), ==, 0);
+	g_assert_cmpint (alpm_trans_prepare (priv.alpm, &data), ==, 0);
+	g_assert_cmpint (pk_alpm_cache_commit (&priv, &data), ==, 0);
+	alpm_trans_release (priv.alpm);
+
+	/* the kept result is gone, and GetUpdates now finds nothing */
+	g_assert (priv.updates == NULL);
+	pkg = alpm_db_get_pkg (priv.localdb, "foo");
+	g_assert (pkg != NULL);
+	g_assert_cmpstr (alpm_pkg_get_version (pkg), ==, "2-1");
+	g_assert (pk_alpm_pkg_find_update (pkg, syncdbs) == NULL);
+
+	pk_alpm_cache_clear (&priv);
+	g_hash_table_unref (priv.applications);
+	alpm_release (priv.alpm);
+	pk_alpm_test_remove (root);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	/* tests go here */
+	g_test_add_func ("/alpm/update", pk_alpm_test_update_func);
+
+	return g_test_run ();
+}
@@ -0,0 +1,94 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2007 Andreas Obergrusberger <tradiaz@yahoo.de>
+ * Copyright (C) 2008-2010 Valeriy Lyasotskiy <onestep@ukr.net>
+ * Copyright (C) 2010-2011 Jonathan Conder <jonno.conder@gmail.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <config.h>
+
+#include "pk-alpm-cache.h"
+
+/* drop everything computed from the package caches of the databases */
+void
+pk_alpm_cache_clear (PkBackendAlpmPrivate *priv)
+{
+	g_hash_table_remove_all (priv->applications);
+	g_clear_pointer (&priv->updates, g_array_unref);
+	g_clear_pointer (&priv->indexes, g_hash_table_unref);
+	g_clear_pointer (&priv->depends, g_hash_table_unref);
+	g_clear_pointer (&priv->satisfiers, g_hash_table_unref);
+	g_clear_pointer (&priv->requiredby, g_hash_table_unref);
+}
+
+/*
+ * The file monitor does not see our own transactions, and a commit frees
+ * the localdb packages it replaces, so everything cached from them has to
+ * go. This is done even if the commit failed, as it may have got part of
+ * the way through.
+ */
+gint
+pk_alpm_cache_commit (PkBackendAlpmPrivate *priv, alpm_list_t **data)
+{
+	gint ret;
+
+	ret = alpm_trans_commit (priv->alpm, data);
+	pk_alpm_cache_clear (priv);
+	return ret;
+}
+
+static gboolean
+pk_alpm_pkg_replaces (alpm_pkg_t *pkg, const gchar *name)
+{
+	g_return_val_if_fail (pkg != NULL, FALSE);
+	g_return_val_if_fail (name != NULL, FALSE);
+
+	return alpm_list_find_str (alpm_pkg_get_replaces (pkg), name) != NULL;
+}
+
+alpm_pkg_t *
+pk_alpm_pkg_find_update (alpm_pkg_t *pkg, const alpm_list_t *dbs)
+{
+	const gchar *name;
+	const alpm_list_t *i;
+
+	g_return_val_if_fail (pkg != NULL, NULL);
+
+	name = alpm_pkg_get_name (pkg);
+
+	for (; dbs != NULL; dbs = dbs->next) {
+		alpm_pkg_t *update = alpm_db_get_pkg (dbs->data, name);
+
+		if (update != NULL) {
+			if (alpm_pkg_vercmp (alpm_pkg_get_version (update),
+					     alpm_pkg_get_version (pkg)) > 0) {
+				return update;
+			}
+			return NULL;
+		}
+
+		i = alpm_db_get_pkgcache (dbs->data);
+		for (; i != NULL; i = i->next) {
+			if (pk_alpm_pkg_replaces (i->data, name))
+				return i->data;
+		}
+	}
+
+	return NULL;
+}
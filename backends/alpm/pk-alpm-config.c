@@ -832,14 +832,23 @@ pk_alpm_config_configure_repos (PkBackend *backend, PkAlpmConfig *config,
 }
 
 static gboolean
-pk_alpm_spawn (const gchar *command)
+pk_alpm_spawn (const gchar *command, const gchar *directory)
 {
 	int status;
+	g_auto(GStrv) argv = NULL;
 	g_autoptr(GError) error = NULL;
 
 	g_return_val_if_fail (command != NULL, FALSE);
 
-	if (!g_spawn_command_line_sync (command, NULL, NULL, &status, &error)) {
+	if (!g_shell_parse_argv (command, NULL, &argv, &error)) {
+		g_warning ("could not parse command: %s", error->message);
+		return FALSE;
+	}
+
+	/* run in the target directory rather than chdir'ing the daemon,
+	 * so several downloads can be in flight at once */
+	if (!g_spawn_sync (directory, argv, NULL, G_SPAWN_SEARCH_PATH,
+			   NULL, NULL, NULL, NULL, &status, &error)) {
 		g_warning ("could not spawn command: %s", error->message);
 		return FALSE;
 	}
@@ -858,15 +867,59 @@ pk_alpm_spawn (const gchar *command)
 	return TRUE;
 }
 
-static gint
-pk_alpm_fetchcb (const gchar *url, const gchar *path, gint force)
+/* urls already downloaded by pk_alpm_fetch() ahead of alpm_db_update() */
+static GHashTable *prefetched = NULL;
+static GMutex prefetched_mutex;
+
+gboolean
+pk_alpm_fetch_is_external (void)
+{
+	return xfercmd != NULL;
+}
+
+void
+pk_alpm_fetch_set_prefetched (const gchar *url)
+{
+	g_return_if_fail (url != NULL);
+
+	g_mutex_lock (&prefetched_mutex);
+	if (prefetched == NULL)
+		prefetched = g_hash_table_new_full (g_str_hash, g_str_equal,
+						    g_free, NULL);
+	g_hash_table_add (prefetched, g_strdup (url));
+	g_mutex_unlock (&prefetched_mutex);
+}
+
+void
+pk_alpm_fetch_clear_prefetched (void)
+{
+	g_mutex_lock (&prefetched_mutex);
+	if (prefetched != NULL)
+		g_hash_table_remove_all (prefetched);
+	g_mutex_unlock (&prefetched_mutex);
+}
+
+static gboolean
+pk_alpm_fetch_take_prefetched (const gchar *url)
+{
+	gboolean ret = FALSE;
+
+	g_mutex_lock (&prefetched_mutex);
+	if (prefetched != NULL)
+		ret = g_hash_table_remove (prefetched, url);
+	g_mutex_unlock (&prefetched_mutex);
+
+	return ret;
+}
+
+gint
+pk_alpm_fetch (const gchar *url, const gchar *path, gint force)
 {
 	GRegex *xo, *xi;
 	gint result = 0;
 	g_autofree gchar *basename = NULL;
 	g_autofree gchar *file = NULL;
 	g_autofree gchar *finalcmd = NULL;
-	g_autofree gchar *oldpwd = NULL;
 	g_autofree gchar *part = NULL;
 	g_autofree gchar *tempcmd = NULL;
 
@@ -874,10 +927,8 @@ pk_alpm_fetchcb (const gchar *url, const gchar *path, gint force)
 	g_return_val_if_fail (path != NULL, -1);
 	g_return_val_if_fail (xfercmd != NULL, -1);
 
-	oldpwd = g_get_current_dir ();
-	if (g_chdir (path) < 0) {
+	if (!g_file_test (path, G_FILE_TEST_IS_DIR)) {
 		g_warning ("could not find or read directory '%s'", path);
-		g_free (oldpwd);
 		return -1;
 	}
 
@@ -905,7 +956,7 @@ pk_alpm_fetchcb (const gchar *url, const gchar *path, gint force)
 		goto out;
 	}
 
-	if (!pk_alpm_spawn (finalcmd)) {
+	if (!pk_alpm_spawn (finalcmd, path)) {
 		result = -1;
 		goto out;
 	}
@@ -921,11 +972,21 @@ out:
 	g_regex_unref (xi);
 	g_regex_unref (xo);
 
-	g_chdir (oldpwd);
-
 	return result;
 }
 
+static gint
+pk_alpm_fetchcb (const gchar *url, const gchar *path, gint force)
+{
+	g_return_val_if_fail (url != NULL, -1);
+
+	/* already downloaded by pk_alpm_update_databases() */
+	if (pk_alpm_fetch_take_prefetched (url))
+		return 0;
+
+	return pk_alpm_fetch (url, path, force);
+}
+
 static alpm_handle_t *
 pk_alpm_config_configure_alpm (PkBackend *backend, PkAlpmConfig *config, GError **error)
 {
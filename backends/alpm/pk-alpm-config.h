@@ -25,3 +25,9 @@
 #include <glib.h>
 
 alpm_handle_t	*pk_alpm_configure	(PkBackend *backend, const gchar *filename, GError **error);
+
+gboolean	 pk_alpm_fetch_is_external	(void);
+gint		 pk_alpm_fetch			(const gchar *url, const gchar *path,
+						 gint force);
+void		 pk_alpm_fetch_set_prefetched	(const gchar *url);
+void		 pk_alpm_fetch_clear_prefetched	(void);
@@ -23,115 +23,262 @@
 
 #include <alpm.h>
 #include <pk-backend.h>
+#include <string.h>
 
 #include "pk-backend-alpm.h"
 #include "pk-alpm-error.h"
 #include "pk-alpm-packages.h"
+#include "pk-alpm-search.h"
 
-static alpm_pkg_t *
-pk_alpm_list_find_pkgname (const alpm_list_t *pkgs, const gchar *name)
+/* a dependency string and the package that satisfies it */
+typedef struct {
+	gchar		*depend;
+	alpm_pkg_t	*local;
+	alpm_pkg_t	*remote;
+} PkAlpmDepend;
+
+static void
+pk_alpm_depend_free (PkAlpmDepend *dep)
+{
+	g_free (dep->depend);
+	g_free (dep);
+}
+
+static PkAlpmDepend *
+pk_alpm_depends_resolve (PkBackendAlpmPrivate *priv, const gchar *depend)
+{
+	PkAlpmDepend *dep;
+	alpm_list_t *pkgcache, *syncdbs;
+
+	/* dropped by pk_alpm_cache_clear() */
+	if (priv->satisfiers == NULL) {
+		priv->satisfiers = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+							  (GDestroyNotify) pk_alpm_depend_free);
+	}
+
+	dep = g_hash_table_lookup (priv->satisfiers, depend);
+	if (dep != NULL)
+		return dep;
+
+	dep = g_new0 (PkAlpmDepend, 1);
+	dep->depend = g_strdup (depend);
+
+	/* prefer local dependencies */
+	pkgcache = alpm_db_get_pkgcache (priv->localdb);
+	dep->local = alpm_find_satisfier (pkgcache, depend);
+	if (dep->local == NULL) {
+		syncdbs = alpm_get_syncdbs (priv->alpm);
+		dep->remote = alpm_find_dbs_satisfier (priv->alpm, syncdbs, depend);
+	}
+
+	g_hash_table_insert (priv->satisfiers, dep->depend, dep);
+	return dep;
+}
+
+/* package pointers do not survive a reload, so key on what they are */
+static gchar *
+pk_alpm_depends_build_key (alpm_pkg_t *pkg)
+{
+	return g_strdup_printf ("%s-%s-%s", alpm_pkg_get_name (pkg),
+				alpm_pkg_get_version (pkg),
+				alpm_db_get_name (alpm_pkg_get_db (pkg)));
+}
+
+static GPtrArray *
+pk_alpm_depends_get (PkBackendAlpmPrivate *priv, alpm_pkg_t *pkg)
+{
+	GPtrArray *depends;
+	const alpm_list_t *i;
+	gchar *key;
+
+	/* dropped by pk_alpm_cache_clear() */
+	if (priv->depends == NULL) {
+		priv->depends = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						       (GDestroyNotify) g_ptr_array_unref);
+	}
+
+	key = pk_alpm_depends_build_key (pkg);
+	depends = g_hash_table_lookup (priv->depends, key);
+	if (depends != NULL) {
+		g_free (key);
+		return depends;
+	}
+
+	depends = g_ptr_array_new ();
+	for (i = alpm_pkg_get_depends (pkg); i != NULL; i = i->next) {
+		g_autofree gchar *depend = alpm_dep_compute_string (i->data);
+		g_ptr_array_add (depends, pk_alpm_depends_resolve (priv, depend));
+	}
+
+	g_hash_table_insert (priv->depends, key, depends);
+	return depends;
+}
+
+static gchar **
+pk_alpm_requiredby_get (PkBackendAlpmPrivate *priv, alpm_pkg_t *pkg)
 {
-	g_return_val_if_fail (name != NULL, NULL);
+	gchar **requiredby;
+	alpm_list_t *list, *i;
+	guint j = 0;
+	gchar *key;
+
+	/* dropped by pk_alpm_cache_clear() */
+	if (priv->requiredby == NULL) {
+		priv->requiredby = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+							  (GDestroyNotify) g_strfreev);
+	}
 
-	for (; pkgs != NULL; pkgs = pkgs->next) {
-		if (g_strcmp0 (name, alpm_pkg_get_name (pkgs->data)) == 0)
-			return pkgs->data;
+	key = pk_alpm_depends_build_key (pkg);
+	requiredby = g_hash_table_lookup (priv->requiredby, key);
+	if (requiredby != NULL) {
+		g_free (key);
+		return requiredby;
 	}
 
-	return NULL;
+	list = alpm_pkg_compute_requiredby (pkg);
+	requiredby = g_new0 (gchar *, alpm_list_count (list) + 1);
+	for (i = list; i != NULL; i = i->next)
+		requiredby[j++] = g_strdup (i->data);
+	FREELIST (list);
+
+	g_hash_table_insert (priv->requiredby, key, requiredby);
+	return requiredby;
 }
 
 static alpm_list_t *
-pk_alpm_find_provider (PkBackendJob *job, alpm_list_t *pkgs,
-		       const gchar *depend, gboolean recursive,
-		       PkBitfield filters, GError **error)
+pk_alpm_depends_add_listed (PkBackendJob *job, alpm_list_t *candidates,
+			    GHashTable *visited, alpm_db_t *db, const gchar *name)
+{
+	const GPtrArray *provides;
+	alpm_pkg_t *pkg;
+	guint i;
+
+	pkg = alpm_db_get_pkg (db, name);
+	if (pkg != NULL && g_hash_table_contains (visited, pkg))
+		candidates = alpm_list_add (candidates, pkg);
+
+	provides = pk_alpm_search_lookup_provides (job, db, name);
+	for (i = 0; provides != NULL && i < provides->len; i++) {
+		pkg = g_ptr_array_index (provides, i);
+		if (g_hash_table_contains (visited, pkg))
+			candidates = alpm_list_add (candidates, pkg);
+	}
+	return candidates;
+}
+
+/* only packages with the name, or providing it, can satisfy a depend, so
+ * just those need checking rather than everything listed so far */
+static gboolean
+pk_alpm_depends_is_listed (PkBackendJob *job, GHashTable *visited, const gchar *depend)
 {
 	PkBackend *backend = pk_backend_job_get_backend (job);
 	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
-	gboolean skip_local, skip_remote;
+	alpm_list_t *candidates;
+	const alpm_list_t *i;
+	gboolean ret;
+	g_autofree gchar *name = NULL;
+
+	name = g_strndup (depend, strcspn (depend, "<>="));
+	candidates = pk_alpm_depends_add_listed (job, NULL, visited,
+						 priv->localdb, name);
+	for (i = alpm_get_syncdbs (priv->alpm); i != NULL; i = i->next) {
+		candidates = pk_alpm_depends_add_listed (job, candidates, visited,
+							 i->data, name);
+	}
 
-	alpm_pkg_t *provider;
-	alpm_list_t *pkgcache, *syncdbs;
+	ret = alpm_find_satisfier (candidates, depend) != NULL;
+	alpm_list_free (candidates);
+	return ret;
+}
+
+static alpm_list_t *
+pk_alpm_find_provider (PkBackendJob *job, alpm_list_t *pkgs, GHashTable *visited,
+		       PkAlpmDepend *dep, gboolean recursive,
+		       PkBitfield filters, GError **error)
+{
+	gboolean skip_local, skip_remote;
 
-	g_return_val_if_fail (depend != NULL, pkgs);
+	g_return_val_if_fail (dep != NULL, pkgs);
 
 	skip_local = pk_bitfield_contain (filters,
 					  PK_FILTER_ENUM_NOT_INSTALLED);
 	skip_remote = pk_bitfield_contain (filters, PK_FILTER_ENUM_INSTALLED);
 
-	if (alpm_find_satisfier (pkgs, depend) != NULL) {
+	/* the usual satisfier is listed already, else look for any other */
+	if (g_hash_table_contains (visited, dep->local != NULL ? dep->local : dep->remote))
+		return pkgs;
+	if (pk_alpm_depends_is_listed (job, visited, dep->depend))
 		return pkgs;
-	}
 
 	/* look for local dependencies */
-	pkgcache = alpm_db_get_pkgcache (priv->localdb);
-	provider = alpm_find_satisfier (pkgcache, depend);
-
-	if (provider != NULL) {
+	if (dep->local != NULL) {
 		if (!skip_local) {
-			pk_alpm_pkg_emit (job, provider, PK_INFO_ENUM_INSTALLED);
+			pk_alpm_pkg_emit (job, dep->local, PK_INFO_ENUM_INSTALLED);
 			/* assume later dependencies will also be local */
 			if (recursive) {
-				pkgs = alpm_list_add (pkgs, provider);
+				pkgs = alpm_list_add (pkgs, dep->local);
+				g_hash_table_add (visited, dep->local);
 			}
 		}
-
 		return pkgs;
 	}
 
 	/* look for remote dependencies */
-	syncdbs = alpm_get_syncdbs (priv->alpm);
-	provider = alpm_find_dbs_satisfier (priv->alpm, syncdbs, depend);
-
-	if (provider != NULL) {
+	if (dep->remote != NULL) {
 		if (!skip_remote)
-			pk_alpm_pkg_emit (job, provider, PK_INFO_ENUM_AVAILABLE);
+			pk_alpm_pkg_emit (job, dep->remote, PK_INFO_ENUM_AVAILABLE);
 		/* keep looking for local dependencies */
-		if (recursive)
-			pkgs = alpm_list_add (pkgs, provider);
+		if (recursive) {
+			pkgs = alpm_list_add (pkgs, dep->remote);
+			g_hash_table_add (visited, dep->remote);
+		}
 	} else {
 		int code = ALPM_ERR_UNSATISFIED_DEPS;
-		g_set_error (error, PK_ALPM_ERROR, code, "%s: %s", depend,
+		g_set_error (error, PK_ALPM_ERROR, code, "%s: %s", dep->depend,
 			     alpm_strerror (code));
 	}
 
 	return pkgs;
 }
 
-static alpm_list_t *
-pk_backend_find_requirer (PkBackendJob *job, alpm_list_t *pkgs, const gchar *name, gboolean recursive,
-			  GError **error)
+static void
+pk_backend_find_requirer (PkBackendJob *job, GPtrArray *pkgs, GHashTable *visited,
+			  const gchar *name, gboolean recursive, GError **error)
 {
 	PkBackend *backend = pk_backend_job_get_backend (job);
 	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
 	alpm_pkg_t *requirer;
 
-	g_return_val_if_fail (name != NULL, pkgs);
+	g_return_if_fail (name != NULL);
 
-	if (pk_alpm_list_find_pkgname (pkgs, name) != NULL)
-		return pkgs;
+	if (g_hash_table_contains (visited, name))
+		return;
 
 	/* look for local requirers */
 	requirer = alpm_db_get_pkg (priv->localdb, name);
 
 	if (requirer != NULL) {
 		pk_alpm_pkg_emit (job, requirer, PK_INFO_ENUM_INSTALLED);
-		if (recursive)
-			pkgs = alpm_list_add (pkgs, requirer);
+		if (recursive) {
+			g_ptr_array_add (pkgs, requirer);
+			g_hash_table_add (visited, (gpointer) alpm_pkg_get_name (requirer));
+		}
 	} else {
 		int code = ALPM_ERR_PKG_NOT_FOUND;
 		g_set_error (error, PK_ALPM_ERROR, code, "%s: %s", name,
 			     alpm_strerror (code));
 	}
-
-	return pkgs;
 }
 
 static void
 pk_backend_depends_on_thread (PkBackendJob* job, GVariant* params, gpointer p)
 {
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
 	gchar **packages;
+	guint j;
 	alpm_list_t *i, *pkgs = NULL;
+	g_autoptr(GHashTable) visited = NULL;
 	g_autoptr(GError) error = NULL;
 	PkBitfield filters;
 	gboolean recursive;
@@ -139,6 +286,8 @@ pk_backend_depends_on_thread (PkBackendJob* job, GVariant* params, gpointer p)
 	g_variant_get (params, "(t^a&sb)",
 		       &filters, &packages, &recursive);
 
+	visited = g_hash_table_new (g_direct_hash, g_direct_equal);
+
 	/* construct an initial package list */
 	for (; *packages != NULL; ++packages) {
 		alpm_pkg_t *pkg;
@@ -151,35 +300,40 @@ pk_backend_depends_on_thread (PkBackendJob* job, GVariant* params, gpointer p)
 			break;
 
 		pkgs = alpm_list_add (pkgs, pkg);
+		g_hash_table_add (visited, pkg);
 	}
 
 	/* package list might be modified along the way but that is ok */
 	for (i = pkgs; i != NULL; i = i->next) {
-		const alpm_list_t *depends;
+		GPtrArray *depends;
 
 		if (pk_backend_job_is_cancelled (job) || error != NULL)
 			break;
 
-		depends = alpm_pkg_get_depends (i->data);
-		for (; depends != NULL; depends = depends->next) {
-			g_autofree gchar *depend = NULL;
-
+		depends = pk_alpm_depends_get (priv, i->data);
+		for (j = 0; j < depends->len; j++) {
 			if (pk_backend_job_is_cancelled (job) || error != NULL)
 				break;
 
-			depend = alpm_dep_compute_string (depends->data);
-			pkgs = pk_alpm_find_provider (job, pkgs, depend, recursive, filters, &error);
+			pkgs = pk_alpm_find_provider (job, pkgs, visited,
+						      g_ptr_array_index (depends, j),
+						      recursive, filters, &error);
 		}
 	}
 
 	alpm_list_free (pkgs);
+	pk_alpm_finish (job, error);
 }
 
 static void
 pk_backend_required_by_thread (PkBackendJob* job, GVariant* params, gpointer p)
 {
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
 	gchar **packages;
-	alpm_list_t *i, *pkgs = NULL;
+	guint i, j;
+	g_autoptr(GPtrArray) pkgs = NULL;
+	g_autoptr(GHashTable) visited = NULL;
 	g_autoptr(GError) error = NULL;
 	gboolean recursive;
 	PkBitfield filters;
@@ -187,6 +341,9 @@ pk_backend_required_by_thread (PkBackendJob* job, GVariant* params, gpointer p)
 	g_variant_get (params, "(t^a&sb)",
 		       &filters, &packages, &recursive);
 
+	pkgs = g_ptr_array_new ();
+	visited = g_hash_table_new (g_str_hash, g_str_equal);
+
 	/* construct an initial package list */
 	for (; *packages != NULL; ++packages) {
 		alpm_pkg_t *pkg;
@@ -198,29 +355,27 @@ pk_backend_required_by_thread (PkBackendJob* job, GVariant* params, gpointer p)
 		if (pkg == NULL)
 			break;
 
-		pkgs = alpm_list_add (pkgs, pkg);
+		g_ptr_array_add (pkgs, pkg);
+		g_hash_table_add (visited, (gpointer) alpm_pkg_get_name (pkg));
 	}
 
 	/* package list might be modified along the way but that is ok */
-	for (i = pkgs; i != NULL; i = i->next) {
-		alpm_list_t *requiredby;
+	for (i = 0; i < pkgs->len; i++) {
+		gchar **requiredby;
 
 		if (pk_backend_job_is_cancelled (job) || error != NULL)
 			break;
 
-		requiredby = alpm_pkg_compute_requiredby (i->data);
-		for (; requiredby != NULL; requiredby = requiredby->next) {
+		requiredby = pk_alpm_requiredby_get (priv, g_ptr_array_index (pkgs, i));
+		for (j = 0; requiredby[j] != NULL; j++) {
 			if (pk_backend_job_is_cancelled (job) || error != NULL)
 				break;
 
-			pkgs = pk_backend_find_requirer (job, pkgs,
-							 requiredby->data, recursive, &error);
+			pk_backend_find_requirer (job, pkgs, visited,
+						  requiredby[j], recursive, &error);
 		}
-
-		FREELIST (requiredby);
 	}
 
-	alpm_list_free (pkgs);
 	pk_alpm_finish (job, error);
 }
 
@@ -28,6 +28,7 @@
 #include "pk-backend-alpm.h"
 #include "pk-alpm-groups.h"
 #include "pk-alpm-packages.h"
+#include "pk-alpm-search.h"
 
 static gpointer
 pk_backend_pattern_needle (PkBackend *backend, const gchar *needle, GError **error)
@@ -195,6 +196,144 @@ pk_alpm_pkg_match_provides (alpm_pkg_t *pkg, gpointer pattern)
 	return FALSE;
 }
 
+/* lookup tables for one database, each built on first use */
+typedef struct {
+	GHashTable	*paths;		/* path → packages */
+	GHashTable	*basenames;	/* basename → packages */
+	GHashTable	*provides;	/* provide, with and without version → packages */
+	GHashTable	*groups;	/* PackageKit group → packages */
+} PkAlpmIndex;
+
+static void
+pk_alpm_index_free (PkAlpmIndex *index)
+{
+	if (index->paths != NULL)
+		g_hash_table_unref (index->paths);
+	if (index->basenames != NULL)
+		g_hash_table_unref (index->basenames);
+	if (index->provides != NULL)
+		g_hash_table_unref (index->provides);
+	if (index->groups != NULL)
+		g_hash_table_unref (index->groups);
+	g_free (index);
+}
+
+static GHashTable *
+pk_alpm_index_table_new (void)
+{
+	return g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+				      (GDestroyNotify) g_ptr_array_unref);
+}
+
+static void
+pk_alpm_index_add (GHashTable *table, const gchar *key, alpm_pkg_t *pkg)
+{
+	GPtrArray *pkgs = g_hash_table_lookup (table, key);
+
+	if (pkgs == NULL) {
+		pkgs = g_ptr_array_new ();
+		g_hash_table_insert (table, g_strdup (key), pkgs);
+	} else if (g_ptr_array_index (pkgs, pkgs->len - 1) == pkg) {
+		/* packages are added in order, so duplicates are adjacent */
+		return;
+	}
+
+	g_ptr_array_add (pkgs, pkg);
+}
+
+static void
+pk_alpm_index_build_files (PkAlpmIndex *index, alpm_db_t *db)
+{
+	const alpm_list_t *i;
+	gsize j;
+
+	index->paths = pk_alpm_index_table_new ();
+	index->basenames = pk_alpm_index_table_new ();
+
+	for (i = alpm_db_get_pkgcache (db); i != NULL; i = i->next) {
+		alpm_filelist_t *files = alpm_pkg_get_files (i->data);
+
+		for (j = 0; j < files->count; ++j) {
+			const gchar *file = files->files[j].name;
+			const gchar *name = strrchr (file, G_DIR_SEPARATOR);
+
+			pk_alpm_index_add (index->paths, file, i->data);
+
+			if (name == NULL) {
+				name = file;
+			} else {
+				++name;
+			}
+
+			/* directories have no basename */
+			if (*name != '\0')
+				pk_alpm_index_add (index->basenames, name, i->data);
+		}
+	}
+}
+
+static void
+pk_alpm_index_build_provides (PkAlpmIndex *index, alpm_db_t *db)
+{
+	const alpm_list_t *i, *j;
+
+	index->provides = pk_alpm_index_table_new ();
+
+	for (i = alpm_db_get_pkgcache (db); i != NULL; i = i->next) {
+		for (j = alpm_pkg_get_provides (i->data); j != NULL; j = j->next) {
+			const gchar *provide = j->data;
+			gsize len = strcspn (provide, "=");
+			g_autofree gchar *name = NULL;
+
+			/* match both name=version and the bare name */
+			pk_alpm_index_add (index->provides, provide, i->data);
+			if (provide[len] == '\0')
+				continue;
+			name = g_strndup (provide, len);
+			pk_alpm_index_add (index->provides, name, i->data);
+		}
+	}
+}
+
+static void
+pk_alpm_index_build_groups (PkAlpmIndex *index, alpm_db_t *db)
+{
+	const alpm_list_t *i;
+
+	index->groups = pk_alpm_index_table_new ();
+
+	for (i = alpm_db_get_pkgcache (db); i != NULL; i = i->next)
+		pk_alpm_index_add (index->groups, pk_alpm_pkg_get_group (i->data), i->data);
+}
+
+static const GPtrArray *
+pk_alpm_index_lookup_file (PkAlpmIndex *index, alpm_db_t *db, const gchar *needle)
+{
+	if (index->paths == NULL)
+		pk_alpm_index_build_files (index, db);
+
+	/* full paths are stored without the leading slash */
+	if (G_IS_DIR_SEPARATOR (*needle))
+		return g_hash_table_lookup (index->paths, needle + 1);
+	return g_hash_table_lookup (index->basenames, needle);
+}
+
+static const GPtrArray *
+pk_alpm_index_lookup_group (PkAlpmIndex *index, alpm_db_t *db, const gchar *needle)
+{
+	if (index->groups == NULL)
+		pk_alpm_index_build_groups (index, db);
+	return g_hash_table_lookup (index->groups, needle);
+}
+
+static const GPtrArray *
+pk_alpm_index_lookup_provides (PkAlpmIndex *index, alpm_db_t *db, const gchar *needle)
+{
+	if (index->provides == NULL)
+		pk_alpm_index_build_provides (index, db);
+	return g_hash_table_lookup (index->provides, needle);
+}
+
 typedef enum {
 	SEARCH_TYPE_ALL,
 	SEARCH_TYPE_DETAILS,
@@ -207,6 +346,7 @@ typedef enum {
 
 typedef gpointer (*PatternFunc) (PkBackend *backend, const gchar *needle, GError **error);
 typedef gboolean (*MatchFunc) (alpm_pkg_t *pkg, gpointer pattern);
+typedef const GPtrArray *(*IndexFunc) (PkAlpmIndex *index, alpm_db_t *db, gpointer pattern);
 
 static PatternFunc pattern_funcs[] = {
 	pk_backend_pattern_needle,
@@ -235,6 +375,15 @@ static MatchFunc match_funcs[] = {
 	pk_alpm_pkg_match_provides
 };
 
+static IndexFunc index_funcs[] = {
+	NULL,
+	NULL,
+	(IndexFunc) pk_alpm_index_lookup_file,
+	(IndexFunc) pk_alpm_index_lookup_group,
+	NULL,
+	(IndexFunc) pk_alpm_index_lookup_provides
+};
+
 static gboolean
 pk_alpm_pkg_is_local (PkBackendJob *job, alpm_pkg_t *pkg)
 {
@@ -265,61 +414,130 @@ pk_alpm_pkg_is_local (PkBackendJob *job, alpm_pkg_t *pkg)
 }
 
 static gboolean
-pk_alpm_search_is_application (alpm_pkg_t *pkg) {
-	guint i;
+pk_alpm_search_is_application (PkBackendJob *job, alpm_pkg_t *pkg)
+{
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
 	alpm_filelist_t *filelist;
-	g_autoptr(GRegex) regex = NULL;
+	gboolean ret = FALSE;
+	gchar *key;
+	gpointer value;
+	guint i;
 
-	filelist = alpm_pkg_get_files (pkg);
-	regex = g_regex_new ("^usr/share/applications/.*\\.desktop$", 0, 0, NULL);
+	/* already looked at this one; the sync dbs have no filelists, so
+	 * the same name-version can give a different answer in localdb */
+	key = g_strdup_printf ("%s-%s-%s", alpm_pkg_get_name (pkg),
+			       alpm_pkg_get_version (pkg),
+			       alpm_db_get_name (alpm_pkg_get_db (pkg)));
+	if (g_hash_table_lookup_extended (priv->applications, key, NULL, &value)) {
+		g_free (key);
+		return GPOINTER_TO_INT (value);
+	}
 
+	/* look for a desktop file in usr/share/applications */
+	filelist = alpm_pkg_get_files (pkg);
 	for (i = 0; i < filelist->count; i++) {
-		const alpm_file_t *file = filelist->files + i;
-		if (g_regex_match (regex, file->name, 0, NULL)) {
-			return TRUE;
+		const gchar *name = filelist->files[i].name;
+		if (g_str_has_prefix (name, "usr/share/applications/") &&
+		    g_str_has_suffix (name, ".desktop")) {
+			ret = TRUE;
+			break;
 		}
 	}
-	return FALSE;
+
+	g_hash_table_insert (priv->applications, key, GINT_TO_POINTER (ret));
+	return ret;
+}
+
+static PkAlpmIndex *
+pk_alpm_search_get_index (PkBackendJob *job, alpm_db_t *db)
+{
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
+	PkAlpmIndex *index;
+
+	/* dropped by pk_alpm_cache_clear() */
+	if (priv->indexes == NULL) {
+		priv->indexes = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+						       (GDestroyNotify) pk_alpm_index_free);
+	}
+
+	index = g_hash_table_lookup (priv->indexes, db);
+	if (index == NULL) {
+		index = g_new0 (PkAlpmIndex, 1);
+		g_hash_table_insert (priv->indexes, db, index);
+	}
+	return index;
+}
+
+/* the packages in @db providing @name, with any version */
+const GPtrArray *
+pk_alpm_search_lookup_provides (PkBackendJob *job, alpm_db_t *db, const gchar *name)
+{
+	return pk_alpm_index_lookup_provides (pk_alpm_search_get_index (job, db), db, name);
 }
 
 static void
-pk_backend_search_db (PkBackendJob *job, alpm_db_t *db, MatchFunc match,
-		      const alpm_list_t *patterns, PkBitfield filters)
+pk_backend_search_pkg (PkBackendJob *job, alpm_db_t *db, alpm_pkg_t *pkg,
+		       MatchFunc match, const alpm_list_t *patterns,
+		       PkBitfield filters)
 {
 	PkBackend *backend = pk_backend_job_get_backend (job);
 	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
-	const alpm_list_t *i, *j;
+	const alpm_list_t *i;
 
-	g_return_if_fail (db != NULL);
-	g_return_if_fail (match != NULL);
+	for (i = patterns; i != NULL; i = i->next) {
+		if (!match (pkg, i->data))
+			return;
+	}
 
-	/* emit packages that match all search terms */
-	for (i = alpm_db_get_pkgcache (db); i != NULL; i = i->next) {
-		if (pk_backend_job_is_cancelled (job))
-			break;
+	/* want applications */
+	if (pk_bitfield_contain (filters, PK_FILTER_ENUM_APPLICATION) && !pk_alpm_search_is_application (job, pkg))
+		return;
 
-		for (j = patterns; j != NULL; j = j->next) {
-			if (!match (i->data, j->data))
-				break;
-		}
+	/* don't want applications */
+	if (pk_bitfield_contain (filters, PK_FILTER_ENUM_NOT_APPLICATION) && pk_alpm_search_is_application (job, pkg))
+		return;
 
-		/* not all search terms matched */
-		if (j != NULL)
-			continue;
+	if (db == priv->localdb) {
+		pk_alpm_pkg_emit (job, pkg, PK_INFO_ENUM_INSTALLED);
+	} else if (!pk_alpm_pkg_is_local (job, pkg)) {
+		pk_alpm_pkg_emit (job, pkg, PK_INFO_ENUM_AVAILABLE);
+	}
+}
 
-		/* want applications */
-		if (pk_bitfield_contain (filters, PK_FILTER_ENUM_APPLICATION) && !pk_alpm_search_is_application (i->data))
-			continue;
+static void
+pk_backend_search_db (PkBackendJob *job, alpm_db_t *db, MatchFunc match,
+		      IndexFunc index, const alpm_list_t *patterns,
+		      PkBitfield filters)
+{
+	const alpm_list_t *i;
+	const GPtrArray *pkgs;
+	guint j;
 
-		/* don't want applications */
-		if (pk_bitfield_contain (filters, PK_FILTER_ENUM_NOT_APPLICATION) && pk_alpm_search_is_application (i->data))
-			continue;
+	g_return_if_fail (db != NULL);
+	g_return_if_fail (match != NULL);
 
-		if (db == priv->localdb) {
-			pk_alpm_pkg_emit (job, i->data, PK_INFO_ENUM_INSTALLED);
-		} else if (!pk_alpm_pkg_is_local (job, i->data)) {
-			pk_alpm_pkg_emit (job, i->data, PK_INFO_ENUM_AVAILABLE);
+	if (index == NULL || patterns == NULL) {
+		/* emit packages that match all search terms */
+		for (i = alpm_db_get_pkgcache (db); i != NULL; i = i->next) {
+			if (pk_backend_job_is_cancelled (job))
+				break;
+			pk_backend_search_pkg (job, db, i->data, match,
+					       patterns, filters);
 		}
+		return;
+	}
+
+	/* only the packages matching the first term can match them all */
+	pkgs = index (pk_alpm_search_get_index (job, db), db, patterns->data);
+	if (pkgs == NULL)
+		return;
+	for (j = 0; j < pkgs->len; j++) {
+		if (pk_backend_job_is_cancelled (job))
+			break;
+		pk_backend_search_pkg (job, db, g_ptr_array_index (pkgs, j),
+				       match, patterns->next, filters);
 	}
 }
 
@@ -334,6 +552,7 @@ pk_backend_search_thread (PkBackendJob *job, GVariant* params, gpointer p)
 	PatternFunc pattern_func;
 	GDestroyNotify pattern_free;
 	MatchFunc match_func;
+	IndexFunc index_func;
 
 	PkRoleEnum role;
 	PkBitfield filters = 0;
@@ -387,6 +606,7 @@ pk_backend_search_thread (PkBackendJob *job, GVariant* params, gpointer p)
 	pattern_func = pattern_funcs[type];
 	pattern_free = pattern_frees[type];
 	match_func = match_funcs[type];
+	index_func = index_funcs[type];
 
 	g_return_if_fail (pattern_func != NULL);
 	g_return_if_fail (match_func != NULL);
@@ -409,7 +629,7 @@ pk_backend_search_thread (PkBackendJob *job, GVariant* params, gpointer p)
 
 	/* find installed packages first */
 	if (!skip_local)
-		pk_backend_search_db (job, priv->localdb, match_func, patterns, filters);
+		pk_backend_search_db (job, priv->localdb, match_func, index_func, patterns, filters);
 
 	if (skip_remote)
 		goto out;
@@ -418,7 +638,8 @@ pk_backend_search_thread (PkBackendJob *job, GVariant* params, gpointer p)
 		if (pk_backend_job_is_cancelled (job))
 			break;
 
-		pk_backend_search_db (job, i->data, match_func, patterns, filters);
+		pk_backend_search_db (job, i->data, match_func, index_func,
+				      patterns, filters);
 	}
 out:
 	if (pattern_free != NULL)
@@ -22,6 +22,7 @@
  */
 
 #include "pk-backend-alpm.h"
+#include "pk-alpm-cache.h"
 #include "pk-alpm-error.h"
 #include "pk-alpm-packages.h"
 #include "pk-alpm-transaction.h"
@@ -1024,7 +1025,7 @@ pk_alpm_transaction_commit (PkBackendJob *job, GError **error)
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_RUNNING);
 
 	pk_backend_transaction_inhibit_start (backend);
-	commit_result = alpm_trans_commit (priv->alpm, &data);
+	commit_result = pk_alpm_cache_commit (priv, &data);
 	pk_backend_transaction_inhibit_end (backend);
 	if (commit_result >= 0)
 		return TRUE;
@@ -31,6 +31,8 @@
 #include <errno.h>
 
 #include "pk-backend-alpm.h"
+#include "pk-alpm-cache.h"
+#include "pk-alpm-config.h"
 #include "pk-alpm-error.h"
 #include "pk-alpm-packages.h"
 #include "pk-alpm-transaction.h"
@@ -274,6 +276,8 @@ pk_alpm_update_database (PkBackendJob *job, gint force, alpm_db_t *db, GError **
 	result = alpm_db_update (force, db);
 	if (result > 0) {
 		dlcb ("", 1, 1);
+	} else if (result == 0) {
+		pk_alpm_caches_invalidate (backend);
 	} else if (result < 0) {
 		g_set_error (error, PK_ALPM_ERROR, alpm_errno (priv->alpm), "[%s]: %s",
 				alpm_db_get_name (db),
@@ -284,6 +288,130 @@ pk_alpm_update_database (PkBackendJob *job, gint force, alpm_db_t *db, GError **
 	return pk_alpm_update_set_db_timestamp (db, error);
 }
 
+typedef struct {
+	gchar		*filename;
+	gchar		*path;
+	gchar		**urls;
+	gboolean	 signature;
+	gint		 force;
+	gboolean	 ret;
+} PkAlpmPrefetchItem;
+
+static void
+pk_alpm_prefetch_item_free (PkAlpmPrefetchItem *item)
+{
+	g_free (item->filename);
+	g_free (item->path);
+	g_strfreev (item->urls);
+	g_free (item);
+}
+
+static void
+pk_alpm_update_prefetch_thread (gpointer data, gpointer user_data)
+{
+	PkAlpmPrefetchItem *item = (PkAlpmPrefetchItem *) data;
+	GAsyncQueue *done = (GAsyncQueue *) user_data;
+	guint i;
+
+	/* first mirror that works wins, same as alpm_db_update() */
+	for (i = 0; item->urls[i] != NULL; i++) {
+		if (pk_alpm_fetch (item->urls[i], item->path, item->force) < 0)
+			continue;
+		pk_alpm_fetch_set_prefetched (item->urls[i]);
+
+		if (item->signature) {
+			g_autofree gchar *sig = NULL;
+			sig = g_strconcat (item->urls[i], ".sig", NULL);
+			if (pk_alpm_fetch (sig, item->path, 1) == 0)
+				pk_alpm_fetch_set_prefetched (sig);
+		}
+		item->ret = TRUE;
+		break;
+	}
+
+	g_async_queue_push (done, item);
+}
+
+/*
+ * Downloads the sync databases using up to MaxParallelDownloads instances
+ * of XferCommand, so that alpm_db_update() only has to load them. The
+ * built-in libalpm downloader cannot be used from several threads, so
+ * without an XferCommand the databases are still fetched one by one.
+ */
+static void
+pk_alpm_update_prefetch_databases (PkBackendJob *job, gint force,
+				   alpm_cb_download dlcb)
+{
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
+	const alpm_list_t *i, *j;
+	gint max_threads = 0;
+	guint pending = 0;
+	GAsyncQueue *done;
+	GThreadPool *pool;
+	g_autofree gchar *path = NULL;
+	g_autoptr(GPtrArray) items = NULL;
+
+	if (!pk_alpm_fetch_is_external ())
+		return;
+
+	if (priv->conf != NULL)
+		max_threads = g_key_file_get_integer (priv->conf, "Daemon",
+						      "MaxParallelDownloads", NULL);
+	if (max_threads <= 0)
+		max_threads = 4;
+
+	path = g_strconcat (alpm_option_get_dbpath (priv->alpm), "sync/", NULL);
+	items = g_ptr_array_new_with_free_func ((GDestroyNotify) pk_alpm_prefetch_item_free);
+	done = g_async_queue_new ();
+	pool = g_thread_pool_new (pk_alpm_update_prefetch_thread, done,
+				  max_threads, TRUE, NULL);
+
+	for (i = alpm_get_syncdbs (priv->alpm); i != NULL; i = i->next) {
+		PkAlpmPrefetchItem *item;
+		GPtrArray *urls;
+
+		if (pk_alpm_update_is_db_fresh (job, i->data))
+			continue;
+
+		item = g_new0 (PkAlpmPrefetchItem, 1);
+		item->filename = g_strconcat (alpm_db_get_name (i->data), ".db", NULL);
+		item->path = g_strdup (path);
+		item->force = force;
+		item->signature = (alpm_db_get_siglevel (i->data) & ALPM_SIG_DATABASE) != 0;
+
+		urls = g_ptr_array_new ();
+		for (j = alpm_db_get_servers (i->data); j != NULL; j = j->next)
+			g_ptr_array_add (urls, g_strconcat (j->data, "/", item->filename, NULL));
+		g_ptr_array_add (urls, NULL);
+		item->urls = (gchar **) g_ptr_array_free (urls, FALSE);
+
+		g_ptr_array_add (items, item);
+		g_thread_pool_push (pool, item, NULL);
+		pending++;
+	}
+
+	/* report progress from this thread only, the callbacks are not
+	 * thread safe */
+	while (pending > 0) {
+		PkAlpmPrefetchItem *item;
+
+		if (pk_backend_job_is_cancelled (job))
+			break;
+
+		item = g_async_queue_timeout_pop (done, G_USEC_PER_SEC / 10);
+		if (item == NULL)
+			continue;
+		pending--;
+		if (item->ret)
+			dlcb (item->filename, 1, 1);
+	}
+
+	/* drops anything not yet started and waits for the rest */
+	g_thread_pool_free (pool, TRUE, TRUE);
+	g_async_queue_unref (done);
+}
+
 static gboolean
 pk_alpm_update_databases (PkBackendJob *job, gint force, GError **error)
 {
@@ -305,6 +433,9 @@ pk_alpm_update_databases (PkBackendJob *job, gint force, GError **error)
 	i = alpm_get_syncdbs (priv->alpm);
 	totaldlcb (-alpm_list_count (i));
 
+	pk_alpm_update_prefetch_databases (job, force,
+					   alpm_option_get_dlcb (priv->alpm));
+
 	for (; i != NULL; i = i->next) {
 		if (pk_backend_job_is_cancelled (job)) {
 			/* pretend to be finished */
@@ -319,6 +450,7 @@ pk_alpm_update_databases (PkBackendJob *job, gint force, GError **error)
 	}
 
 	totaldlcb (0);
+	pk_alpm_fetch_clear_prefetched ();
 
 	if (i == NULL)
 		return pk_alpm_transaction_end (job, error);
@@ -357,59 +489,75 @@ pk_alpm_pkg_is_syncfirst (alpm_list_t *syncfirsts, alpm_pkg_t *pkg)
 }
 
 static gboolean
-pk_alpm_pkg_replaces (alpm_pkg_t *pkg, const gchar *name)
+pk_alpm_update_is_pkg_downloaded (alpm_pkg_t *pkg)
 {
-	g_return_val_if_fail (pkg != NULL, FALSE);
-	g_return_val_if_fail (name != NULL, FALSE);
+	g_autofree gchar *filename = NULL;
 
-	return alpm_list_find_str (alpm_pkg_get_replaces (pkg), name) != NULL;
+	filename = g_strconcat ("/var/cache/pacman/pkg/",
+				alpm_pkg_get_name (pkg),
+				"-",
+				alpm_pkg_get_version (pkg),
+				"-",
+				alpm_pkg_get_arch (pkg),
+				".pkg.tar.xz",
+				NULL);
+	return g_file_test (filename, G_FILE_TEST_IS_REGULAR);
 }
 
-static alpm_pkg_t *
-pk_alpm_pkg_find_update (alpm_pkg_t *pkg, const alpm_list_t *dbs)
+typedef struct {
+	alpm_pkg_t	*pkg;
+	PkInfoEnum	 info;
+} PkAlpmUpdate;
+
+/* the loaded databases are good enough to answer from */
+static gboolean
+pk_alpm_update_databases_are_fresh (PkBackendJob *job)
 {
-	const gchar *name;
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
 	const alpm_list_t *i;
 
-	g_return_val_if_fail (pkg != NULL, NULL);
+	for (i = alpm_get_syncdbs (priv->alpm); i != NULL; i = i->next) {
+		if (!pk_alpm_update_is_db_fresh (job, i->data))
+			return FALSE;
+	}
+	return TRUE;
+}
 
-	name = alpm_pkg_get_name (pkg);
+static GArray *
+pk_alpm_update_find_updates (PkBackendJob *job)
+{
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
+	const alpm_list_t *i, *syncdbs;
+	GArray *updates;
 
-	for (; dbs != NULL; dbs = dbs->next) {
-		alpm_pkg_t *update = alpm_db_get_pkg (dbs->data, name);
+	updates = g_array_new (FALSE, FALSE, sizeof (PkAlpmUpdate));
 
-		if (update != NULL) {
-			if (alpm_pkg_vercmp (alpm_pkg_get_version (update),
-					     alpm_pkg_get_version (pkg)) > 0) {
-				return update;
-			}
+	/* find outdated and replacement packages */
+	syncdbs = alpm_get_syncdbs (priv->alpm);
+	for (i = alpm_db_get_pkgcache (priv->localdb); i != NULL; i = i->next) {
+		PkAlpmUpdate update;
+
+		if (pk_backend_job_is_cancelled (job)) {
+			g_array_unref (updates);
 			return NULL;
 		}
 
-		i = alpm_db_get_pkgcache (dbs->data);
-		for (; i != NULL; i = i->next) {
-			if (pk_alpm_pkg_replaces (i->data, name))
-				return i->data;
+		update.pkg = pk_alpm_pkg_find_update (i->data, syncdbs);
+		if (update.pkg == NULL)
+			continue;
+
+		update.info = PK_INFO_ENUM_NORMAL;
+		if (pk_alpm_pkg_is_ignorepkg (backend, update.pkg)) {
+			update.info = PK_INFO_ENUM_BLOCKED;
+		} else if (pk_alpm_pkg_is_syncfirst (priv->syncfirsts, update.pkg)) {
+			update.info = PK_INFO_ENUM_IMPORTANT;
 		}
+		g_array_append_val (updates, update);
 	}
 
-	return NULL;
-}
-
-static gboolean
-pk_alpm_update_is_pkg_downloaded (alpm_pkg_t *pkg)
-{
-	g_autofree gchar *filename = NULL;
-
-	filename = g_strconcat ("/var/cache/pacman/pkg/",
-				alpm_pkg_get_name (pkg),
-				"-",
-				alpm_pkg_get_version (pkg),
-				"-",
-				alpm_pkg_get_arch (pkg),
-				".pkg.tar.xz",
-				NULL);
-	return g_file_test (filename, G_FILE_TEST_IS_REGULAR);
+	return updates;
 }
 
 static void
@@ -417,42 +565,42 @@ pk_backend_get_updates_thread (PkBackendJob *job, GVariant* params, gpointer p)
 {
 	PkBackend *backend = pk_backend_job_get_backend (job);
 	PkBackendAlpmPrivate *priv = pk_backend_get_user_data (backend);
-	const alpm_list_t *i, *syncdbs;
 	g_autoptr(GError) error = NULL;
 	PkBitfield filters = 0;
+	guint i;
 
-	if (!pk_alpm_update_databases (job, 0, &error)) {
-		return pk_alpm_error_emit (job, error);
+	/* only take the transaction lock if the databases need syncing */
+	if (!pk_alpm_update_databases_are_fresh (job)) {
+		if (!pk_alpm_update_databases (job, 0, &error))
+			return pk_alpm_error_emit (job, error);
 	}
 
 	if (pk_backend_job_get_role (job) == PK_ROLE_ENUM_GET_UPDATES) {
 		g_variant_get (params, "(t)", &filters);
 	}
 
-	/* find outdated and replacement packages */
-	syncdbs = alpm_get_syncdbs (priv->alpm);
-	for (i = alpm_db_get_pkgcache (priv->localdb); i != NULL; i = i->next) {
-		PkInfoEnum info = PK_INFO_ENUM_NORMAL;
-		alpm_pkg_t *upgrade = pk_alpm_pkg_find_update (i->data, syncdbs);
-		if (upgrade == NULL)
-			continue;
+	/* dropped by pk_alpm_cache_clear() or a reload of localdb */
+	if (priv->updates == NULL) {
+		priv->updates = pk_alpm_update_find_updates (job);
+		if (priv->updates == NULL)
+			return;
+	}
+
+	for (i = 0; i < priv->updates->len; i++) {
+		PkAlpmUpdate *update = &g_array_index (priv->updates, PkAlpmUpdate, i);
+
 		if (pk_backend_job_is_cancelled (job))
 			break;
-		if (pk_alpm_pkg_is_ignorepkg (backend, upgrade)) {
-			info = PK_INFO_ENUM_BLOCKED;
-		} else if (pk_alpm_pkg_is_syncfirst (priv->syncfirsts, upgrade)) {
-			info = PK_INFO_ENUM_IMPORTANT;
-		}
 
 		/* want downloaded packages */
-		if (pk_bitfield_contain (filters, PK_FILTER_ENUM_DOWNLOADED) && !pk_alpm_update_is_pkg_downloaded (upgrade))
+		if (pk_bitfield_contain (filters, PK_FILTER_ENUM_DOWNLOADED) && !pk_alpm_update_is_pkg_downloaded (update->pkg))
 			continue;
 
 		/* don't want downloaded packages */
-		if (pk_bitfield_contain (filters, PK_FILTER_ENUM_NOT_DOWNLOADED) && pk_alpm_update_is_pkg_downloaded (upgrade))
+		if (pk_bitfield_contain (filters, PK_FILTER_ENUM_NOT_DOWNLOADED) && pk_alpm_update_is_pkg_downloaded (update->pkg))
 			continue;
 
-		pk_alpm_pkg_emit (job, upgrade, info);
+		pk_alpm_pkg_emit (job, update->pkg, update->info);
 	}
 }
 
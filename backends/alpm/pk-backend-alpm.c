@@ -28,6 +28,7 @@
 #include <pk-backend.h>
 
 #include "pk-backend-alpm.h"
+#include "pk-alpm-cache.h"
 #include "pk-alpm-config.h"
 #include "pk-alpm-databases.h"
 #include "pk-alpm-error.h"
@@ -145,6 +146,10 @@ pk_backend_initialize (GKeyFile *conf, PkBackend *backend)
 
 	priv = g_new0 (PkBackendAlpmPrivate, 1);
 	pk_backend_set_user_data (backend, priv);
+	if (conf != NULL)
+		priv->conf = g_key_file_ref (conf);
+	priv->applications = g_hash_table_new_full (g_str_hash, g_str_equal,
+						    g_free, NULL);
 
 	if (!pk_alpm_initialize (backend, &error))
 		g_error ("Failed to initialize alpm: %s", error->message);
@@ -175,6 +180,10 @@ pk_backend_destroy (PkBackend *backend)
 
 	FREELIST (priv->syncfirsts);
 	FREELIST (priv->holdpkgs);
+	pk_alpm_caches_invalidate (backend);
+	g_hash_table_unref (priv->applications);
+	if (priv->conf != NULL)
+		g_key_file_unref (priv->conf);
 	g_free (priv);
 }
 
@@ -203,8 +212,11 @@ pk_alpm_run (PkBackendJob *job, PkStatusEnum status, PkBackendJobThreadFunc func
 	g_return_if_fail (func != NULL);
 
 	if (priv->localdb_changed) {
+		g_autoptr(GKeyFile) conf = NULL;
+		if (priv->conf != NULL)
+			conf = g_key_file_ref (priv->conf);
 		pk_backend_destroy (backend);
-		pk_backend_initialize (NULL, backend);
+		pk_backend_initialize (conf, backend);
 		pk_backend_installed_db_changed (backend);
 	}
 
@@ -213,6 +225,12 @@ pk_alpm_run (PkBackendJob *job, PkStatusEnum status, PkBackendJobThreadFunc func
 	pk_backend_job_thread_create (job, func, data, NULL);
 }
 
+void
+pk_alpm_caches_invalidate (PkBackend *backend)
+{
+	pk_alpm_cache_clear (pk_backend_get_user_data (backend));
+}
+
 gboolean
 pk_alpm_finish (PkBackendJob *job, GError *error)
 {
@@ -34,9 +34,18 @@ typedef struct {
 	GFileMonitor    *monitor;
 	alpm_list_t     *configured_repos; /* list of configured repos */
 	gboolean	localdb_changed;
+	GHashTable	*applications;	/* name-version-db → is application */
+	GArray		*updates;	/* cached result of GetUpdates */
+	GHashTable	*indexes;	/* alpm_db_t → search index */
+	GHashTable	*satisfiers;	/* depend string → satisfier */
+	GHashTable	*depends;	/* name-version-db → satisfiers */
+	GHashTable	*requiredby;	/* name-version-db → requirer names */
+	GKeyFile	*conf;
 } PkBackendAlpmPrivate;
 
 void		 pk_alpm_run		(PkBackendJob *job, PkStatusEnum status,
 					 PkBackendJobThreadFunc func, gpointer data);
 
 gboolean	 pk_alpm_finish		(PkBackendJob *job, GError *error);
+
+void		 pk_alpm_caches_invalidate	(PkBackend *backend);
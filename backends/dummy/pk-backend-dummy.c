@@ -48,6 +48,7 @@ typedef struct {
 	gchar		**values;
 	PkBitfield	 filters;
 	gboolean	 fake_db_locked;
+	guint		 synthetic_size;
 } PkBackendDummyPrivate;
 
 typedef struct {
@@ -60,6 +61,360 @@ typedef struct {
 
 static PkBackendDummyPrivate *priv;
 
+
+/*
+ * Synthetic mode: a universe of synthetic_size generated packages, answered
+ * straight from memory so the daemon and the clients can be benchmarked
+ * without any backend overhead.
+ *
+ * Package i is named "synthetic<i>", every second one is installed, every
+ * tenth one has an update, and it depends on the packages i/2 and i/3.
+ */
+#define PK_DUMMY_SYNTHETIC_PREFIX	"synthetic"
+
+static const PkGroupEnum pk_dummy_synthetic_groups[] = {
+	PK_GROUP_ENUM_ACCESSIBILITY,
+	PK_GROUP_ENUM_GAMES,
+	PK_GROUP_ENUM_SYSTEM };
+
+/**
+ * pk_backend_synthetic_lookup:
+ *
+ * Returns the index of a package from its name or package-id, or -1.
+ */
+static gint
+pk_backend_synthetic_lookup (const gchar *value)
+{
+	const gchar *tmp;
+	gchar *endptr = NULL;
+	guint64 idx;
+
+	if (!g_str_has_prefix (value, PK_DUMMY_SYNTHETIC_PREFIX))
+		return -1;
+	tmp = value + strlen (PK_DUMMY_SYNTHETIC_PREFIX);
+	if (!g_ascii_isdigit (tmp[0]))
+		return -1;
+	idx = g_ascii_strtoull (tmp, &endptr, 10);
+	if (*endptr != '\0' && *endptr != ';')
+		return -1;
+	if (idx >= priv->synthetic_size)
+		return -1;
+	return (gint) idx;
+}
+
+static gboolean
+pk_backend_synthetic_is_installed (guint idx)
+{
+	return idx % 2 == 0;
+}
+
+static gboolean
+pk_backend_synthetic_has_update (guint idx)
+{
+	return idx % 10 == 0;
+}
+
+static gchar *
+pk_backend_synthetic_package_id (guint idx)
+{
+	if (pk_backend_synthetic_is_installed (idx))
+		return g_strdup_printf (PK_DUMMY_SYNTHETIC_PREFIX "%u;1.0-1;x86_64;installed", idx);
+	return g_strdup_printf (PK_DUMMY_SYNTHETIC_PREFIX "%u;1.0-1;x86_64;synthetic", idx);
+}
+
+static gchar **
+pk_backend_synthetic_files (guint idx)
+{
+	gchar **files = g_new0 (gchar *, 3);
+	files[0] = g_strdup_printf ("/usr/bin/" PK_DUMMY_SYNTHETIC_PREFIX "%u", idx);
+	files[1] = g_strdup_printf ("/usr/share/doc/" PK_DUMMY_SYNTHETIC_PREFIX "%u/README", idx);
+	return files;
+}
+
+/**
+ * pk_backend_synthetic_emit:
+ *
+ * Emits the package if it matches the installed filters.
+ */
+static void
+pk_backend_synthetic_emit (PkBackendJob *job, PkBitfield filters, guint idx)
+{
+	g_autofree gchar *package_id = NULL;
+	g_autofree gchar *summary = NULL;
+	gboolean installed = pk_backend_synthetic_is_installed (idx);
+
+	if (installed && pk_bitfield_contain (filters, PK_FILTER_ENUM_NOT_INSTALLED))
+		return;
+	if (!installed && pk_bitfield_contain (filters, PK_FILTER_ENUM_INSTALLED))
+		return;
+
+	package_id = pk_backend_synthetic_package_id (idx);
+	summary = g_strdup_printf ("Synthetic package %u", idx);
+	pk_backend_job_package (job,
+				installed ? PK_INFO_ENUM_INSTALLED : PK_INFO_ENUM_AVAILABLE,
+				package_id, summary);
+}
+
+/**
+ * pk_backend_synthetic_resolve:
+ *
+ * Resolve and WhatProvides only match exact names, so the index can be
+ * parsed from the value instead of looking at every package.
+ */
+static void
+pk_backend_synthetic_resolve (PkBackendJob *job, PkBitfield filters, gchar **values)
+{
+	guint i, j;
+	gint idx;
+
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	for (i = 0; values[i] != NULL; i++) {
+		idx = pk_backend_synthetic_lookup (values[i]);
+		if (idx < 0)
+			continue;
+
+		/* only emit each package once */
+		for (j = 0; j < i; j++) {
+			if (pk_backend_synthetic_lookup (values[j]) == idx)
+				break;
+		}
+		if (j == i)
+			pk_backend_synthetic_emit (job, filters, idx);
+	}
+	pk_backend_job_finished (job);
+}
+
+/**
+ * pk_backend_synthetic_search_thread:
+ */
+static void
+pk_backend_synthetic_search_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
+{
+	PkRoleEnum role = pk_backend_job_get_role (job);
+	PkBitfield filters;
+	gchar **values = NULL;
+	guint i, j;
+
+	if (role == PK_ROLE_ENUM_GET_PACKAGES)
+		g_variant_get (params, "(t)", &filters);
+	else
+		g_variant_get (params, "(t^a&s)", &filters, &values);
+
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	pk_backend_job_set_allow_cancel (job, TRUE);
+	for (i = 0; i < priv->synthetic_size; i++) {
+		g_autofree gchar *name = NULL;
+		g_auto(GStrv) files = NULL;
+		gboolean match = (values == NULL);
+
+		if (pk_backend_job_is_cancelled (job))
+			break;
+
+		name = g_strdup_printf (PK_DUMMY_SYNTHETIC_PREFIX "%u", i);
+		for (j = 0; values != NULL && values[j] != NULL && !match; j++) {
+			switch (role) {
+			case PK_ROLE_ENUM_SEARCH_NAME:
+			case PK_ROLE_ENUM_SEARCH_DETAILS:
+				match = strstr (name, values[j]) != NULL;
+				break;
+			case PK_ROLE_ENUM_SEARCH_FILE:
+				if (files == NULL)
+					files = pk_backend_synthetic_files (i);
+				match = g_strv_contains ((const gchar * const *) files, values[j]);
+				break;
+			case PK_ROLE_ENUM_SEARCH_GROUP:
+				match = pk_group_enum_from_string (values[j]) ==
+					pk_dummy_synthetic_groups[i % G_N_ELEMENTS (pk_dummy_synthetic_groups)];
+				break;
+			default:
+				break;
+			}
+		}
+		if (match)
+			pk_backend_synthetic_emit (job, filters, i);
+	}
+	g_free (values);
+}
+
+/**
+ * pk_backend_synthetic_search:
+ *
+ * Exact lookups are answered directly, everything else has to look at the
+ * whole universe and does that in a thread.
+ */
+static void
+pk_backend_synthetic_search (PkBackendJob *job, PkBitfield filters, gchar **values)
+{
+	switch (pk_backend_job_get_role (job)) {
+	case PK_ROLE_ENUM_RESOLVE:
+	case PK_ROLE_ENUM_WHAT_PROVIDES:
+		pk_backend_synthetic_resolve (job, filters, values);
+		break;
+	default:
+		pk_backend_job_thread_create (job, pk_backend_synthetic_search_thread, NULL, NULL);
+		break;
+	}
+}
+
+/**
+ * pk_backend_synthetic_get_details:
+ */
+static void
+pk_backend_synthetic_get_details (PkBackendJob *job, gchar **package_ids)
+{
+	guint i;
+	gint idx;
+
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	for (i = 0; package_ids[i] != NULL; i++) {
+		g_autofree gchar *summary = NULL;
+		g_autofree gchar *description = NULL;
+
+		idx = pk_backend_synthetic_lookup (package_ids[i]);
+		if (idx < 0)
+			continue;
+		summary = g_strdup_printf ("Synthetic package %i", idx);
+		description = g_strdup_printf ("Synthetic package %i, generated by the dummy backend.", idx);
+		pk_backend_job_details (job, package_ids[i], summary, "GPL2",
+					pk_dummy_synthetic_groups[idx % G_N_ELEMENTS (pk_dummy_synthetic_groups)],
+					description, "http://www.packagekit.org/", 1024 * (idx % 1024 + 1));
+	}
+	pk_backend_job_finished (job);
+}
+
+/**
+ * pk_backend_synthetic_get_files:
+ */
+static void
+pk_backend_synthetic_get_files (PkBackendJob *job, gchar **package_ids)
+{
+	guint i;
+	gint idx;
+
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	for (i = 0; package_ids[i] != NULL; i++) {
+		g_auto(GStrv) files = NULL;
+
+		idx = pk_backend_synthetic_lookup (package_ids[i]);
+		if (idx < 0)
+			continue;
+		files = pk_backend_synthetic_files (idx);
+		pk_backend_job_files (job, package_ids[i], files);
+	}
+	pk_backend_job_finished (job);
+}
+
+/**
+ * pk_backend_synthetic_get_updates:
+ */
+static void
+pk_backend_synthetic_get_updates (PkBackendJob *job)
+{
+	guint i;
+
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	for (i = 0; i < priv->synthetic_size; i++) {
+		g_autofree gchar *package_id = NULL;
+		g_autofree gchar *summary = NULL;
+
+		if (!pk_backend_synthetic_is_installed (i) || !pk_backend_synthetic_has_update (i))
+			continue;
+		package_id = g_strdup_printf (PK_DUMMY_SYNTHETIC_PREFIX "%u;1.0-2;x86_64;synthetic", i);
+		summary = g_strdup_printf ("Synthetic package %u", i);
+		pk_backend_job_package (job, PK_INFO_ENUM_NORMAL, package_id, summary);
+	}
+	pk_backend_job_finished (job);
+}
+
+/**
+ * pk_backend_synthetic_get_update_detail:
+ */
+static void
+pk_backend_synthetic_get_update_detail (PkBackendJob *job, gchar **package_ids)
+{
+	guint i;
+	gint idx;
+
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	for (i = 0; package_ids[i] != NULL; i++) {
+		g_autofree gchar *updates = NULL;
+		const gchar *to_array[] = { NULL, NULL };
+
+		idx = pk_backend_synthetic_lookup (package_ids[i]);
+		if (idx < 0 || !pk_backend_synthetic_has_update (idx))
+			continue;
+		updates = pk_backend_synthetic_package_id (idx);
+		to_array[0] = updates;
+		pk_backend_job_update_detail (job, package_ids[i],
+					      (gchar **) to_array,
+					      NULL, NULL, NULL, NULL,
+					      PK_RESTART_ENUM_NONE,
+					      "Synthetic update",
+					      NULL, PK_UPDATE_STATE_ENUM_STABLE,
+					      "2009-11-17T09:19:00", NULL);
+	}
+	pk_backend_job_finished (job);
+}
+
+/**
+ * pk_backend_synthetic_depends_add:
+ *
+ * Adds the direct dependencies (or reverse dependencies) of idx to the set.
+ */
+static void
+pk_backend_synthetic_depends_add (GHashTable *found, guint idx, gboolean reverse, gboolean recursive)
+{
+	guint deps[5];
+	guint i, n = 0;
+
+	if (!reverse) {
+		if (idx > 0) {
+			deps[n++] = idx / 2;
+			if (idx / 3 != idx / 2)
+				deps[n++] = idx / 3;
+		}
+	} else {
+		/* the packages j with j / 2 == idx or j / 3 == idx */
+		for (i = idx * 2; i <= idx * 3 + 2; i++) {
+			if (i > idx && i < priv->synthetic_size &&
+			    (i / 2 == idx || i / 3 == idx))
+				deps[n++] = i;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		if (!g_hash_table_add (found, GUINT_TO_POINTER (deps[i])))
+			continue;
+		if (recursive)
+			pk_backend_synthetic_depends_add (found, deps[i], reverse, recursive);
+	}
+}
+
+/**
+ * pk_backend_synthetic_depends:
+ */
+static void
+pk_backend_synthetic_depends (PkBackendJob *job, PkBitfield filters, gchar **package_ids,
+			      gboolean reverse, gboolean recursive)
+{
+	GHashTableIter iter;
+	gpointer key;
+	guint i;
+	gint idx;
+	g_autoptr(GHashTable) found = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
+	for (i = 0; package_ids[i] != NULL; i++) {
+		idx = pk_backend_synthetic_lookup (package_ids[i]);
+		if (idx >= 0)
+			pk_backend_synthetic_depends_add (found, idx, reverse, recursive);
+	}
+	g_hash_table_iter_init (&iter, found);
+	while (g_hash_table_iter_next (&iter, &key, NULL))
+		pk_backend_synthetic_emit (job, filters, GPOINTER_TO_UINT (key));
+	pk_backend_job_finished (job);
+}
+
 /**
  * pk_backend_initialize:
  */
@@ -72,6 +427,14 @@ pk_backend_initialize (GKeyFile *conf, PkBackend *backend)
 	priv->repo_enabled_devel = TRUE;
 	priv->repo_enabled_livna = TRUE;
 	priv->use_trusted = TRUE;
+
+	/* generate a large package universe for benchmarking */
+	if (conf != NULL)
+		priv->synthetic_size = g_key_file_get_integer (conf, "Daemon", "DummySyntheticPackages", NULL);
+	if (priv->synthetic_size > G_MAXINT)
+		priv->synthetic_size = 0;
+	if (priv->synthetic_size > 0)
+		g_debug ("using %u synthetic packages", priv->synthetic_size);
 }
 
 /**
@@ -164,6 +527,11 @@ pk_backend_cancel (PkBackend *backend, PkBackendJob *job)
 void
 pk_backend_depends_on (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **package_ids, gboolean recursive)
 {
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_depends (job, filters, package_ids, FALSE, recursive);
+		return;
+	}
+
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 
 	if (g_strcmp0 (package_ids[0], "scribus;1.3.4-1.fc8;i386;fedora") == 0) {
@@ -220,6 +588,11 @@ pk_backend_get_details (PkBackend *backend, PkBackendJob *job, gchar **package_i
 	guint len;
 	const gchar *package_id;
 
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_get_details (job, package_ids);
+		return;
+	}
+
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 	pk_backend_job_set_percentage (job, 0);
 
@@ -304,6 +677,11 @@ pk_backend_get_files (PkBackend *backend, PkBackendJob *job, gchar **package_ids
 	const gchar *package_id;
 	const gchar *to_strv[4];
 
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_get_files (job, package_ids);
+		return;
+	}
+
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 
 	len = g_strv_length (package_ids);
@@ -339,6 +717,11 @@ pk_backend_get_files (PkBackend *backend, PkBackendJob *job, gchar **package_ids
 void
 pk_backend_required_by (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **package_ids, gboolean recursive)
 {
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_depends (job, filters, package_ids, TRUE, recursive);
+		return;
+	}
+
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 	pk_backend_job_package (job, PK_INFO_ENUM_INSTALLED,
 				"glib2;2.14.0;i386;fedora", "The GLib library");
@@ -478,6 +861,12 @@ void
 pk_backend_get_update_detail (PkBackend *backend, PkBackendJob *job, gchar **package_ids)
 {
 	PkBackendDummyJobData *job_data = pk_backend_job_get_user_data (job);
+
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_get_update_detail (job, package_ids);
+		return;
+	}
+
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 	priv->package_ids = package_ids;
 	job_data->signal_timeout = g_timeout_add (500, pk_backend_get_update_detail_timeout, job);
@@ -526,6 +915,12 @@ void
 pk_backend_get_updates (PkBackend *backend, PkBackendJob *job, PkBitfield filters)
 {
 	PkBackendDummyJobData *job_data = pk_backend_job_get_user_data (job);
+
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_get_updates (job);
+		return;
+	}
+
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 	pk_backend_job_set_percentage (job, PK_BACKEND_PERCENTAGE_INVALID);
 	/* check network state */
@@ -627,10 +1022,17 @@ pk_backend_install_packages (PkBackend *backend, PkBackendJob *job, PkBitfield t
 		pk_backend_job_package (job, PK_INFO_ENUM_UPDATING,
 					"gtkhtml2;2.19.1-4.fc8;i386;fedora", "An HTML widget for GTK+ 2.0");
 
+		/* there is no real depsolve here, the package-ids just stand in
+		 * for one so the self tests can check the plan is handed over */
+		pk_backend_job_set_plan (job, g_strdupv (package_ids), (GDestroyNotify) g_strfreev);
 		pk_backend_job_finished (job);
 		return;
 	}
 
+	/* the simulate already did the depsolve */
+	if (pk_backend_job_get_plan (job) == NULL)
+		pk_backend_job_set_status (job, PK_STATUS_ENUM_DEP_RESOLVE);
+
 	if (g_strcmp0 (package_ids[0], "vips-doc;7.12.4-2.fc8;noarch;linva") == 0) {
 		if (priv->use_gpg && !priv->has_signature) {
 			pk_backend_job_repo_signature_required (job, package_ids[0], "updates",
@@ -895,6 +1297,11 @@ pk_backend_resolve_thread (PkBackendJob *job, GVariant *params, gpointer user_da
 void
 pk_backend_resolve (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **packages)
 {
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_search (job, filters, packages);
+		return;
+	}
+
 	pk_backend_job_thread_create (job, pk_backend_resolve_thread, NULL, NULL);
 }
 
@@ -948,6 +1355,11 @@ pk_backend_search_details_thread (PkBackendJob *job, GVariant *params, gpointer
 void
 pk_backend_search_details (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **values)
 {
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_search (job, filters, values);
+		return;
+	}
+
 	pk_backend_job_thread_create (job, pk_backend_search_details_thread, NULL, NULL);
 }
 
@@ -957,6 +1369,11 @@ pk_backend_search_details (PkBackend *backend, PkBackendJob *job, PkBitfield fil
 void
 pk_backend_search_files (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **values)
 {
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_search (job, filters, values);
+		return;
+	}
+
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 	pk_backend_job_set_allow_cancel (job, TRUE);
 	if (!pk_bitfield_contain (filters, PK_FILTER_ENUM_INSTALLED))
@@ -976,6 +1393,11 @@ pk_backend_search_files (PkBackend *backend, PkBackendJob *job, PkBitfield filte
 void
 pk_backend_search_groups (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **values)
 {
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_search (job, filters, values);
+		return;
+	}
+
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 	pk_backend_job_set_allow_cancel (job, TRUE);
 	pk_backend_job_package (job, PK_INFO_ENUM_AVAILABLE,
@@ -1048,6 +1470,11 @@ pk_backend_search_names_thread (PkBackendJob *job, GVariant *params, gpointer us
 void
 pk_backend_search_names (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **values)
 {
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_search (job, filters, values);
+		return;
+	}
+
 	pk_backend_job_set_percentage (job, PK_BACKEND_PERCENTAGE_INVALID);
 	pk_backend_job_set_allow_cancel (job, TRUE);
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
@@ -1561,6 +1988,12 @@ void
 pk_backend_what_provides (PkBackend *backend, PkBackendJob *job, PkBitfield filters, gchar **values)
 {
 	PkBackendDummyJobData *job_data = pk_backend_job_get_user_data (job);
+
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_search (job, filters, values);
+		return;
+	}
+
 	priv->values = values;
 	job_data->signal_timeout = g_timeout_add (200, pk_backend_what_provides_timeout, job);
 	priv->filters = filters;
@@ -1575,6 +2008,11 @@ pk_backend_what_provides (PkBackend *backend, PkBackendJob *job, PkBitfield filt
 void
 pk_backend_get_packages (PkBackend *backend, PkBackendJob *job, PkBitfield filters)
 {
+	if (priv->synthetic_size > 0) {
+		pk_backend_synthetic_search (job, filters, NULL);
+		return;
+	}
+
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_REQUEST);
 	pk_backend_job_package (job, PK_INFO_ENUM_INSTALLED,
 				"update1;2.19.1-4.fc8;i386;fedora",
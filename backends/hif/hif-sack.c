@@ -0,0 +1,73 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "hif-sack.h"
+
+/**
+ * hif_sack_flags_for_role:
+ *
+ * Returns the parts of the metadata a role needs on top of the primary
+ * data. Filelists are the largest part, so they are only loaded when the
+ * role looks at files or has to depsolve, as file dependencies cannot be
+ * resolved without them. DownloadPackages and RepairSystem never depsolve.
+ */
+HifSackAddFlags
+hif_sack_flags_for_role (PkRoleEnum role)
+{
+	HifSackAddFlags flags = HIF_SACK_ADD_FLAG_NONE;
+
+	switch (role) {
+	case PK_ROLE_ENUM_SEARCH_FILE:
+	case PK_ROLE_ENUM_GET_FILES:
+	case PK_ROLE_ENUM_REFRESH_CACHE:
+	case PK_ROLE_ENUM_GET_UPDATES:
+	case PK_ROLE_ENUM_INSTALL_PACKAGES:
+	case PK_ROLE_ENUM_INSTALL_FILES:
+	case PK_ROLE_ENUM_REMOVE_PACKAGES:
+	case PK_ROLE_ENUM_UPDATE_PACKAGES:
+	case PK_ROLE_ENUM_UPGRADE_SYSTEM:
+	case PK_ROLE_ENUM_REPO_REMOVE:
+		flags |= HIF_SACK_ADD_FLAG_FILELISTS;
+		break;
+	default:
+		break;
+	}
+
+	/* only load updateinfo when required */
+	if (role == PK_ROLE_ENUM_GET_UPDATE_DETAIL)
+		flags |= HIF_SACK_ADD_FLAG_UPDATEINFO;
+
+	/* only use unavailble packages for queries */
+	switch (role) {
+	case PK_ROLE_ENUM_RESOLVE:
+	case PK_ROLE_ENUM_SEARCH_NAME:
+	case PK_ROLE_ENUM_SEARCH_DETAILS:
+	case PK_ROLE_ENUM_SEARCH_FILE:
+	case PK_ROLE_ENUM_GET_DETAILS:
+		flags |= HIF_SACK_ADD_FLAG_UNAVAILABLE;
+		break;
+	default:
+		break;
+	}
+	return flags;
+}
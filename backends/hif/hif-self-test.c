@@ -0,0 +1,134 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <hawkey/goal.h>
+#include <hawkey/packagelist.h>
+#include <hawkey/query.h>
+#include <hawkey/repo.h>
+#include <hawkey/sack.h>
+#include <hawkey/version.h>
+
+#include "hif-sack.h"
+
+static void
+hif_test_sack_flags_func (void)
+{
+	/* roles which depsolve need the file provides */
+	g_assert (hif_sack_flags_for_role (PK_ROLE_ENUM_GET_UPDATES) & HIF_SACK_ADD_FLAG_FILELISTS);
+	g_assert (hif_sack_flags_for_role (PK_ROLE_ENUM_UPDATE_PACKAGES) & HIF_SACK_ADD_FLAG_FILELISTS);
+	g_assert (hif_sack_flags_for_role (PK_ROLE_ENUM_INSTALL_PACKAGES) & HIF_SACK_ADD_FLAG_FILELISTS);
+	g_assert (hif_sack_flags_for_role (PK_ROLE_ENUM_REMOVE_PACKAGES) & HIF_SACK_ADD_FLAG_FILELISTS);
+	g_assert (hif_sack_flags_for_role (PK_ROLE_ENUM_SEARCH_FILE) & HIF_SACK_ADD_FLAG_FILELISTS);
+
+	/* simple queries do not */
+	g_assert_cmpint (hif_sack_flags_for_role (PK_ROLE_ENUM_RESOLVE) & HIF_SACK_ADD_FLAG_FILELISTS, ==, 0);
+	g_assert_cmpint (hif_sack_flags_for_role (PK_ROLE_ENUM_SEARCH_NAME) & HIF_SACK_ADD_FLAG_FILELISTS, ==, 0);
+	g_assert_cmpint (hif_sack_flags_for_role (PK_ROLE_ENUM_DOWNLOAD_PACKAGES) & HIF_SACK_ADD_FLAG_FILELISTS, ==, 0);
+
+	/* only GetUpdateDetail needs the advisories */
+	g_assert (hif_sack_flags_for_role (PK_ROLE_ENUM_GET_UPDATE_DETAIL) & HIF_SACK_ADD_FLAG_UPDATEINFO);
+	g_assert_cmpint (hif_sack_flags_for_role (PK_ROLE_ENUM_GET_UPDATES) & HIF_SACK_ADD_FLAG_UPDATEINFO, ==, 0);
+}
+
+/**
+ * hif_test_depsolve:
+ *
+ * Depsolves installing foo, which requires a file that is only listed in
+ * the filelists of bar.
+ **/
+static gint
+hif_test_depsolve (HifSackAddFlags flags)
+{
+	gint rc;
+	HyGoal goal;
+	HyPackageList plist;
+	HyQuery query;
+	HyRepo repo;
+	HySack sack;
+	g_autofree gchar *cache_dir = NULL;
+	g_autofree gchar *filelists = NULL;
+	g_autofree gchar *primary = NULL;
+	g_autofree gchar *repomd = NULL;
+
+	cache_dir = g_dir_make_tmp ("hif-self-test-XXXXXX", NULL);
+	g_assert (cache_dir != NULL);
+#if HY_VERSION_CHECK(0,5,3)
+	sack = hy_sack_create (cache_dir, NULL, "/", NULL, HY_MAKE_CACHE_DIR);
+#else
+	sack = hy_sack_create (cache_dir, NULL, "/", HY_MAKE_CACHE_DIR);
+#endif
+	g_assert (sack != NULL);
+
+	repomd = g_build_filename (TESTDATADIR, "hif-repo", "repodata", "repomd.xml", NULL);
+	primary = g_build_filename (TESTDATADIR, "hif-repo", "repodata", "primary.xml", NULL);
+	filelists = g_build_filename (TESTDATADIR, "hif-repo", "repodata", "filelists.xml", NULL);
+	repo = hy_repo_create ("test");
+	hy_repo_set_string (repo, HY_REPO_MD_FN, repomd);
+	hy_repo_set_string (repo, HY_REPO_PRIMARY_FN, primary);
+	hy_repo_set_string (repo, HY_REPO_FILELISTS_FN, filelists);
+	rc = hy_sack_load_repo (sack, repo,
+				(flags & HIF_SACK_ADD_FLAG_FILELISTS) > 0 ? HY_LOAD_FILELISTS : 0);
+	g_assert_cmpint (rc, ==, 0);
+	hy_repo_free (repo);
+
+	query = hy_query_create (sack);
+	hy_query_filter (query, HY_PKG_NAME, HY_EQ, "foo");
+	plist = hy_query_run (query);
+	g_assert_cmpint (hy_packagelist_count (plist), ==, 1);
+
+	goal = hy_goal_create (sack);
+	hy_goal_install (goal, hy_packagelist_get (plist, 0));
+	rc = hy_goal_run (goal);
+
+	hy_goal_free (goal);
+	hy_packagelist_free (plist);
+	hy_query_free (query);
+	hy_sack_free (sack);
+	g_rmdir (cache_dir);
+	return rc;
+}
+
+static void
+hif_test_file_depends_func (void)
+{
+	/* the sack GetUpdates uses can resolve file dependencies */
+	g_assert_cmpint (hif_test_depsolve (hif_sack_flags_for_role (PK_ROLE_ENUM_GET_UPDATES)), ==, 0);
+
+	/* and this is why: without filelists the goal fails */
+	g_assert_cmpint (hif_test_depsolve (HIF_SACK_ADD_FLAG_NONE), !=, 0);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	/* tests go here */
+	g_test_add_func ("/hif/sack-flags", hif_test_sack_flags_func);
+	g_test_add_func ("/hif/file-depends", hif_test_file_depends_func);
+
+	return g_test_run ();
+}
@@ -56,18 +56,33 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(HifContext, g_object_unref)
 #include <librepo/librepo.h>
 
 #include "hif-backend.h"
+#include "hif-sack.h"
 
 typedef struct {
 	HySack		 sack;
 	gboolean	 valid;
 	gchar		*key;
+	gint		 refcount;
 } HifSackCacheItem;
 
+typedef struct {
+	HifSackCacheItem *cache_item;	/* the sack the goal points into */
+	HifTransaction	*transaction;
+	HyGoal		 goal;
+	guint		 generation;
+} HifPlan;
+
 typedef struct {
 	GKeyFile	*conf;
 	HifContext	*context;
 	GHashTable	*sack_cache;	/* of HifSackCacheItem */
 	GMutex		 sack_mutex;
+	GCond		 sack_cond;
+	guint		 sack_generation;
+	gchar		*sack_warming_key;
+	guint		 sack_builders;
+	GThread		*sack_warm_thread;
+	GMutex		 manifest_mutex;
 	GTimer		*repos_timer;
 } PkBackendHifPrivate;
 
@@ -79,6 +94,7 @@ typedef struct {
 	PkBackend	*backend;
 	PkBitfield	 transaction_flags;
 	HyGoal		 goal;
+	HifSackCacheItem *cache_item;	/* of the last sack the job got */
 } PkBackendHifJobData;
 
 /**
@@ -121,6 +137,7 @@ pk_backend_sack_cache_invalidate (PkBackend *backend, const gchar *why)
 
 	/* set all the cached sacks as invalid */
 	g_mutex_lock (&priv->sack_mutex);
+	priv->sack_generation++;
 	values = g_hash_table_get_values (priv->sack_cache);
 	for (l = values; l != NULL; l = l->next) {
 		cache_item = l->data;
@@ -143,16 +160,59 @@ pk_backend_hif_repos_changed_cb (HifRepos *self, PkBackend *backend)
 }
 
 /**
- * hif_sack_cache_item_free:
+ * hif_sack_cache_item_new:
+ */
+static HifSackCacheItem *
+hif_sack_cache_item_new (const gchar *key, HySack sack)
+{
+	HifSackCacheItem *cache_item;
+	cache_item = g_slice_new (HifSackCacheItem);
+	cache_item->key = g_strdup (key);
+	cache_item->sack = sack;
+	cache_item->valid = TRUE;
+	cache_item->refcount = 1;
+	return cache_item;
+}
+
+/**
+ * hif_sack_cache_item_ref:
+ */
+static HifSackCacheItem *
+hif_sack_cache_item_ref (HifSackCacheItem *cache_item)
+{
+	g_atomic_int_inc (&cache_item->refcount);
+	return cache_item;
+}
+
+/**
+ * hif_sack_cache_item_unref:
+ *
+ * The cache holds one reference, and a plan or a job can hold more so the
+ * sack stays alive after the cache has dropped it.
  */
 static void
-hif_sack_cache_item_free (HifSackCacheItem *cache_item)
+hif_sack_cache_item_unref (HifSackCacheItem *cache_item)
 {
+	if (!g_atomic_int_dec_and_test (&cache_item->refcount))
+		return;
 	hy_sack_free (cache_item->sack);
 	g_free (cache_item->key);
 	g_slice_free (HifSackCacheItem, cache_item);
 }
 
+/**
+ * hif_plan_free:
+ */
+static void
+hif_plan_free (HifPlan *plan)
+{
+	if (plan->goal != NULL)
+		hy_goal_free (plan->goal);
+	g_object_unref (plan->transaction);
+	hif_sack_cache_item_unref (plan->cache_item);
+	g_slice_free (HifPlan, plan);
+}
+
 /**
  * pk_backend_context_invalidate_cb:
  */
@@ -205,6 +265,8 @@ pk_backend_setup_hif_context (HifContext *context, GKeyFile *conf, const gchar *
 	return hif_context_setup (context, NULL, error);
 }
 
+static gpointer pk_backend_sack_warm_thread (gpointer user_data);
+
 /**
  * pk_backend_initialize:
  */
@@ -249,10 +311,12 @@ pk_backend_initialize (GKeyFile *conf, PkBackend *backend)
 	 *   modify state or if the repos or rpmdb are changed
 	 */
 	g_mutex_init (&priv->sack_mutex);
+	g_cond_init (&priv->sack_cond);
+	g_mutex_init (&priv->manifest_mutex);
 	priv->sack_cache = g_hash_table_new_full (g_str_hash,
 						  g_str_equal,
 						  g_free,
-						  (GDestroyNotify) hif_sack_cache_item_free);
+						  (GDestroyNotify) hif_sack_cache_item_unref);
 
 	priv->conf = g_key_file_ref (conf);
 
@@ -270,6 +334,11 @@ pk_backend_initialize (GKeyFile *conf, PkBackend *backend)
 			  G_CALLBACK (pk_backend_hif_repos_changed_cb), backend);
 
 	lr_global_init ();
+
+	/* packagekitd exits when idle, so load what we had last time */
+	priv->sack_warm_thread = g_thread_new ("hif-sack-warm",
+					       pk_backend_sack_warm_thread,
+					       backend);
 }
 
 /**
@@ -279,12 +348,16 @@ void
 pk_backend_destroy (PkBackend *backend)
 {
 	PkBackendHifPrivate *priv = pk_backend_get_user_data (backend);
+	if (priv->sack_warm_thread != NULL)
+		g_thread_join (priv->sack_warm_thread);
 	if (priv->conf != NULL)
 		g_key_file_unref (priv->conf);
 	if (priv->context != NULL)
 		g_object_unref (priv->context);
 	g_timer_destroy (priv->repos_timer);
 	g_mutex_clear (&priv->sack_mutex);
+	g_cond_clear (&priv->sack_cond);
+	g_mutex_clear (&priv->manifest_mutex);
 	g_hash_table_unref (priv->sack_cache);
 	g_free (priv);
 }
@@ -479,6 +552,8 @@ pk_backend_stop_job (PkBackend *backend, PkBackendJob *job)
 		g_ptr_array_unref (job_data->sources);
 	if (job_data->goal != NULL)
 		hy_goal_free (job_data->goal);
+	if (job_data->cache_item != NULL)
+		hif_sack_cache_item_unref (job_data->cache_item);
 	g_free (job_data);
 	pk_backend_job_set_user_data (job, NULL);
 }
@@ -500,56 +575,10 @@ pk_backend_ensure_sources (PkBackendHifJobData *job_data, GError **error)
 	return TRUE;
 }
 
-/**
- * hif_utils_add_remote:
- */
-static gboolean
-hif_utils_add_remote (PkBackendJob *job,
-		      HySack sack,
-		      HifSackAddFlags flags,
-		      HifState *state,
-		      GError **error)
-{
-	gboolean ret;
-	HifState *state_local;
-	PkBackendHifJobData *job_data = pk_backend_job_get_user_data (job);
-
-	/* set state */
-	ret = hif_state_set_steps (state, error,
-				   2, /* load files */
-				   98, /* add sources */
-				   -1);
-	if (!ret)
-		return FALSE;
-
-	/* set the list of repos */
-	if (!pk_backend_ensure_sources (job_data, error))
-		return FALSE;
-
-	/* done */
-	if (!hif_state_done (state, error))
-		return FALSE;
-
-	/* add each repo */
-	state_local = hif_state_get_child (state);
-	ret = hif_sack_add_sources (sack,
-				    job_data->sources,
-				    pk_backend_job_get_cache_age (job),
-				    flags,
-				    state_local,
-				    error);
-	if (!ret)
-		return FALSE;
-
-	/* done */
-	if (!hif_state_done (state, error))
-		return FALSE;
-	return TRUE;
-}
-
 typedef enum {
-	HIF_CREATE_SACK_FLAG_NONE,
-	HIF_CREATE_SACK_FLAG_USE_CACHE,
+	HIF_CREATE_SACK_FLAG_NONE	= 0,
+	HIF_CREATE_SACK_FLAG_USE_CACHE	= 1 << 0,
+	HIF_CREATE_SACK_FLAG_FILELISTS	= 1 << 1,
 	HIF_CREATE_SACK_FLAG_LAST
 } HifCreateSackFlags;
 
@@ -604,6 +633,408 @@ hif_utils_real_path (const gchar *path)
 	return real;
 }
 
+/**
+ * hif_utils_build_sack:
+ *
+ * Creates a new sack from the installed packages and, if requested, the
+ * remote sources. Any .solv caches in the solv dir are reused.
+ */
+static HySack
+hif_utils_build_sack (HifContext *context,
+		      GPtrArray *sources,
+		      HifSackAddFlags flags,
+		      guint cache_age,
+		      HifState *state,
+		      GError **error)
+{
+	gboolean ret;
+	gint rc;
+	HifState *state_local;
+	HySack sack = NULL;
+	g_autofree gchar *install_root = NULL;
+	g_autofree gchar *solv_dir = NULL;
+
+	/* set state */
+	if ((flags & HIF_SACK_ADD_FLAG_REMOTE) > 0) {
+		ret = hif_state_set_steps (state, error,
+					   8, /* add installed */
+					   92, /* add remote */
+					   -1);
+		if (!ret)
+			return NULL;
+	} else {
+		hif_state_set_number_steps (state, 1);
+	}
+
+	/* create empty sack */
+	solv_dir = hif_utils_real_path (hif_context_get_solv_dir (context));
+	install_root = hif_utils_real_path (hif_context_get_install_root (context));
+#if HY_VERSION_CHECK(0,5,3)
+	sack = hy_sack_create (solv_dir, NULL, install_root, NULL, HY_MAKE_CACHE_DIR);
+#else
+	sack = hy_sack_create (solv_dir, NULL, install_root, HY_MAKE_CACHE_DIR);
+#endif
+	if (sack == NULL) {
+		hif_error_set_from_hawkey (hy_get_errno (), error);
+		g_prefix_error (error, "failed to create sack in %s for %s: ",
+				hif_context_get_solv_dir (context),
+				hif_context_get_install_root (context));
+		return NULL;
+	}
+
+	/* add installed packages */
+	rc = hy_sack_load_system_repo (sack, NULL, HY_BUILD_CACHE);
+	ret = hif_error_set_from_hawkey (rc, error);
+	if (!ret) {
+		g_prefix_error (error, "Failed to load system repo: ");
+		goto out;
+	}
+
+	/* done */
+	ret = hif_state_done (state, error);
+	if (!ret)
+		goto out;
+
+	/* add remote packages */
+	if ((flags & HIF_SACK_ADD_FLAG_REMOTE) > 0) {
+		state_local = hif_state_get_child (state);
+		ret = hif_sack_add_sources (sack,
+					    sources,
+					    cache_age,
+					    flags,
+					    state_local,
+					    error);
+		if (!ret)
+			goto out;
+
+		/* done */
+		ret = hif_state_done (state, error);
+		if (!ret)
+			goto out;
+	}
+
+	/* creates repo for command line rpms */
+	hy_sack_create_cmdline_repo (sack);
+out:
+	if (!ret) {
+		hy_sack_free (sack);
+		return NULL;
+	}
+	return sack;
+}
+
+/**
+ * hif_sack_manifest_get_filename:
+ */
+static gchar *
+hif_sack_manifest_get_filename (HifContext *context)
+{
+	return g_build_filename (hif_context_get_solv_dir (context),
+				 "packagekit-sacks.conf", NULL);
+}
+
+/**
+ * hif_sack_manifest_get_stamp:
+ *
+ * Returns a string that changes whenever the file is rewritten, or
+ * %NULL if it does not exist.
+ */
+static gchar *
+hif_sack_manifest_get_stamp (const gchar *filename)
+{
+	GStatBuf buf;
+	if (g_stat (filename, &buf) != 0)
+		return NULL;
+	return g_strdup_printf ("%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT,
+				(gint64) buf.st_mtime, (gint64) buf.st_size);
+}
+
+/**
+ * hif_sack_manifest_get_system_stamp:
+ */
+static gchar *
+hif_sack_manifest_get_system_stamp (HifContext *context)
+{
+	g_autofree gchar *rpmdb = NULL;
+	rpmdb = g_build_filename (hif_context_get_install_root (context),
+				  "var/lib/rpm/Packages", NULL);
+	return hif_sack_manifest_get_stamp (rpmdb);
+}
+
+/**
+ * hif_sack_manifest_get_source_stamp:
+ *
+ * Covers the .solv cache and the .solvx extension caches for the
+ * filelists, updateinfo and deltas, missing ones included.
+ */
+static gchar *
+hif_sack_manifest_get_source_stamp (HifContext *context, HifSource *src)
+{
+	guint i;
+	const gchar *suffixes[] = { ".solv",
+				    "-filenames.solvx",
+				    "-updateinfo.solvx",
+				    "-presto.solvx",
+				    NULL };
+	GString *str = g_string_new (NULL);
+
+	for (i = 0; suffixes[i] != NULL; i++) {
+		g_autofree gchar *basename = NULL;
+		g_autofree gchar *filename = NULL;
+		g_autofree gchar *stamp = NULL;
+		basename = g_strdup_printf ("%s%s", hif_source_get_id (src), suffixes[i]);
+		filename = g_build_filename (hif_context_get_solv_dir (context), basename, NULL);
+		stamp = hif_sack_manifest_get_stamp (filename);
+
+		/* the sack cannot have been built without the main cache */
+		if (i == 0 && stamp == NULL) {
+			g_string_free (str, TRUE);
+			return NULL;
+		}
+		if (str->len > 0)
+			g_string_append_c (str, ',');
+		g_string_append (str, stamp != NULL ? stamp : "-");
+	}
+	return g_string_free (str, FALSE);
+}
+
+/**
+ * hif_sack_manifest_add:
+ *
+ * Records that a sack with these flags was built from the .solv caches
+ * as they are now, so that it can be rebuilt before the first query the
+ * next time the backend is loaded.
+ */
+static void
+hif_sack_manifest_add (PkBackendHifPrivate *priv,
+		       HifContext *context,
+		       GPtrArray *sources,
+		       const gchar *cache_key,
+		       HifSackAddFlags flags)
+{
+	guint i;
+	HifSource *src;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GKeyFile) manifest = NULL;
+	g_autoptr(GPtrArray) ids = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autofree gchar *system_stamp = NULL;
+
+	system_stamp = hif_sack_manifest_get_system_stamp (context);
+	if (system_stamp == NULL)
+		return;
+
+	/* concurrent jobs must not lose each other's changes */
+	g_mutex_lock (&priv->manifest_mutex);
+	filename = hif_sack_manifest_get_filename (context);
+	manifest = g_key_file_new ();
+	g_key_file_load_from_file (manifest, filename, G_KEY_FILE_NONE, NULL);
+	g_key_file_remove_group (manifest, cache_key, NULL);
+	g_key_file_set_integer (manifest, cache_key, "Flags", flags);
+	g_key_file_set_string (manifest, cache_key, "System", system_stamp);
+	g_key_file_set_int64 (manifest, cache_key, "LastUsed", g_get_real_time ());
+
+	/* save the state of each .solv cache we loaded */
+	ids = g_ptr_array_new ();
+	for (i = 0; sources != NULL && i < sources->len; i++) {
+		g_autofree gchar *stamp = NULL;
+		src = g_ptr_array_index (sources, i);
+		if (hif_source_get_enabled (src) == HIF_SOURCE_ENABLED_NONE)
+			continue;
+		stamp = hif_sack_manifest_get_source_stamp (context, src);
+		if (stamp == NULL)
+			continue;
+		g_key_file_set_string (manifest, cache_key,
+				       hif_source_get_id (src), stamp);
+		g_ptr_array_add (ids, (gpointer) hif_source_get_id (src));
+	}
+	g_key_file_set_string_list (manifest, cache_key, "Sources",
+				    (const gchar * const *) ids->pdata, ids->len);
+
+	if (!g_key_file_save_to_file (manifest, filename, &error))
+		g_debug ("failed to save sack manifest: %s", error->message);
+	g_mutex_unlock (&priv->manifest_mutex);
+}
+
+/**
+ * hif_sack_manifest_check:
+ *
+ * Returns %TRUE if the sack recorded in @group can be rebuilt from the
+ * .solv caches exactly as they were when it was last used. An enabled
+ * source without a .solv cache is new or was never loaded, so the
+ * sack would not be the same either.
+ */
+static gboolean
+hif_sack_manifest_check (HifContext *context,
+			 GPtrArray *sources,
+			 GKeyFile *manifest,
+			 const gchar *group)
+{
+	guint i;
+	guint enabled = 0;
+	HifSource *src;
+	g_auto(GStrv) ids = NULL;
+	g_autofree gchar *system_stamp = NULL;
+	g_autofree gchar *system_saved = NULL;
+
+	/* rpmdb changed */
+	system_stamp = hif_sack_manifest_get_system_stamp (context);
+	system_saved = g_key_file_get_string (manifest, group, "System", NULL);
+	if (system_stamp == NULL || g_strcmp0 (system_stamp, system_saved) != 0)
+		return FALSE;
+
+	/* all the enabled sources have to match */
+	ids = g_key_file_get_string_list (manifest, group, "Sources", NULL, NULL);
+	if (ids == NULL)
+		return FALSE;
+	for (i = 0; i < sources->len; i++) {
+		g_autofree gchar *stamp = NULL;
+		g_autofree gchar *saved = NULL;
+		src = g_ptr_array_index (sources, i);
+		if (hif_source_get_enabled (src) == HIF_SOURCE_ENABLED_NONE)
+			continue;
+		stamp = hif_sack_manifest_get_source_stamp (context, src);
+		if (stamp == NULL)
+			return FALSE;
+		saved = g_key_file_get_string (manifest, group,
+					       hif_source_get_id (src), NULL);
+		if (g_strcmp0 (stamp, saved) != 0)
+			return FALSE;
+		enabled++;
+	}
+	return enabled == g_strv_length (ids);
+}
+
+/**
+ * pk_backend_sack_warm_thread:
+ *
+ * Rebuilds the sack used last before the backend was unloaded, so
+ * that the first query does not have to wait for it. Any other sack is
+ * built on demand as usual.
+ */
+static gpointer
+pk_backend_sack_warm_thread (gpointer user_data)
+{
+	gboolean ret;
+	gint64 last_used = G_MININT64;
+	gsize i;
+	gsize len;
+	guint generation;
+	const gchar *group = NULL;
+	HifSackAddFlags flags;
+	HifSackCacheItem *cache_item;
+	HifState *state;
+	HySack sack;
+	PkBackend *backend = PK_BACKEND (user_data);
+	PkBackendHifPrivate *priv = pk_backend_get_user_data (backend);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GKeyFile) manifest = NULL;
+	g_autoptr(GPtrArray) sources = NULL;
+	g_autoptr(HifContext) context = NULL;
+	g_auto(GStrv) groups = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autofree gchar *release_ver = NULL;
+
+	g_mutex_lock (&priv->sack_mutex);
+	generation = priv->sack_generation;
+	g_mutex_unlock (&priv->sack_mutex);
+
+	/* the context in priv belongs to the jobs */
+	release_ver = pk_get_distro_version_id (&error);
+	if (release_ver == NULL) {
+		g_debug ("not warming sacks: %s", error->message);
+		return NULL;
+	}
+	context = hif_context_new ();
+	if (!pk_backend_setup_hif_context (context, priv->conf, release_ver, &error)) {
+		g_debug ("not warming sacks: %s", error->message);
+		return NULL;
+	}
+
+	/* nothing saved */
+	g_mutex_lock (&priv->manifest_mutex);
+	filename = hif_sack_manifest_get_filename (context);
+	manifest = g_key_file_new ();
+	ret = g_key_file_load_from_file (manifest, filename, G_KEY_FILE_NONE, NULL);
+	g_mutex_unlock (&priv->manifest_mutex);
+	if (!ret)
+		return NULL;
+
+	/* media repos could disappear at any time */
+	if (hif_repos_has_removable (hif_context_get_repos (context)))
+		return NULL;
+	sources = hif_repos_get_sources (hif_context_get_repos (context), &error);
+	if (sources == NULL) {
+		g_debug ("not warming sacks: %s", error->message);
+		return NULL;
+	}
+
+	/* only the most recently used one */
+	groups = g_key_file_get_groups (manifest, &len);
+	for (i = 0; i < len; i++) {
+		gint64 tmp = g_key_file_get_int64 (manifest, groups[i], "LastUsed", NULL);
+		if (group == NULL || tmp > last_used) {
+			group = groups[i];
+			last_used = tmp;
+		}
+	}
+	if (group == NULL)
+		return NULL;
+	if (!hif_sack_manifest_check (context, sources, manifest, group)) {
+		g_debug ("not warming %s as caches changed", group);
+		return NULL;
+	}
+	flags = g_key_file_get_integer (manifest, group, "Flags", NULL);
+
+	/* building writes @System.solv, so wait for any job doing that, and
+	 * queries for this sack wait for us rather than building it too */
+	g_mutex_lock (&priv->sack_mutex);
+	while (priv->sack_builders > 0)
+		g_cond_wait (&priv->sack_cond, &priv->sack_mutex);
+	if (generation != priv->sack_generation ||
+	    g_hash_table_contains (priv->sack_cache, group)) {
+		g_mutex_unlock (&priv->sack_mutex);
+		return NULL;
+	}
+	priv->sack_warming_key = g_strdup (group);
+	g_mutex_unlock (&priv->sack_mutex);
+
+	state = hif_state_new ();
+	sack = hif_utils_build_sack (context, sources, flags,
+				     G_MAXUINT, state, &error);
+	g_object_unref (state);
+
+	g_mutex_lock (&priv->sack_mutex);
+	if (sack == NULL) {
+		g_debug ("failed to warm %s: %s", group, error->message);
+	} else if (generation != priv->sack_generation) {
+		/* something changed while we were loading */
+		hy_sack_free (sack);
+	} else {
+		cache_item = hif_sack_cache_item_new (group, sack);
+		g_debug ("warmed cached sack %s", cache_item->key);
+		g_hash_table_insert (priv->sack_cache, g_strdup (group), cache_item);
+	}
+	g_clear_pointer (&priv->sack_warming_key, g_free);
+	g_cond_broadcast (&priv->sack_cond);
+	g_mutex_unlock (&priv->sack_mutex);
+	return NULL;
+}
+
+/**
+ * hif_utils_set_job_cache_item:
+ *
+ * Remembers which cached sack the job is using, so a plan can keep it.
+ */
+static void
+hif_utils_set_job_cache_item (PkBackendHifJobData *job_data,
+			      HifSackCacheItem *cache_item)
+{
+	if (job_data->cache_item != NULL)
+		hif_sack_cache_item_unref (job_data->cache_item);
+	job_data->cache_item = hif_sack_cache_item_ref (cache_item);
+}
+
 /**
  * hif_utils_create_sack_for_filters:
  */
@@ -615,39 +1046,24 @@ hif_utils_create_sack_for_filters (PkBackendJob *job,
 				   GError **error)
 {
 	gboolean ret;
-	gint rc;
-	HifSackAddFlags flags = HIF_SACK_ADD_FLAG_FILELISTS;
+	HifSackAddFlags flags = HIF_SACK_ADD_FLAG_NONE;
 	HifSackCacheItem *cache_item = NULL;
-	HifState *state_local;
 	HySack sack = NULL;
 	PkBackend *backend = pk_backend_job_get_backend (job);
 	PkBackendHifJobData *job_data = pk_backend_job_get_user_data (job);
 	PkBackendHifPrivate *priv = pk_backend_get_user_data (backend);
 	g_autofree gchar *cache_key = NULL;
-	g_autofree gchar *install_root = NULL;
-	g_autofree gchar *solv_dir = NULL;
+	g_autofree gchar *cache_key_filelists = NULL;
+
+	/* filelists, updateinfo and unavailable packages as the role needs */
+	flags = hif_sack_flags_for_role (pk_backend_job_get_role (job));
+	if ((create_flags & HIF_CREATE_SACK_FLAG_FILELISTS) > 0)
+		flags |= HIF_SACK_ADD_FLAG_FILELISTS;
 
 	/* don't add if we're going to filter out anyway */
 	if (!pk_bitfield_contain (filters, PK_FILTER_ENUM_INSTALLED))
 		flags |= HIF_SACK_ADD_FLAG_REMOTE;
 
-	/* only load updateinfo when required */
-	if (pk_backend_job_get_role (job) == PK_ROLE_ENUM_GET_UPDATE_DETAIL)
-		flags |= HIF_SACK_ADD_FLAG_UPDATEINFO;
-
-	/* only use unavailble packages for queries */
-	switch (pk_backend_job_get_role (job)) {
-	case PK_ROLE_ENUM_RESOLVE:
-	case PK_ROLE_ENUM_SEARCH_NAME:
-	case PK_ROLE_ENUM_SEARCH_DETAILS:
-	case PK_ROLE_ENUM_SEARCH_FILE:
-	case PK_ROLE_ENUM_GET_DETAILS:
-		flags |= HIF_SACK_ADD_FLAG_UNAVAILABLE;
-		break;
-	default:
-		break;
-	}
-
 	/* media repos could disappear at any time */
 	if ((create_flags & HIF_CREATE_SACK_FLAG_USE_CACHE) > 0 &&
 	    hif_repos_has_removable (hif_context_get_repos (job_data->context)) &&
@@ -666,14 +1082,36 @@ hif_utils_create_sack_for_filters (PkBackendJob *job,
 
 	/* do we have anything in the cache */
 	cache_key = hif_utils_create_cache_key (hif_context_get_release_ver (job_data->context), flags);
+	cache_key_filelists = hif_utils_create_cache_key (hif_context_get_release_ver (job_data->context),
+							  flags | HIF_SACK_ADD_FLAG_FILELISTS);
 	if ((create_flags & HIF_CREATE_SACK_FLAG_USE_CACHE) > 0) {
 		g_mutex_lock (&priv->sack_mutex);
+
+		/* the sack from the last run may be loading right now */
+		while (g_strcmp0 (priv->sack_warming_key, cache_key) == 0 ||
+		       g_strcmp0 (priv->sack_warming_key, cache_key_filelists) == 0)
+			g_cond_wait (&priv->sack_cond, &priv->sack_mutex);
+
+		/* a sack with filelists is just as good if it's valid */
+		if ((flags & HIF_SACK_ADD_FLAG_FILELISTS) == 0) {
+			cache_item = g_hash_table_lookup (priv->sack_cache, cache_key_filelists);
+			if (cache_item != NULL && cache_item->valid) {
+				ret = TRUE;
+				g_debug ("using cached sack %s", cache_key_filelists);
+				sack = cache_item->sack;
+				hif_utils_set_job_cache_item (job_data, cache_item);
+				g_mutex_unlock (&priv->sack_mutex);
+				goto out;
+			}
+		}
+
 		cache_item = g_hash_table_lookup (priv->sack_cache, cache_key);
 		if (cache_item != NULL && cache_item->sack != NULL) {
 			if (cache_item->valid) {
 				ret = TRUE;
 				g_debug ("using cached sack %s", cache_key);
 				sack = cache_item->sack;
+				hif_utils_set_job_cache_item (job_data, cache_item);
 				g_mutex_unlock (&priv->sack_mutex);
 				goto out;
 			} else {
@@ -688,78 +1126,55 @@ hif_utils_create_sack_for_filters (PkBackendJob *job,
 	/* update status */
 	hif_state_action_start (state, HIF_STATE_ACTION_QUERY, NULL);
 
-	/* set state */
+	/* set the list of repos */
 	if ((flags & HIF_SACK_ADD_FLAG_REMOTE) > 0) {
-		ret = hif_state_set_steps (state, error,
-					   8, /* add installed */
-					   92, /* add remote */
-					   -1);
+		ret = pk_backend_ensure_sources (job_data, error);
 		if (!ret)
 			goto out;
-	} else {
-		hif_state_set_number_steps (state, 1);
 	}
 
-	/* create empty sack */
-	solv_dir = hif_utils_real_path (hif_context_get_solv_dir (job_data->context));
-	install_root = hif_utils_real_path (hif_context_get_install_root (job_data->context));
-#if HY_VERSION_CHECK(0,5,3)
-	sack = hy_sack_create (solv_dir, NULL, install_root, NULL, HY_MAKE_CACHE_DIR);
-#else
-	sack = hy_sack_create (solv_dir, NULL, install_root, HY_MAKE_CACHE_DIR);
-#endif
-	if (sack == NULL) {
-		ret = hif_error_set_from_hawkey (hy_get_errno (), error);
-		g_prefix_error (error, "failed to create sack in %s for %s: ",
-				hif_context_get_solv_dir (job_data->context),
-				hif_context_get_install_root (job_data->context));
-		goto out;
-	}
+	/* the warm thread writes the same caches */
+	g_mutex_lock (&priv->sack_mutex);
+	while (priv->sack_warming_key != NULL)
+		g_cond_wait (&priv->sack_cond, &priv->sack_mutex);
+	priv->sack_builders++;
+	g_mutex_unlock (&priv->sack_mutex);
 
-	/* add installed packages */
-	rc = hy_sack_load_system_repo (sack, NULL, HY_BUILD_CACHE);
-	ret = hif_error_set_from_hawkey (rc, error);
-	if (!ret) {
-		g_prefix_error (error, "Failed to load system repo: ");
-		goto out;
-	}
+	sack = hif_utils_build_sack (job_data->context,
+				     job_data->sources,
+				     flags,
+				     pk_backend_job_get_cache_age (job),
+				     state,
+				     error);
 
-	/* done */
-	ret = hif_state_done (state, error);
-	if (!ret)
+	g_mutex_lock (&priv->sack_mutex);
+	priv->sack_builders--;
+	g_cond_broadcast (&priv->sack_cond);
+	g_mutex_unlock (&priv->sack_mutex);
+	if (sack == NULL) {
+		ret = FALSE;
 		goto out;
-
-	/* add remote packages */
-	if ((flags & HIF_SACK_ADD_FLAG_REMOTE) > 0) {
-		state_local = hif_state_get_child (state);
-		ret = hif_utils_add_remote (job, sack, flags,
-					    state_local, error);
-		if (!ret)
-			goto out;
-
-		/* done */
-		ret = hif_state_done (state, error);
-		if (!ret)
-			goto out;
 	}
 
-	/* creates repo for command line rpms */
-	hy_sack_create_cmdline_repo (sack);
-
-	/* save in cache */
+	/* save in cache, replacing the sack without filelists as this
+	 * one can be used in its place */
 	g_mutex_lock (&priv->sack_mutex);
-	cache_item = g_slice_new (HifSackCacheItem);
-	cache_item->key = g_strdup (cache_key);
-	cache_item->sack = sack;
-	cache_item->valid = TRUE;
+	if ((flags & HIF_SACK_ADD_FLAG_FILELISTS) > 0) {
+		g_autofree gchar *cache_key_nofilelists = NULL;
+		cache_key_nofilelists = hif_utils_create_cache_key (hif_context_get_release_ver (job_data->context),
+								    flags & ~HIF_SACK_ADD_FLAG_FILELISTS);
+		g_hash_table_remove (priv->sack_cache, cache_key_nofilelists);
+	}
+	cache_item = hif_sack_cache_item_new (cache_key, sack);
 	g_debug ("created cached sack %s", cache_item->key);
 	g_hash_table_insert (priv->sack_cache, g_strdup (cache_key), cache_item);
+	hif_utils_set_job_cache_item (job_data, cache_item);
 	g_mutex_unlock (&priv->sack_mutex);
+
+	/* remember it for the next time we're loaded */
+	if ((flags & HIF_SACK_ADD_FLAG_REMOTE) > 0)
+		hif_sack_manifest_add (priv, job_data->context, job_data->sources, cache_key, flags);
 out:
-	if (!ret && sack != NULL) {
-		hy_sack_free (sack);
-		sack = NULL;
-	}
 	return sack;
 }
 
@@ -903,6 +1318,8 @@ pk_backend_search_thread (PkBackendJob *job, GVariant *params, gpointer user_dat
 {
 	gboolean ret;
 	gchar **search_tmp;
+	guint i;
+	HifCreateSackFlags create_flags = HIF_CREATE_SACK_FLAG_USE_CACHE;
 	HifDb *db;
 	HifState *state_local;
 	HyPackageList installs = NULL;
@@ -939,6 +1356,12 @@ pk_backend_search_thread (PkBackendJob *job, GVariant *params, gpointer user_dat
 			pk_backend_job_error_code (job, error->code, "%s", error->message);
 			goto out;
 		}
+
+		/* file provides need the filelists */
+		for (i = 0; search_tmp[i] != NULL; i++) {
+			if (search_tmp[i][0] == '/')
+				create_flags |= HIF_CREATE_SACK_FLAG_FILELISTS;
+		}
 		break;
 	default:
 		g_variant_get (params, "(t^as)", &filters, &search);
@@ -956,7 +1379,7 @@ pk_backend_search_thread (PkBackendJob *job, GVariant *params, gpointer user_dat
 	state_local = hif_state_get_child (job_data->state);
 	sack = hif_utils_create_sack_for_filters (job,
 						  filters,
-						  HIF_CREATE_SACK_FLAG_USE_CACHE,
+						  create_flags,
 						  state_local,
 						  &error);
 	if (sack == NULL) {
@@ -1013,7 +1436,6 @@ pk_backend_search_thread (PkBackendJob *job, GVariant *params, gpointer user_dat
 		/* add any packages marked for install */
 		installs = hy_goal_list_installs (job_data->goal);
 		if (installs != NULL) {
-			guint i;
 			HyPackage pkg;
 
 			FOR_PACKAGELIST(pkg, installs, i) {
@@ -1057,7 +1479,6 @@ pk_backend_search_thread (PkBackendJob *job, GVariant *params, gpointer user_dat
 
 	/* FIXME: actually get the right update severity */
 	if (pk_backend_job_get_role (job) == PK_ROLE_ENUM_GET_UPDATES) {
-		guint i;
 		HyPackage pkg;
 		HyAdvisory advisory;
 		HyAdvisoryType type;
@@ -1530,6 +1951,155 @@ pk_backend_refresh_source (PkBackendJob *job,
 	return hif_state_done (state, error);
 }
 
+typedef struct {
+	PkBackendJob	*job;
+	gboolean	 force;
+	GMutex		 mutex;
+	GCond		 cond;
+	guint		*percentages;
+	guint		 pending;
+	GError		*error;
+} PkBackendHifRefreshHelper;
+
+typedef struct {
+	PkBackendHifRefreshHelper *helper;
+	HifSource	*src;
+	guint		 idx;
+} PkBackendHifRefreshItem;
+
+/**
+ * pk_backend_refresh_source_percentage_cb:
+ */
+static void
+pk_backend_refresh_source_percentage_cb (HifState *state,
+					 guint percentage,
+					 PkBackendHifRefreshItem *item)
+{
+	PkBackendHifRefreshHelper *helper = item->helper;
+	g_mutex_lock (&helper->mutex);
+	helper->percentages[item->idx] = percentage;
+	g_cond_signal (&helper->cond);
+	g_mutex_unlock (&helper->mutex);
+}
+
+/**
+ * pk_backend_refresh_source_thread:
+ *
+ * Refreshes one source from the thread pool. Each source gets its own
+ * HifState as they are not thread safe; the progress is aggregated by
+ * the job thread.
+ */
+static void
+pk_backend_refresh_source_thread (gpointer data, gpointer user_data)
+{
+	gboolean ret = TRUE;
+	gboolean skip;
+	HifState *state;
+	PkBackendHifRefreshItem *item = data;
+	PkBackendHifRefreshHelper *helper = user_data;
+	GError *error_local = NULL;
+
+	/* another source already failed */
+	g_mutex_lock (&helper->mutex);
+	skip = helper->error != NULL;
+	g_mutex_unlock (&helper->mutex);
+
+	state = hif_state_new ();
+	hif_state_set_cancellable (state, pk_backend_job_get_cancellable (helper->job));
+	g_signal_connect (state, "percentage-changed",
+			  G_CALLBACK (pk_backend_refresh_source_percentage_cb),
+			  item);
+
+	/* delete content even if up to date */
+	if (!skip && helper->force) {
+		g_debug ("Deleting contents of %s as forced", hif_source_get_id (item->src));
+		ret = hif_source_clean (item->src, &error_local);
+	}
+
+	/* check and download */
+	if (!skip && ret)
+		ret = pk_backend_refresh_source (helper->job, item->src, state, &error_local);
+	g_object_unref (state);
+
+	g_mutex_lock (&helper->mutex);
+	helper->percentages[item->idx] = 100;
+	if (!ret && helper->error == NULL)
+		helper->error = error_local;
+	else
+		g_clear_error (&error_local);
+	helper->pending--;
+	g_cond_signal (&helper->cond);
+	g_mutex_unlock (&helper->mutex);
+	g_free (item);
+}
+
+/**
+ * pk_backend_refresh_sources:
+ *
+ * Refreshes the sources using up to MaxParallelDownloads threads.
+ */
+static gboolean
+pk_backend_refresh_sources (PkBackendJob *job,
+			    GPtrArray *sources,
+			    gboolean force,
+			    HifState *state,
+			    GError **error)
+{
+	gint max_threads;
+	guint i;
+	guint percentage;
+	GThreadPool *pool;
+	PkBackend *backend = pk_backend_job_get_backend (job);
+	PkBackendHifPrivate *priv = pk_backend_get_user_data (backend);
+	PkBackendHifRefreshHelper helper;
+
+	max_threads = g_key_file_get_integer (priv->conf, "Daemon", "MaxParallelDownloads", NULL);
+	if (max_threads <= 0)
+		max_threads = 4;
+
+	memset (&helper, 0, sizeof (PkBackendHifRefreshHelper));
+	helper.job = job;
+	helper.force = force;
+	helper.percentages = g_new0 (guint, sources->len);
+	helper.pending = sources->len;
+	g_mutex_init (&helper.mutex);
+	g_cond_init (&helper.cond);
+
+	hif_state_action_start (state, HIF_STATE_ACTION_DOWNLOAD_METADATA, NULL);
+	pool = g_thread_pool_new (pk_backend_refresh_source_thread,
+				  &helper, MIN ((guint) max_threads, sources->len),
+				  TRUE, NULL);
+	for (i = 0; i < sources->len; i++) {
+		PkBackendHifRefreshItem *item = g_new0 (PkBackendHifRefreshItem, 1);
+		item->helper = &helper;
+		item->src = g_ptr_array_index (sources, i);
+		item->idx = i;
+		g_thread_pool_push (pool, item, NULL);
+	}
+
+	/* report the average of all the sources */
+	g_mutex_lock (&helper.mutex);
+	while (helper.pending > 0) {
+		g_cond_wait (&helper.cond, &helper.mutex);
+		for (i = 0, percentage = 0; i < sources->len; i++)
+			percentage += helper.percentages[i];
+		g_mutex_unlock (&helper.mutex);
+		hif_state_set_percentage (state, percentage / sources->len);
+		g_mutex_lock (&helper.mutex);
+	}
+	g_mutex_unlock (&helper.mutex);
+	g_thread_pool_free (pool, FALSE, TRUE);
+
+	g_mutex_clear (&helper.mutex);
+	g_cond_clear (&helper.cond);
+	g_free (helper.percentages);
+	if (helper.error != NULL) {
+		g_propagate_error (error, helper.error);
+		return FALSE;
+	}
+	return hif_state_finished (state, error);
+}
+
 /**
  * pk_backend_refresh_cache_thread:
  */
@@ -1627,34 +2197,11 @@ pk_backend_refresh_cache_thread (PkBackendJob *job,
 
 	/* refresh each repo */
 	state_local = hif_state_get_child (job_data->state);
-	hif_state_set_number_steps (state_local, refresh_sources->len);
-	for (i = 0; i < refresh_sources->len; i++) {
-		src = g_ptr_array_index (refresh_sources, i);
-
-		/* delete content even if up to date */
-		if (force) {
-			g_debug ("Deleting contents of %s as forced", hif_source_get_id (src));
-			ret = hif_source_clean (src, &error);
-			if (!ret) {
-				pk_backend_job_error_code (job, error->code, "%s", error->message);
-				return;
-			}
-		}
-
-		/* check and download */
-		state_loop = hif_state_get_child (state_local);
-		ret = pk_backend_refresh_source (job, src, state_loop, &error);
-		if (!ret) {
-			pk_backend_job_error_code (job, error->code, "%s", error->message);
-			return;
-		}
-
-		/* done */
-		ret = hif_state_done (state_local, &error);
-		if (!ret) {
-			pk_backend_job_error_code (job, error->code, "%s", error->message);
-			return;
-		}
+	ret = pk_backend_refresh_sources (job, refresh_sources, force,
+					  state_local, &error);
+	if (!ret) {
+		pk_backend_job_error_code (job, error->code, "%s", error->message);
+		return;
 	}
 
 	/* done */
@@ -1713,59 +2260,100 @@ hif_utils_find_package_ids (HySack sack, gchar **package_ids, GError **error)
 	HyPackageList pkglist = NULL;
 	HyPackage pkg;
 	HyQuery query = NULL;
+	g_autoptr(GHashTable) names = NULL;
+	g_autoptr(GHashTable) candidates = NULL;
+	g_autoptr(GHashTable) duplicates = NULL;
+	g_autofree const gchar **names_array = NULL;
 
-	/* run query */
 	hash = g_hash_table_new_full (g_str_hash, g_str_equal,
 				      g_free, (GDestroyNotify) hy_package_free);
+	if (package_ids[0] == NULL)
+		return hash;
+
+	/* run one query for all the names */
+	names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	for (i = 0; package_ids[i] != NULL; i++) {
+		const gchar *tmp = strchr (package_ids[i], ';');
+		if (tmp == NULL)
+			continue;
+		g_hash_table_add (names, g_strndup (package_ids[i], tmp - package_ids[i]));
+	}
+	names_array = (const gchar **) g_hash_table_get_keys_as_array (names, NULL);
 	query = hy_query_create (sack);
+	hy_query_filter_in (query, HY_PKG_NAME, HY_EQ, names_array);
+	pkglist = hy_query_run (query);
+
+	/* index the results on the package-id fields */
+	candidates = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	duplicates = g_hash_table_new (g_str_hash, g_str_equal);
+	FOR_PACKAGELIST(pkg, pkglist, i) {
+		gchar *key = g_strdup_printf ("%s;%s;%s;%s",
+					      hy_package_get_name (pkg),
+					      hy_package_get_evr (pkg),
+					      hy_package_get_arch (pkg),
+					      hy_package_get_reponame (pkg));
+		if (g_hash_table_contains (candidates, key)) {
+			g_debug ("possible matches: %s", hif_package_get_id (pkg));
+			g_hash_table_add (duplicates, g_hash_table_lookup (candidates, key));
+			g_free (key);
+			continue;
+		}
+		g_hash_table_insert (candidates, key, pkg);
+	}
+
 	for (i = 0; package_ids[i] != NULL; i++) {
+		const gchar *version;
+		g_autofree gchar *key = NULL;
 		g_auto(GStrv) split = NULL;
-		hy_query_clear (query);
+
 		split = pk_package_id_split (package_ids[i]);
+		if (split == NULL)
+			continue;
 		reponame = split[PK_PACKAGE_ID_DATA];
 		if (g_strcmp0 (reponame, "installed") == 0 ||
 		    g_str_has_prefix (reponame, "installed:"))
 			reponame = HY_SYSTEM_REPO_NAME;
 		else if (g_strcmp0 (reponame, "local") == 0)
 			reponame = HY_CMDLINE_REPO_NAME;
-		hy_query_filter (query, HY_PKG_NAME, HY_EQ, split[PK_PACKAGE_ID_NAME]);
-		hy_query_filter (query, HY_PKG_EVR, HY_EQ, split[PK_PACKAGE_ID_VERSION]);
-		hy_query_filter (query, HY_PKG_ARCH, HY_EQ, split[PK_PACKAGE_ID_ARCH]);
-		hy_query_filter (query, HY_PKG_REPONAME, HY_EQ, reponame);
-		pkglist = hy_query_run (query);
+
+		/* libsolv does not store a zero epoch */
+		version = split[PK_PACKAGE_ID_VERSION];
+		if (g_str_has_prefix (version, "0:"))
+			version += 2;
+		key = g_strdup_printf ("%s;%s;%s;%s",
+				       split[PK_PACKAGE_ID_NAME],
+				       version,
+				       split[PK_PACKAGE_ID_ARCH],
+				       reponame);
+		pkg = g_hash_table_lookup (candidates, key);
 
 		/* no matches */
-		if (hy_packagelist_count (pkglist) == 0) {
-			hy_packagelist_free (pkglist);
+		if (pkg == NULL)
 			continue;
-		}
 
 		/* multiple matches */
-		if (hy_packagelist_count (pkglist) > 1) {
+		if (g_hash_table_contains (duplicates, pkg)) {
 			ret = FALSE;
+			g_debug ("possible matches: %s", hif_package_get_id (pkg));
 			g_set_error (error,
 				     HIF_ERROR,
 				     PK_ERROR_ENUM_PACKAGE_CONFLICTS,
 				     "Multiple matches of %s", package_ids[i]);
-			FOR_PACKAGELIST(pkg, pkglist, i) {
-				g_debug ("possible matches: %s",
-					 hif_package_get_id (pkg));
-			}
 			goto out;
 		}
 
 		/* add to results */
-		pkg = hy_packagelist_get (pkglist, 0);
 		g_hash_table_insert (hash,
 				     g_strdup (package_ids[i]),
 				     hy_package_link (pkg));
-		hy_packagelist_free (pkglist);
 	}
 out:
 	if (!ret && hash != NULL) {
 		g_hash_table_unref (hash);
 		hash = NULL;
 	}
+	if (pkglist != NULL)
+		hy_packagelist_free (pkglist);
 	if (query != NULL)
 		hy_query_free (query);
 	return hash;
@@ -2391,6 +2979,78 @@ pk_backend_transaction_download_commit (PkBackendJob *job,
 	return hif_state_done (state, error);
 }
 
+/**
+ * pk_backend_transaction_save_plan:
+ *
+ * Keeps the depsolve of a simulate, together with the sack the goal points
+ * into, so that the real transaction does not have to solve again.
+ */
+static void
+pk_backend_transaction_save_plan (PkBackendJob *job)
+{
+	HifPlan *plan;
+	PkBackendHifJobData *job_data = pk_backend_job_get_user_data (job);
+	PkBackendHifPrivate *priv = pk_backend_get_user_data (job_data->backend);
+
+	g_mutex_lock (&priv->sack_mutex);
+	if (job_data->cache_item == NULL || !job_data->cache_item->valid) {
+		g_mutex_unlock (&priv->sack_mutex);
+		return;
+	}
+	plan = g_slice_new (HifPlan);
+	plan->cache_item = hif_sack_cache_item_ref (job_data->cache_item);
+	plan->generation = priv->sack_generation;
+	g_mutex_unlock (&priv->sack_mutex);
+
+	plan->transaction = g_object_ref (job_data->transaction);
+	plan->goal = job_data->goal;
+	job_data->goal = NULL;
+	pk_backend_job_set_plan (job, plan, (GDestroyNotify) hif_plan_free);
+}
+
+/**
+ * pk_backend_transaction_restore_plan:
+ *
+ * Swaps in the goal and transaction solved by the simulate, if the job got
+ * the same sack and nothing has been invalidated since.
+ *
+ * Return value: %TRUE if the depsolve can be skipped
+ */
+static gboolean
+pk_backend_transaction_restore_plan (PkBackendJob *job)
+{
+	gboolean ret;
+	HifPlan *plan;
+	PkBackendHifJobData *job_data = pk_backend_job_get_user_data (job);
+	PkBackendHifPrivate *priv = pk_backend_get_user_data (job_data->backend);
+
+	plan = pk_backend_job_get_plan (job);
+	if (plan == NULL)
+		return FALSE;
+
+	g_mutex_lock (&priv->sack_mutex);
+	ret = plan->cache_item == job_data->cache_item &&
+	      plan->cache_item->valid &&
+	      plan->generation == priv->sack_generation;
+	g_mutex_unlock (&priv->sack_mutex);
+	if (!ret) {
+		g_debug ("not reusing plan as the sack changed");
+		pk_backend_job_set_plan (job, NULL, NULL);
+		return FALSE;
+	}
+
+	/* the job asked for the same packages on the same sack */
+	hy_goal_free (job_data->goal);
+	job_data->goal = plan->goal;
+	plan->goal = NULL;
+	g_object_unref (job_data->transaction);
+	job_data->transaction = g_object_ref (plan->transaction);
+	hif_transaction_set_uid (job_data->transaction,
+				 pk_backend_job_get_uid (job));
+	pk_backend_job_set_plan (job, NULL, NULL);
+	return TRUE;
+}
+
 /**
  * pk_backend_transaction_run:
  */
@@ -2421,15 +3081,19 @@ pk_backend_transaction_run (PkBackendJob *job,
 				PK_TRANSACTION_FLAG_ENUM_ALLOW_REINSTALL))
 		flags |= HIF_TRANSACTION_FLAG_ALLOW_REINSTALL;
 
-	hif_transaction_set_flags (job_data->transaction, flags);
-
-	state_local = hif_state_get_child (state);
-	ret = hif_transaction_depsolve (job_data->transaction,
-					job_data->goal,
-					state_local,
-					error);
-	if (!ret)
-		return FALSE;
+	/* the simulate was run with the same flags */
+	if (pk_backend_transaction_restore_plan (job)) {
+		g_debug ("reusing the depsolve from the simulate");
+	} else {
+		hif_transaction_set_flags (job_data->transaction, flags);
+		state_local = hif_state_get_child (state);
+		ret = hif_transaction_depsolve (job_data->transaction,
+						job_data->goal,
+						state_local,
+						error);
+		if (!ret)
+			return FALSE;
+	}
 
 	/* done */
 	if (!hif_state_done (state, error))
@@ -2444,6 +3108,7 @@ pk_backend_transaction_run (PkBackendJob *job,
 						       error);
 		if (!ret)
 			return FALSE;
+		pk_backend_transaction_save_plan (job);
 		return hif_state_done (state, error);
 	}
 
@@ -9,7 +9,7 @@ static void katja_pkgtools_iface_init(KatjaPkgtoolsInterface *iface) {
 	iface->get_order = katja_binary_real_get_order;
 	iface->get_blacklist = katja_binary_real_get_blacklist;
 	iface->collect_cache_info = (GSList *(*)(KatjaPkgtools *, const gchar *)) katja_binary_collect_cache_info;
-	iface->generate_cache = (void (*)(KatjaPkgtools *, PkBackendJob *, const gchar *)) katja_binary_generate_cache;
+	iface->generate_cache = (void (*)(KatjaPkgtools *, PkBackendJob *, sqlite3 *, const gchar *)) katja_binary_generate_cache;
 	iface->download = katja_binary_real_download;
 	iface->install = katja_binary_real_install;
 }
@@ -30,17 +30,17 @@ GSList *katja_binary_collect_cache_info(KatjaBinary *binary, const gchar *tmpl)
 /**
  * katja_binary_generate_cache:
  **/
-void katja_binary_generate_cache(KatjaBinary *binary, PkBackendJob *job, const gchar *tmpl) {
+void katja_binary_generate_cache(KatjaBinary *binary, PkBackendJob *job, sqlite3 *db, const gchar *tmpl) {
 	g_return_if_fail(KATJA_IS_BINARY(binary));
 	g_return_if_fail(KATJA_BINARY_GET_CLASS(binary)->generate_cache != NULL);
 
-	KATJA_BINARY_GET_CLASS(binary)->generate_cache(binary, job, tmpl);
+	KATJA_BINARY_GET_CLASS(binary)->generate_cache(binary, job, db, tmpl);
 }
 
 /**
  * katja_binary_manifest:
  **/
-void katja_binary_manifest(KatjaBinary *binary, PkBackendJob *job, const gchar *tmpl, gchar *filename) {
+void katja_binary_manifest(KatjaBinary *binary, PkBackendJob *job, sqlite3 *db, const gchar *tmpl, gchar *filename) {
 	FILE *manifest;
 	gint err, read_len;
 	guint pos;
@@ -50,7 +50,6 @@ void katja_binary_manifest(KatjaBinary *binary, PkBackendJob *job, const gchar *
 	GRegex *pkg_expr = NULL, *file_expr = NULL;
 	GMatchInfo *match_info;
 	sqlite3_stmt *statement = NULL;
-	PkBackendKatjaJobData *job_data = pk_backend_job_get_user_data(job);
 
 	path = g_build_filename(tmpl, binary->name, filename, NULL);
 	manifest = fopen(path, "rb");
@@ -75,14 +74,14 @@ void katja_binary_manifest(KatjaBinary *binary, PkBackendJob *job, const gchar *
 		goto out;
 
 	/* Prepare SQL statements */
-	if (sqlite3_prepare_v2(job_data->db,
+	if (sqlite3_prepare_v2(db,
 						   "INSERT INTO filelist (full_name, filename) VALUES (@full_name, @filename)",
 						   -1,
 						   &statement,
 						   NULL) != SQLITE_OK)
 		goto out;
 
-	sqlite3_exec(job_data->db, "BEGIN TRANSACTION", NULL, NULL, NULL);
+	sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, NULL);
 	while ((read_len = BZ2_bzRead(&err, manifest_bz2, buf, KATJA_PKGTOOLS_MAX_BUF_SIZE))) {
 		if ((err != BZ_OK) && (err != BZ_STREAM_END))
 			break;
@@ -126,7 +125,7 @@ void katja_binary_manifest(KatjaBinary *binary, PkBackendJob *job, const gchar *
 		g_strfreev(lines);
 	}
 
-	sqlite3_exec(job_data->db, "END TRANSACTION", NULL, NULL, NULL);
+	sqlite3_exec(db, "END TRANSACTION", NULL, NULL, NULL);
 	g_free(full_name);
 	BZ2_bzReadClose(&err, manifest_bz2);
 
@@ -28,7 +28,7 @@ typedef struct {
 	GObjectClass parent_class;
 
 	GSList *(*collect_cache_info) (KatjaBinary *binary, const gchar *tmpl);
-	void (*generate_cache) (KatjaBinary *binary, PkBackendJob *job, const gchar *tmpl);
+	void (*generate_cache) (KatjaBinary *binary, PkBackendJob *job, sqlite3 *db, const gchar *tmpl);
 } KatjaBinaryClass;
 
 GType katja_binary_get_type(void);
@@ -37,10 +37,10 @@ G_END_DECLS
 
 /* Virtual public methods */
 GSList *katja_binary_collect_cache_info(KatjaBinary *binary, const gchar *tmpl);
-void katja_binary_generate_cache(KatjaBinary *binary, PkBackendJob *job, const gchar *tmpl);
+void katja_binary_generate_cache(KatjaBinary *binary, PkBackendJob *job, sqlite3 *db, const gchar *tmpl);
 
 /* Public methods */
-void katja_binary_manifest(KatjaBinary *binary, PkBackendJob *job, const gchar *tmpl, gchar *filename);
+void katja_binary_manifest(KatjaBinary *binary, PkBackendJob *job, sqlite3 *db, const gchar *tmpl, gchar *filename);
 
 /* Implementations */
 gchar *katja_binary_real_get_name(KatjaPkgtools *pkgtools);
@@ -6,8 +6,7 @@ G_DEFINE_TYPE(KatjaDl, katja_dl, KATJA_TYPE_BINARY);
  * katja_dl_real_collect_cache_info:
  **/
 GSList *katja_dl_real_collect_cache_info(KatjaBinary *binary, const gchar *tmpl) {
-	CURL *curl = NULL;
-	gchar **source_dest;
+	KatjaDownload *download;
 	GSList *file_list = NULL;
 	GFile *tmp_dir, *repo_tmp_dir;
 
@@ -17,36 +16,27 @@ GSList *katja_dl_real_collect_cache_info(KatjaBinary *binary, const gchar *tmpl)
 	g_file_make_directory(repo_tmp_dir, NULL, NULL);
 
 	/* There is no ChangeLog yet to check if there are updates or not. Just mark the index file for download */
-	source_dest = g_malloc_n(3, sizeof(gchar *));
-	source_dest[0] = g_strdup(KATJA_DL(binary)->index_file);
-	source_dest[1] = g_build_filename(tmpl, katja_pkgtools_get_name(KATJA_PKGTOOLS(binary)), "IndexFile", NULL);
-	source_dest[2] = NULL;
-	/* Check if the remote file can be found */
-	if (katja_get_file(&curl, source_dest[0], NULL))
-		g_strfreev(source_dest);
-	else
-		file_list = g_slist_append(file_list, source_dest);
+	download = g_new0(KatjaDownload, 1);
+	download->url = g_strdup(KATJA_DL(binary)->index_file);
+	download->dest = g_build_filename(tmpl, katja_pkgtools_get_name(KATJA_PKGTOOLS(binary)), "IndexFile", NULL);
+	file_list = g_slist_append(file_list, download);
 
 	g_object_unref(repo_tmp_dir);
 	g_object_unref(tmp_dir);
 
-	if (curl)
-		curl_easy_cleanup(curl);
-
 	return file_list;
 }
 
 /**
  * katja_dl_real_generate_cache:
  **/
-void katja_dl_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, const gchar *tmpl) {
+void katja_dl_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, sqlite3 *db, const gchar *tmpl) {
 	gchar **line_tokens, **pkg_tokens, *line, *collection_name = NULL, *list_filename;
 	gboolean skip = FALSE;
 	GFile *list_file;
 	GFileInputStream *fin;
 	GDataInputStream *data_in = NULL;
 	sqlite3_stmt *stmt = NULL;
-	PkBackendKatjaJobData *job_data = pk_backend_job_get_user_data(job);
 
 	/* Check if the temporary directory for this repository exists. If so the file metadata have to be generated */
 	list_filename = g_build_filename(tmpl, katja_pkgtools_get_name(KATJA_PKGTOOLS(binary)), "IndexFile", NULL);
@@ -56,7 +46,7 @@ void katja_dl_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, const
 	data_in = g_data_input_stream_new(G_INPUT_STREAM(fin));
 
 	/* Remove the old entries from this repository */
-	if (sqlite3_prepare_v2(job_data->db,
+	if (sqlite3_prepare_v2(db,
 						   "DELETE FROM repos WHERE repo LIKE @repo",
 						   -1,
 						   &stmt,
@@ -66,7 +56,7 @@ void katja_dl_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, const
 		sqlite3_finalize(stmt);
 	}
 
-	if (sqlite3_prepare_v2(job_data->db,
+	if (sqlite3_prepare_v2(db,
 						   "INSERT INTO repos (repo_order, repo) VALUES (@repo_order, @repo)",
 						   -1,
 						   &stmt,
@@ -79,7 +69,7 @@ void katja_dl_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, const
 		goto out;
 
 	/* Insert new records */
-	if ((sqlite3_prepare_v2(job_data->db,
+	if ((sqlite3_prepare_v2(db,
 							"INSERT INTO pkglist (full_name, name, ver, arch, "
 							"summary, desc, compressed, uncompressed, cat, repo_order, ext) "
 							"VALUES (@full_name, @name, @ver, @arch, @summary, "
@@ -89,7 +79,7 @@ void katja_dl_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, const
 							NULL) != SQLITE_OK))
 		goto out;
 
-	sqlite3_exec(job_data->db, "BEGIN TRANSACTION", NULL, NULL, NULL);
+	sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, NULL);
 
 	while ((line = g_data_input_stream_read_line(data_in, NULL, NULL, NULL))) {
 		line_tokens = g_strsplit(line, ":", 0);
@@ -142,7 +132,7 @@ void katja_dl_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, const
 
 	/* Create a collection entry */
 	if (collection_name && g_seekable_seek(G_SEEKABLE(data_in), 0, G_SEEK_SET, NULL, NULL) &&
-		(sqlite3_prepare_v2(job_data->db,
+		(sqlite3_prepare_v2(db,
 							"INSERT INTO collections (name, repo_order, collection_pkg) "
 							"VALUES (@name, @repo_order, @collection_pkg)",
 							-1,
@@ -176,7 +166,7 @@ void katja_dl_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, const
 	}
 	g_free(collection_name);
 
-	sqlite3_exec(job_data->db, "END TRANSACTION", NULL, NULL, NULL);
+	sqlite3_exec(db, "END TRANSACTION", NULL, NULL, NULL);
 
 out:
 	if (data_in)
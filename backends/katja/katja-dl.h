@@ -30,7 +30,7 @@ KatjaDl *katja_dl_new(gchar *name, gchar *mirror, gushort order, gchar *blacklis
 
 /* Implementations */
 GSList *katja_dl_real_collect_cache_info(KatjaBinary *binary, const gchar *tmpl);
-void katja_dl_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, const gchar *tmpl);
+void katja_dl_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, sqlite3 *db, const gchar *tmpl);
 
 G_END_DECLS
 
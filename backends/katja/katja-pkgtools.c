@@ -40,6 +40,9 @@ GRegex *katja_pkgtools_get_blacklist(KatjaPkgtools *pkgtools) {
 
 /**
  * katja_pkgtools_collect_cache_info:
+ *
+ * Returns: (element-type KatjaDownload): the files the cache is generated from. The caller
+ * looks them up and skips the repository if a file that isn't optional is missing.
  **/
 GSList *katja_pkgtools_collect_cache_info(KatjaPkgtools *pkgtools, const gchar *tmpl) {
 	g_return_val_if_fail(KATJA_IS_PKGTOOLS(pkgtools), NULL);
@@ -51,11 +54,11 @@ GSList *katja_pkgtools_collect_cache_info(KatjaPkgtools *pkgtools, const gchar *
 /**
  * katja_pkgtools_generate_cache:
  **/
-void katja_pkgtools_generate_cache(KatjaPkgtools *pkgtools, PkBackendJob *job, const gchar *tmpl) {
+void katja_pkgtools_generate_cache(KatjaPkgtools *pkgtools, PkBackendJob *job, sqlite3 *db, const gchar *tmpl) {
 	g_return_if_fail(KATJA_IS_PKGTOOLS(pkgtools));
 	g_return_if_fail(KATJA_PKGTOOLS_GET_IFACE(pkgtools)->generate_cache != NULL);
 
-	KATJA_PKGTOOLS_GET_IFACE(pkgtools)->generate_cache(pkgtools, job, tmpl);
+	KATJA_PKGTOOLS_GET_IFACE(pkgtools)->generate_cache(pkgtools, job, db, tmpl);
 }
 
 /**
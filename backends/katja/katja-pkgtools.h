@@ -29,7 +29,7 @@ typedef struct {
 	gushort (*get_order) (KatjaPkgtools *pkgtools);
 	GRegex *(*get_blacklist) (KatjaPkgtools *pkgtools);
 	GSList *(*collect_cache_info) (KatjaPkgtools *pkgtools, const gchar *tmpl);
-	void (*generate_cache) (KatjaPkgtools *pkgtools, PkBackendJob *job, const gchar *tmpl);
+	void (*generate_cache) (KatjaPkgtools *pkgtools, PkBackendJob *job, sqlite3 *db, const gchar *tmpl);
 	gboolean (*download) (KatjaPkgtools *pkgtools, PkBackendJob *job, gchar *dest_dir_name, gchar *pkg_name);
 	void (*install) (KatjaPkgtools *pkgtools, PkBackendJob *job, gchar *pkg_name);
 } KatjaPkgtoolsInterface;
@@ -42,7 +42,7 @@ gchar *katja_pkgtools_get_mirror(KatjaPkgtools *pkgtools);
 gushort katja_pkgtools_get_order(KatjaPkgtools *pkgtools);
 GRegex *katja_pkgtools_get_blacklist(KatjaPkgtools *pkgtools);
 GSList *katja_pkgtools_collect_cache_info(KatjaPkgtools *pkgtools, const gchar *tmpl);
-void katja_pkgtools_generate_cache(KatjaPkgtools *pkgtools, PkBackendJob *job, const gchar *tmpl);
+void katja_pkgtools_generate_cache(KatjaPkgtools *pkgtools, PkBackendJob *job, sqlite3 *db, const gchar *tmpl);
 gboolean katja_pkgtools_download(KatjaPkgtools *pkgtools, PkBackendJob *job, gchar *dest_dir_name, gchar *pkg_name);
 void katja_pkgtools_install(KatjaPkgtools *pkgtools, PkBackendJob *job, gchar *pkg_name);
 
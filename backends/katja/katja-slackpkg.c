@@ -10,9 +10,9 @@ GHashTable *katja_slackpkg_cat_map = NULL;
  * katja_slackpkg_real_collect_cache_info:
  **/
 GSList *katja_slackpkg_real_collect_cache_info(KatjaBinary *binary, const gchar *tmpl) {
-	CURL *curl = NULL;
-	gchar **source_dest, **cur_priority;
+	gchar **cur_priority;
 	GSList *file_list = NULL;
+	KatjaDownload *download;
 	GFile *tmp_dir, *repo_tmp_dir;
 
 	/* Create the temporary directory for the repository */
@@ -20,48 +20,33 @@ GSList *katja_slackpkg_real_collect_cache_info(KatjaBinary *binary, const gchar
 	repo_tmp_dir = g_file_get_child(tmp_dir, katja_pkgtools_get_name(KATJA_PKGTOOLS(binary)));
 	g_file_make_directory(repo_tmp_dir, NULL, NULL);
 
-	/* Download PACKAGES.TXT. These files are most important, break if some of them couldn't be found */
+	/* PACKAGES.TXT. These files are most important, the repository is skipped if some of them couldn't be found */
 	for (cur_priority = KATJA_SLACKPKG(binary)->priority; *cur_priority; cur_priority++) {
-		source_dest = g_malloc_n(3, sizeof(gchar *));
-		source_dest[0] = g_strconcat(katja_pkgtools_get_mirror(KATJA_PKGTOOLS(binary)),
-									 *cur_priority,
-									 "/PACKAGES.TXT",
-									 NULL);
-		source_dest[1] = g_build_filename(tmpl, katja_pkgtools_get_name(KATJA_PKGTOOLS(binary)), "PACKAGES.TXT", NULL);
-		source_dest[2] = NULL;
-
-		if (katja_get_file(&curl, source_dest[0], NULL) == CURLE_OK) {
-			file_list = g_slist_prepend(file_list, source_dest);
-		} else {
-			g_strfreev(source_dest);
-			g_slist_free_full(file_list, (GDestroyNotify)g_strfreev);
-			goto out;
-		}
-
-		/* Download file lists if available */
-		source_dest = g_malloc_n(3, sizeof(gchar *));
-		source_dest[0] = g_strconcat(katja_pkgtools_get_mirror(KATJA_PKGTOOLS(binary)),
-									 *cur_priority,
-									 "/MANIFEST.bz2",
-									 NULL);
-		source_dest[1] = g_strconcat(tmpl,
+		download = g_new0(KatjaDownload, 1);
+		download->url = g_strconcat(katja_pkgtools_get_mirror(KATJA_PKGTOOLS(binary)),
+									*cur_priority,
+									"/PACKAGES.TXT",
+									NULL);
+		download->dest = g_build_filename(tmpl, katja_pkgtools_get_name(KATJA_PKGTOOLS(binary)), "PACKAGES.TXT", NULL);
+		file_list = g_slist_prepend(file_list, download);
+
+		/* File lists if available */
+		download = g_new0(KatjaDownload, 1);
+		download->url = g_strconcat(katja_pkgtools_get_mirror(KATJA_PKGTOOLS(binary)),
+									*cur_priority,
+									"/MANIFEST.bz2",
+									NULL);
+		download->dest = g_strconcat(tmpl,
 									 "/", katja_pkgtools_get_name(KATJA_PKGTOOLS(binary)),
 									 "/", *cur_priority, "-MANIFEST.bz2",
 									 NULL);
-		source_dest[2] = NULL;
-		if (katja_get_file(&curl, source_dest[0], NULL) == CURLE_OK)
-			file_list = g_slist_prepend(file_list, source_dest);
-		else
-			g_strfreev(source_dest);
+		download->optional = TRUE;
+		file_list = g_slist_prepend(file_list, download);
 	}
 
-out:
 	g_object_unref(repo_tmp_dir);
 	g_object_unref(tmp_dir);
 
-	if (curl)
-		curl_easy_cleanup(curl);
-
 /*	FILE *fsource = NULL, *fdest = NULL;
 	guint i;
 	gdouble size, sum_size;
@@ -138,7 +123,7 @@ out:
 /**
  * katja_slackpkg_real_generate_cache:
  **/
-void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, const gchar *tmpl) {
+void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, sqlite3 *db, const gchar *tmpl) {
 	gchar **pkg_tokens = NULL, **cur_priority;
 	gchar *query = NULL, *filename = NULL, *location = NULL, *cat, *summary = NULL, *line, *packages_txt;
 	guint pkg_compressed = 0, pkg_uncompressed = 0;
@@ -148,7 +133,6 @@ void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job,
 	GFileInputStream *fin;
 	GDataInputStream *data_in;
 	sqlite3_stmt *insert_statement = NULL, *update_statement = NULL, *insert_default_statement = NULL, *statement;
-	PkBackendKatjaJobData *job_data = pk_backend_job_get_user_data(job);
 
 	/* Check if the temporary directory for this repository exists, then the file metadata have to be generated */
 	packages_txt = g_build_filename(tmpl, katja_pkgtools_get_name(KATJA_PKGTOOLS(binary)), "PACKAGES.TXT", NULL);
@@ -160,7 +144,7 @@ void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job,
 		goto out;
 
 	/* Remove the old entries from this repository */
-	if (sqlite3_prepare_v2(job_data->db,
+	if (sqlite3_prepare_v2(db,
 						   "DELETE FROM repos WHERE repo LIKE @repo",
 						   -1,
 						   &statement,
@@ -170,7 +154,7 @@ void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job,
 		sqlite3_finalize(statement);
 	}
 
-	if (sqlite3_prepare_v2(job_data->db,
+	if (sqlite3_prepare_v2(db,
 						   "INSERT INTO repos (repo_order, repo) VALUES (@repo_order, @repo)",
 						   -1,
 						   &statement,
@@ -182,7 +166,7 @@ void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job,
 	sqlite3_finalize(statement);
 
 	/* Insert new records */
-	if ((sqlite3_prepare_v2(job_data->db,
+	if ((sqlite3_prepare_v2(db,
 						"INSERT OR REPLACE INTO pkglist (full_name, ver, arch, ext, location, "
 						"summary, desc, compressed, uncompressed, name, repo_order, cat) "
 						"VALUES (@full_name, @ver, @arch, @ext, @location, @summary, "
@@ -190,7 +174,7 @@ void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job,
 						-1,
 						&insert_statement,
 						NULL) != SQLITE_OK) ||
-	(sqlite3_prepare_v2(job_data->db,
+	(sqlite3_prepare_v2(db,
 						"INSERT OR REPLACE INTO pkglist (full_name, ver, arch, ext, location, "
 						"summary, desc, compressed, uncompressed, name, repo_order) "
 						"VALUES (@full_name, @ver, @arch, @ext, @location, @summary, "
@@ -205,13 +189,13 @@ void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job,
 							"desc = @desc, compressed = @compressed, uncompressed = @uncompressed "
 							"WHERE name LIKE @name AND repo_order = %u",
 							katja_pkgtools_get_order(KATJA_PKGTOOLS(binary)));
-	if (sqlite3_prepare_v2(job_data->db, query, -1, &update_statement, NULL) != SQLITE_OK)
+	if (sqlite3_prepare_v2(db, query, -1, &update_statement, NULL) != SQLITE_OK)
 		goto out;
 
 	data_in = g_data_input_stream_new(G_INPUT_STREAM(fin));
 	desc = g_string_new("");
 
-	sqlite3_exec(job_data->db, "BEGIN TRANSACTION", NULL, NULL, NULL);
+	sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, NULL);
 
 	while ((line = g_data_input_stream_read_line(data_in, NULL, NULL, NULL))) {
 		if (!strncmp(line, "PACKAGE NAME:  ", 15)) {
@@ -287,7 +271,7 @@ void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job,
 		g_free(line);
 	}
 
-	sqlite3_exec(job_data->db, "END TRANSACTION", NULL, NULL, NULL);
+	sqlite3_exec(db, "END TRANSACTION", NULL, NULL, NULL);
 
 	g_string_free(desc, TRUE);
 
@@ -297,7 +281,7 @@ void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job,
 	/* Parse MANIFEST.bz2 */
 	for (cur_priority = KATJA_SLACKPKG(binary)->priority; *cur_priority; cur_priority++) {
 		filename = g_strconcat(*cur_priority, "-MANIFEST.bz2", NULL);
-		katja_binary_manifest(binary, job, tmpl, filename);
+		katja_binary_manifest(binary, job, db, tmpl, filename);
 		g_free(filename);
 	}
 
@@ -33,7 +33,7 @@ KatjaSlackpkg *katja_slackpkg_new(gchar *name, gchar *mirror, gushort order, gch
 
 /* Implementations */
 GSList *katja_slackpkg_real_collect_cache_info(KatjaBinary *binary, const gchar *tmpl);
-void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, const gchar *tmpl);
+void katja_slackpkg_real_generate_cache(KatjaBinary *binary, PkBackendJob *job, sqlite3 *db, const gchar *tmpl);
 
 G_END_DECLS
 
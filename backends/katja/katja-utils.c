@@ -48,6 +48,172 @@ CURLcode katja_get_file(CURL **curl, gchar *source_url, gchar *dest) {
 	return ret;
 }
 
+/**
+ * katja_download_header_cb:
+ *
+ * Remembers the ETag of the downloaded file.
+ **/
+static gsize katja_download_header_cb(gchar *buffer, gsize size, gsize nitems, gpointer user_data) {
+	KatjaDownload *download = user_data;
+	gsize len = size * nitems;
+
+	if ((len > 5) && !g_ascii_strncasecmp(buffer, "ETag:", 5)) {
+		g_free(download->etag);
+		download->etag = g_strstrip(g_strndup(buffer + 5, len - 5));
+	}
+
+	return len;
+}
+
+/**
+ * katja_download_start:
+ **/
+static CURL *katja_download_start(KatjaDownload *download) {
+	CURL *curl;
+	gchar *header;
+
+	if (!(curl = curl_easy_init())) {
+		download->result = CURLE_FAILED_INIT;
+		return NULL;
+	}
+	if (download->check) {
+		curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+		curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+		curl_easy_setopt(curl, CURLOPT_URL, download->url);
+		curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+		curl_easy_setopt(curl, CURLOPT_PRIVATE, download);
+		return curl;
+	}
+	if (!(download->fout = fopen(download->dest, "wb"))) {
+		download->result = CURLE_WRITE_ERROR;
+		curl_easy_cleanup(curl);
+		return NULL;
+	}
+
+	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+	curl_easy_setopt(curl, CURLOPT_URL, download->url);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, download->fout);
+	curl_easy_setopt(curl, CURLOPT_FILETIME, 1L);
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, katja_download_header_cb);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, download);
+	curl_easy_setopt(curl, CURLOPT_PRIVATE, download);
+
+	if (download->conditional && download->mtime > 0) {
+		curl_easy_setopt(curl, CURLOPT_TIMECONDITION, (glong) CURL_TIMECOND_IFMODSINCE);
+		curl_easy_setopt(curl, CURLOPT_TIMEVALUE, download->mtime);
+	}
+	if (download->conditional && download->etag) {
+		header = g_strconcat("If-None-Match: ", download->etag, NULL);
+		download->headers = curl_slist_append(download->headers, header);
+		curl_easy_setopt(curl, CURLOPT_HTTPHEADER, download->headers);
+		g_free(header);
+	}
+
+	return curl;
+}
+
+/**
+ * katja_download_finish:
+ **/
+static void katja_download_finish(KatjaDownload *download, CURL *curl, CURLcode result) {
+	glong response_code = 0, unmet = 0, filetime = -1;
+
+	if (download->check) {
+		download->result = result;
+		curl_easy_cleanup(curl);
+		return;
+	}
+
+	fclose(download->fout);
+	download->fout = NULL;
+	download->result = result;
+
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+	curl_easy_getinfo(curl, CURLINFO_CONDITION_UNMET, &unmet);
+	curl_easy_getinfo(curl, CURLINFO_FILETIME, &filetime);
+
+	if ((result == CURLE_OK) && (response_code != 304) && !unmet) {
+		download->modified = TRUE;
+		download->mtime = (filetime > 0) ? filetime : 0;
+	} else { /* Nothing or only an error page was written */
+		g_unlink(download->dest);
+	}
+
+	curl_slist_free_all(download->headers);
+	download->headers = NULL;
+	curl_easy_cleanup(curl);
+}
+
+/**
+ * katja_get_files:
+ * @downloads: (element-type KatjaDownload): files to download
+ * @max_parallel: how many transfers may be in flight at once
+ *
+ * Downloads all files with a curl multi handle. Afterwards modified is set for every file that
+ * was actually (re)downloaded. Files marked with check are only looked up with a HEAD request.
+ **/
+void katja_get_files(GPtrArray *downloads, guint max_parallel) {
+	CURLM *multi;
+	CURL *curl;
+	CURLMsg *msg;
+	CURLcode result;
+	KatjaDownload *download;
+	gint running = 0, msgs_left;
+	guint next = 0, active = 0;
+
+	g_return_if_fail(downloads != NULL);
+
+	if (!(multi = curl_multi_init()))
+		return;
+	if (max_parallel == 0)
+		max_parallel = 1;
+
+	do {
+		/* Keep up to max_parallel transfers running */
+		while ((active < max_parallel) && (next < downloads->len)) {
+			download = g_ptr_array_index(downloads, next++);
+			if ((curl = katja_download_start(download))) {
+				curl_multi_add_handle(multi, curl);
+				active++;
+			}
+		}
+
+		curl_multi_perform(multi, &running);
+
+		while ((msg = curl_multi_info_read(multi, &msgs_left))) {
+			if (msg->msg != CURLMSG_DONE)
+				continue;
+
+			/* msg doesn't survive curl_multi_remove_handle() */
+			curl = msg->easy_handle;
+			result = msg->data.result;
+			curl_easy_getinfo(curl, CURLINFO_PRIVATE, (gchar **) &download);
+			curl_multi_remove_handle(multi, curl);
+			katja_download_finish(download, curl, result);
+			active--;
+		}
+
+		if (active)
+			curl_multi_wait(multi, NULL, 0, 1000, NULL);
+	} while (active || (next < downloads->len));
+
+	curl_multi_cleanup(multi);
+}
+
+/**
+ * katja_download_free:
+ **/
+void katja_download_free(KatjaDownload *download) {
+	if (!download)
+		return;
+
+	g_free(download->url);
+	g_free(download->dest);
+	g_free(download->etag);
+	g_free(download);
+}
+
 /**
  * katja_cut_pkg:
  *
@@ -96,50 +262,102 @@ gint katja_cmp_repo(gconstpointer a, gconstpointer b) {
 	return g_strcmp0(katja_pkgtools_get_name(KATJA_PKGTOOLS(a)), (gchar *) b);
 }
 
+/* Installed packages, shared by all jobs and reread when /var/log/packages changes */
+static GMutex katja_installed_mutex;
+static GHashTable *katja_installed_names = NULL; /* name → full name */
+static GHashTable *katja_installed_full_names = NULL;
+static guint64 katja_installed_mtime = 0;
+
 /**
- * katja_pkg_is_installed:
+ * katja_installed_refresh:
+ *
+ * Has to be called with katja_installed_mutex held.
  **/
-PkInfoEnum katja_pkg_is_installed(gchar *pkg_full_name) {
-	PkInfoEnum ret = PK_INFO_ENUM_INSTALLING;
-	gchar **pkg_tokens, **metadata_pkg_tokens;
+static gboolean katja_installed_refresh(void) {
+	gchar **pkg_tokens;
 	const gchar *pkg_metadata_filename;
+	guint64 mtime;
 	GFile *pkg_metadata_dir;
 	GFileEnumerator *pkg_metadata_enumerator;
 	GFileInfo *pkg_metadata_file_info;
 
-	g_return_val_if_fail(pkg_full_name != NULL, PK_INFO_ENUM_UNKNOWN);
-
-	/* Read the package metadata directory and comprare all installed packages with ones in the cache */
 	pkg_metadata_dir = g_file_new_for_path("/var/log/packages");
+	if (!(pkg_metadata_file_info = g_file_query_info(pkg_metadata_dir, "time::modified,time::modified-usec",
+													 G_FILE_QUERY_INFO_NONE,
+													 NULL,
+													 NULL))) {
+		g_object_unref(pkg_metadata_dir);
+		return FALSE;
+	}
+	mtime = g_file_info_get_attribute_uint64(pkg_metadata_file_info, "time::modified") * G_USEC_PER_SEC
+		  + g_file_info_get_attribute_uint32(pkg_metadata_file_info, "time::modified-usec");
+	g_object_unref(pkg_metadata_file_info);
+
+	/* Nothing was installed or removed since the last time */
+	if (katja_installed_names && (mtime == katja_installed_mtime)) {
+		g_object_unref(pkg_metadata_dir);
+		return TRUE;
+	}
+
 	if (!(pkg_metadata_enumerator = g_file_enumerate_children(pkg_metadata_dir, "standard::name",
 														G_FILE_QUERY_INFO_NONE,
 														NULL,
 														NULL))) {
 		g_object_unref(pkg_metadata_dir);
-		return PK_INFO_ENUM_UNKNOWN;
+		return FALSE;
 	}
 
-	pkg_tokens = katja_cut_pkg(pkg_full_name);
+	if (katja_installed_names) {
+		g_hash_table_remove_all(katja_installed_names);
+		g_hash_table_remove_all(katja_installed_full_names);
+	} else {
+		katja_installed_names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+		katja_installed_full_names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	}
 
 	while ((pkg_metadata_file_info = g_file_enumerator_next_file(pkg_metadata_enumerator, NULL, NULL))) {
 		pkg_metadata_filename = g_file_info_get_name(pkg_metadata_file_info);
-		metadata_pkg_tokens = katja_cut_pkg(pkg_metadata_filename);
+		pkg_tokens = katja_cut_pkg(pkg_metadata_filename);
 
-		if (!g_strcmp0(pkg_metadata_filename, pkg_full_name))
-			ret = PK_INFO_ENUM_INSTALLED;
-		else if (!g_strcmp0(metadata_pkg_tokens[0], pkg_tokens[0]))
-			ret = PK_INFO_ENUM_UPDATING;
+		g_hash_table_replace(katja_installed_names, g_strdup(pkg_tokens[0]), g_strdup(pkg_metadata_filename));
+		g_hash_table_add(katja_installed_full_names, g_strdup(pkg_metadata_filename));
 
-		g_strfreev(metadata_pkg_tokens);
+		g_strfreev(pkg_tokens);
 		g_object_unref(pkg_metadata_file_info);
-
-		if (ret != PK_INFO_ENUM_INSTALLING) /* If installed */
-			break;
 	}
+	katja_installed_mtime = mtime;
 
-	g_strfreev(pkg_tokens);
 	g_object_unref(pkg_metadata_enumerator);
 	g_object_unref(pkg_metadata_dir);
 
+	return TRUE;
+}
+
+/**
+ * katja_pkg_is_installed:
+ **/
+PkInfoEnum katja_pkg_is_installed(gchar *pkg_full_name) {
+	PkInfoEnum ret = PK_INFO_ENUM_INSTALLING;
+	gchar **pkg_tokens;
+
+	g_return_val_if_fail(pkg_full_name != NULL, PK_INFO_ENUM_UNKNOWN);
+
+	g_mutex_lock(&katja_installed_mutex);
+
+	if (!katja_installed_refresh()) {
+		g_mutex_unlock(&katja_installed_mutex);
+		return PK_INFO_ENUM_UNKNOWN;
+	}
+
+	pkg_tokens = katja_cut_pkg(pkg_full_name);
+
+	if (g_hash_table_contains(katja_installed_full_names, pkg_full_name))
+		ret = PK_INFO_ENUM_INSTALLED;
+	else if (g_hash_table_contains(katja_installed_names, pkg_tokens[0]))
+		ret = PK_INFO_ENUM_UPDATING;
+
+	g_mutex_unlock(&katja_installed_mutex);
+	g_strfreev(pkg_tokens);
+
 	return ret;
 }
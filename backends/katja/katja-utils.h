@@ -8,7 +8,25 @@
 #include <pk-backend-job.h>
 #include "katja-pkgtools.h"
 
+typedef struct {
+	gchar *url;
+	gchar *dest;
+	gchar *etag; /* Validators of the last download, replaced by the new ones */
+	glong mtime;
+	gboolean conditional; /* Don't download if the validators still match */
+	gboolean check; /* Only look if the file exists, result tells */
+	gboolean optional; /* The repository can do without this file */
+	gboolean modified;
+	CURLcode result;
+
+	/* private */
+	FILE *fout;
+	struct curl_slist *headers;
+} KatjaDownload;
+
 CURLcode katja_get_file(CURL **curl, gchar *source_url, gchar *dest);
+void katja_get_files(GPtrArray *downloads, guint max_parallel);
+void katja_download_free(KatjaDownload *download);
 gchar **katja_cut_pkg(const gchar *pkg_filename);
 gint katja_cmp_repo(gconstpointer a, gconstpointer b);
 PkInfoEnum katja_pkg_is_installed(gchar *pkg_full_name);
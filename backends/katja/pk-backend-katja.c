@@ -9,6 +9,7 @@
 #include "katja-dl.h"
 
 static GSList *repos = NULL;
+static guint max_parallel_downloads = 4;
 
 
 void pk_backend_initialize(GKeyFile *conf, PkBackend *backend) {
@@ -27,6 +28,9 @@ void pk_backend_initialize(GKeyFile *conf, PkBackend *backend) {
 	g_debug("backend: initialize");
 	curl_global_init(CURL_GLOBAL_DEFAULT);
 
+	if (conf && (g_key_file_get_integer(conf, "Daemon", "MaxParallelDownloads", NULL) > 0))
+		max_parallel_downloads = g_key_file_get_integer(conf, "Daemon", "MaxParallelDownloads", NULL);
+
 	/* Open the database. We will need it to save the time the configuration file was last modified. */
 	path = g_build_filename(LOCALSTATEDIR, "cache", "PackageKit", "metadata", "metadata.db", NULL);
 	if (sqlite3_open(path, &db) != SQLITE_OK)
@@ -162,6 +166,8 @@ void pk_backend_start_job(PkBackend *backend, PkBackendJob *job) {
 	db_filename = g_build_filename(LOCALSTATEDIR, "cache", "PackageKit", "metadata", "metadata.db", NULL);
 	if (sqlite3_open(db_filename, &job_data->db) == SQLITE_OK) { /* Some SQLite settings */
 		sqlite3_exec(job_data->db, "PRAGMA foreign_keys = ON", NULL, NULL, NULL);
+		/* Cascading and replacing deletes have to keep the search tables in sync */
+		sqlite3_exec(job_data->db, "PRAGMA recursive_triggers = ON", NULL, NULL, NULL);
 	} else {
 		pk_backend_job_error_code(job, PK_ERROR_ENUM_NO_CACHE,
 								  "%s: %s",
@@ -202,8 +208,8 @@ static void pk_backend_search_thread(PkBackendJob *job, GVariant *params, gpoint
 
 	query = sqlite3_mprintf("SELECT (p1.name || ';' || p1.ver || ';' || p1.arch || ';' || r.repo), p1.summary, "
 							"p1.full_name FROM pkglist AS p1 NATURAL JOIN repos AS r "
-							"WHERE p1.%s LIKE '%%%q%%' AND p1.ext NOT LIKE 'obsolete' AND p1.repo_order = "
-							"(SELECT MIN(p2.repo_order) FROM pkglist AS p2 WHERE p2.name = p1.name GROUP BY p2.name)",
+							"WHERE p1.pkg_id IN (SELECT rowid FROM pkglist_fts AS fts WHERE fts.%s LIKE '%%%q%%') "
+							"AND p1.ext NOT LIKE 'obsolete' AND p1.preferred",
 							(gchar *) user_data,
 							search);
 
@@ -259,7 +265,8 @@ static void pk_backend_search_files_thread(PkBackendJob *job, GVariant *params,
 
 	query = sqlite3_mprintf("SELECT (p.name || ';' || p.ver || ';' || p.arch || ';' || r.repo), p.summary, "
 							"p.full_name FROM filelist AS f NATURAL JOIN pkglist AS p NATURAL JOIN repos AS r "
-							"WHERE f.filename LIKE '%%%q%%' GROUP BY f.full_name", search);
+							"WHERE f.file_id IN (SELECT rowid FROM filelist_fts WHERE filename LIKE '%%%q%%') "
+							"GROUP BY f.full_name", search);
 
 	if ((sqlite3_prepare_v2(job_data->db, query, -1, &stmt, NULL) == SQLITE_OK)) {
 		/* Now we're ready to output all packages */
@@ -381,8 +388,7 @@ static void pk_backend_resolve_thread(PkBackendJob *job, GVariant *params, gpoin
 	if ((sqlite3_prepare_v2(job_data->db,
 							"SELECT (p1.name || ';' || p1.ver || ';' || p1.arch || ';' || r.repo), p1.summary, "
 						   	"p1.full_name FROM pkglist AS p1 NATURAL JOIN repos AS r "
-							"WHERE p1.name LIKE @search AND p1.repo_order = "
-							"(SELECT MIN(p2.repo_order) FROM pkglist AS p2 WHERE p2.name = p1.name GROUP BY p2.name)",
+							"WHERE p1.name LIKE @search AND p1.preferred",
 							-1,
 							&stmt,
 							NULL) == SQLITE_OK)) {
@@ -660,8 +666,7 @@ static void pk_backend_get_updates_thread(PkBackendJob *job, GVariant *params, g
 	if ((sqlite3_prepare_v2(job_data->db,
 							"SELECT p1.full_name, p1.name, p1.ver, p1.arch, r.repo, p1.summary, p1.ext "
 							"FROM pkglist AS p1 NATURAL JOIN repos AS r "
-							"WHERE p1.name LIKE @name AND p1.repo_order = "
-							"(SELECT MIN(p2.repo_order) FROM pkglist AS p2 WHERE p2.name = p1.name GROUP BY p2.name)",
+							"WHERE p1.name LIKE @name AND p1.preferred",
 							-1,
 							&stmt,
 							NULL) != SQLITE_OK)) {
@@ -799,11 +804,196 @@ void pk_backend_update_packages(PkBackend *backend, PkBackendJob *job,
 	pk_backend_job_thread_create(job, pk_backend_update_packages_thread, NULL, NULL);
 }
 
+typedef struct {
+	KatjaPkgtools *repo;
+	PkBackendJob *job;
+	const gchar *tmpl;
+	const gchar *schema;
+	gchar *staging;
+	gboolean modified;
+	gboolean generated;
+} PkBackendKatjaRepoCache;
+
+/**
+ * pk_backend_cache_info_get_validators:
+ *
+ * Reads the ETag and the modification time of the last download of the url.
+ **/
+static void pk_backend_cache_info_get_validators(sqlite3 *db, KatjaDownload *download) {
+	sqlite3_stmt *stmt;
+
+	if (sqlite3_prepare_v2(db, "SELECT value FROM cache_info WHERE key = @key", -1, &stmt, NULL) != SQLITE_OK)
+		return;
+
+	sqlite3_bind_text(stmt, 1, g_strconcat("etag:", download->url, NULL), -1, g_free);
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		download->etag = g_strdup((gchar *) sqlite3_column_text(stmt, 0));
+	sqlite3_reset(stmt);
+
+	sqlite3_bind_text(stmt, 1, g_strconcat("mtime:", download->url, NULL), -1, g_free);
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		download->mtime = sqlite3_column_int64(stmt, 0);
+
+	sqlite3_finalize(stmt);
+}
+
+/**
+ * pk_backend_cache_info_set_validators:
+ **/
+static void pk_backend_cache_info_set_validators(sqlite3 *db, KatjaDownload *download) {
+	sqlite3_stmt *stmt;
+
+	if (sqlite3_prepare_v2(db,
+						   "INSERT OR REPLACE INTO cache_info (key, value) VALUES (@key, @value)",
+						   -1,
+						   &stmt,
+						   NULL) != SQLITE_OK)
+		return;
+
+	sqlite3_bind_text(stmt, 1, g_strconcat("etag:", download->url, NULL), -1, g_free);
+	if (download->etag)
+		sqlite3_bind_text(stmt, 2, download->etag, -1, SQLITE_TRANSIENT);
+	else
+		sqlite3_bind_null(stmt, 2);
+	sqlite3_step(stmt);
+	sqlite3_reset(stmt);
+
+	sqlite3_bind_text(stmt, 1, g_strconcat("mtime:", download->url, NULL), -1, g_free);
+	sqlite3_bind_int64(stmt, 2, download->mtime);
+	sqlite3_step(stmt);
+
+	sqlite3_finalize(stmt);
+}
+
+/**
+ * pk_backend_repo_is_cached:
+ **/
+static gboolean pk_backend_repo_is_cached(sqlite3 *db, KatjaPkgtools *repo) {
+	gboolean ret = FALSE;
+	sqlite3_stmt *stmt;
+
+	if (sqlite3_prepare_v2(db, "SELECT repo_order FROM repos WHERE repo LIKE @repo", -1, &stmt, NULL) == SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, katja_pkgtools_get_name(repo), -1, SQLITE_TRANSIENT);
+		ret = (sqlite3_step(stmt) == SQLITE_ROW);
+		sqlite3_finalize(stmt);
+	}
+
+	return ret;
+}
+
+/**
+ * pk_backend_append_file:
+ **/
+static void pk_backend_append_file(const gchar *source, const gchar *dest) {
+	gchar *contents;
+	gsize length;
+	FILE *fout;
+
+	if (!g_file_get_contents(source, &contents, &length, NULL))
+		return;
+
+	if ((fout = fopen(dest, "ab"))) {
+		fwrite(contents, 1, length, fout);
+		fclose(fout);
+	}
+	g_free(contents);
+	g_unlink(source);
+}
+
+/**
+ * pk_backend_generate_cache_thread:
+ *
+ * Generates the cache of one repository into its own staging database, so several repositories
+ * can be processed at once.
+ **/
+static void pk_backend_generate_cache_thread(gpointer data, gpointer user_data) {
+	sqlite3 *db;
+	PkBackendKatjaRepoCache *cache = data;
+
+	if (sqlite3_open(cache->staging, &db) != SQLITE_OK) {
+		sqlite3_close(db);
+		return;
+	}
+
+	/* Nothing to recover from if it fails, the staging database is thrown away */
+	sqlite3_exec(db, "PRAGMA journal_mode = OFF", NULL, NULL, NULL);
+	sqlite3_exec(db, "PRAGMA synchronous = OFF", NULL, NULL, NULL);
+	sqlite3_exec(db, "PRAGMA foreign_keys = ON", NULL, NULL, NULL);
+
+	if (sqlite3_exec(db, cache->schema, NULL, NULL, NULL) == SQLITE_OK) {
+		katja_pkgtools_generate_cache(cache->repo, cache->job, db, cache->tmpl);
+		cache->generated = TRUE;
+	}
+
+	sqlite3_close(db);
+}
+
+/**
+ * pk_backend_swap_cache:
+ *
+ * Replaces the entries of the repository with the ones from its staging database in one transaction.
+ **/
+static gboolean pk_backend_swap_cache(PkBackendJob *job, sqlite3 *db, PkBackendKatjaRepoCache *cache) {
+	gchar *query, *db_err = NULL;
+	gboolean ret = FALSE;
+	sqlite3_stmt *stmt;
+
+	query = sqlite3_mprintf("ATTACH DATABASE %Q AS staging", cache->staging);
+	ret = (sqlite3_exec(db, query, NULL, NULL, &db_err) == SQLITE_OK);
+	sqlite3_free(query);
+	if (!ret)
+		goto out;
+
+	/* The repository was not generated if its files could not be read */
+	if (sqlite3_prepare_v2(db, "SELECT repo FROM staging.repos", -1, &stmt, NULL) == SQLITE_OK) {
+		ret = (sqlite3_step(stmt) == SQLITE_ROW);
+		sqlite3_finalize(stmt);
+	} else {
+		ret = FALSE;
+	}
+
+	if (ret) {
+		query = sqlite3_mprintf("BEGIN TRANSACTION;"
+								"DELETE FROM repos WHERE repo LIKE %Q;"
+								"INSERT INTO repos SELECT * FROM staging.repos;"
+								"INSERT OR REPLACE INTO pkglist (full_name, name, ver, arch, ext, location, "
+								"summary, desc, compressed, uncompressed, cat, repo_order, preferred) "
+								"SELECT full_name, name, ver, arch, ext, location, summary, desc, "
+								"compressed, uncompressed, cat, repo_order, preferred FROM staging.pkglist;"
+								"INSERT OR IGNORE INTO collections SELECT * FROM staging.collections;"
+								"INSERT OR IGNORE INTO filelist (full_name, filename) "
+								"SELECT full_name, filename FROM staging.filelist;"
+								"COMMIT",
+								katja_pkgtools_get_name(cache->repo));
+		if (sqlite3_exec(db, query, NULL, NULL, &db_err) != SQLITE_OK) {
+			sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+			ret = FALSE;
+		}
+		sqlite3_free(query);
+	}
+
+	sqlite3_exec(db, "DETACH DATABASE staging", NULL, NULL, NULL);
+
+out:
+	if (db_err) {
+		pk_backend_job_error_code(job, PK_ERROR_ENUM_INTERNAL_ERROR, "%s", db_err);
+		sqlite3_free(db_err);
+	}
+
+	return ret;
+}
+
 static void pk_backend_refresh_cache_thread(PkBackendJob *job, GVariant *params, gpointer user_data) {
 	gchar *tmp_dir_name, *db_err, *path = NULL;
 	gint ret;
-	gboolean force;
-	GSList *file_list = NULL, *l;
+	guint i, j, begin, *first = NULL;
+	gboolean force, conditional, complete;
+	GSList *file_list = NULL, *l, *f;
+	GPtrArray *downloads = NULL, *checked, *targets = NULL, *retry;
+	GString *schema = NULL;
+	GThreadPool *pool;
+	KatjaDownload *download;
+	PkBackendKatjaRepoCache *caches = NULL;
 	GFile *db_file = NULL;
 	GFileInfo *file_info = NULL;
 	GError *err = NULL;
@@ -853,24 +1043,162 @@ static void pk_backend_refresh_cache_thread(PkBackendJob *job, GVariant *params,
 		}
 	}
 
-	for (l = repos; l; l = g_slist_next(l))	/* Get list of files that should be downloaded */
-		file_list = g_slist_concat(file_list, katja_pkgtools_collect_cache_info(l->data, tmp_dir_name));
+	/* Get list of files that should be downloaded. Every repository gets a range in the download list */
+	downloads = g_ptr_array_new_with_free_func((GDestroyNotify) katja_download_free);
+	targets = g_ptr_array_new_with_free_func(g_free);
+	caches = g_new0(PkBackendKatjaRepoCache, g_slist_length(repos));
+	first = g_new0(guint, g_slist_length(repos) + 1);
+
+	for (l = repos, i = 0; l; l = g_slist_next(l), i++) {
+		first[i] = downloads->len;
+
+		file_list = katja_pkgtools_collect_cache_info(l->data, tmp_dir_name);
+		for (f = file_list; f; f = g_slist_next(f)) {
+			download = f->data;
+			download->check = TRUE;
+			g_ptr_array_add(downloads, download);
+		}
+		g_slist_free(file_list);
+	}
+	first[i] = downloads->len;
+
+	/* Look up the files of all repositories at once */
+	katja_get_files(downloads, max_parallel_downloads);
+
+	/* Skip repositories with missing files they can't do without, and missing optional files */
+	checked = downloads;
+	downloads = g_ptr_array_new_with_free_func((GDestroyNotify) katja_download_free);
+	for (l = repos, i = 0; l; l = g_slist_next(l), i++) {
+		conditional = !force && pk_backend_repo_is_cached(job_data->db, l->data);
+		complete = TRUE;
+
+		for (j = first[i]; j < first[i + 1]; j++) {
+			download = g_ptr_array_index(checked, j);
+			if ((download->result != CURLE_OK) && !download->optional)
+				complete = FALSE;
+		}
+
+		begin = first[i];
+		first[i] = downloads->len;
+		for (j = begin; complete && (j < first[i + 1]); j++) {
+			download = g_ptr_array_index(checked, j);
+			if (download->result != CURLE_OK)
+				continue;
+
+			g_ptr_array_add(targets, download->dest);
+			download->dest = g_strdup_printf("%s.%u", download->dest, downloads->len);
+			download->check = FALSE;
+			download->conditional = conditional;
+			if (conditional)
+				pk_backend_cache_info_get_validators(job_data->db, download);
+
+			g_ptr_array_add(downloads, download);
+			g_ptr_array_index(checked, j) = NULL;
+		}
+	}
+	first[i] = downloads->len;
+	g_ptr_array_free(checked, TRUE);
 
 	/* Download repository */
 	pk_backend_job_set_status(job, PK_STATUS_ENUM_DOWNLOAD_REPOSITORY);
 
-	for (l = file_list; l; l = g_slist_next(l))
-		katja_get_file(&job_data->curl, ((gchar **)l->data)[0], ((gchar **)l->data)[1]);
-	g_slist_free_full(file_list, (GDestroyNotify)g_strfreev);
+	katja_get_files(downloads, max_parallel_downloads);
+
+	/* The cache of a repository is generated from all of its files, so if any of them
+	 * changed, the unchanged ones are needed too */
+	retry = g_ptr_array_new();
+	for (i = 0; i < g_slist_length(repos); i++) {
+		for (j = first[i]; j < first[i + 1]; j++) {
+			if (((KatjaDownload *) g_ptr_array_index(downloads, j))->modified)
+				caches[i].modified = TRUE;
+		}
+		for (j = first[i]; caches[i].modified && (j < first[i + 1]); j++) {
+			download = g_ptr_array_index(downloads, j);
+			if (!download->modified) {
+				download->conditional = FALSE;
+				g_ptr_array_add(retry, download);
+			}
+		}
+	}
+	katja_get_files(retry, max_parallel_downloads);
+	g_ptr_array_free(retry, TRUE);
+
+	/* Put the files together where the repositories expect them, in the original order */
+	for (j = 0; j < downloads->len; j++) {
+		download = g_ptr_array_index(downloads, j);
+		if (download->modified)
+			pk_backend_append_file(download->dest, g_ptr_array_index(targets, j));
+	}
 
 	/* Refresh cache */
 	pk_backend_job_set_status(job, PK_STATUS_ENUM_REFRESH_CACHE);
 
-	for (l = repos; l; l = g_slist_next(l))
-		katja_pkgtools_generate_cache(l->data, job, tmp_dir_name);
+	/* Use the schema of the main database for the staging ones */
+	if (sqlite3_prepare_v2(job_data->db,
+						   "SELECT sql FROM sqlite_master WHERE type = 'table' "
+						   "AND name IN ('repos', 'pkglist', 'collections', 'filelist')",
+						   -1,
+						   &stmt,
+						   NULL) != SQLITE_OK) {
+		pk_backend_job_error_code(job, PK_ERROR_ENUM_INTERNAL_ERROR, "%s", sqlite3_errmsg(job_data->db));
+		goto out;
+	}
+	schema = g_string_new("");
+	while (sqlite3_step(stmt) == SQLITE_ROW)
+		g_string_append_printf(schema, "%s;", sqlite3_column_text(stmt, 0));
+
+	pool = g_thread_pool_new(pk_backend_generate_cache_thread, NULL, g_get_num_processors(), TRUE, NULL);
+	for (l = repos, i = 0; l; l = g_slist_next(l), i++) {
+		caches[i].repo = l->data;
+		caches[i].job = job;
+		caches[i].tmpl = tmp_dir_name;
+		caches[i].schema = schema->str;
+		caches[i].staging = g_strdup_printf("%s/%s.db", tmp_dir_name, katja_pkgtools_get_name(l->data));
+
+		if (caches[i].modified)
+			g_thread_pool_push(pool, &caches[i], NULL);
+	}
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	/* Swap the new entries in, repository by repository */
+	for (i = 0; i < g_slist_length(repos); i++) {
+		if (!caches[i].generated || !pk_backend_swap_cache(job, job_data->db, &caches[i]))
+			continue;
+
+		/* Only now the downloaded files don't have to be fetched again */
+		sqlite3_exec(job_data->db, "BEGIN TRANSACTION", NULL, NULL, NULL);
+		for (j = first[i]; j < first[i + 1]; j++) {
+			download = g_ptr_array_index(downloads, j);
+			if (download->modified)
+				pk_backend_cache_info_set_validators(job_data->db, download);
+		}
+		sqlite3_exec(job_data->db, "END TRANSACTION", NULL, NULL, NULL);
+	}
+
+	/* Mark the packages from the repository with the lowest order,
+	 * so the queries don't have to look for them on each row */
+	if (sqlite3_exec(job_data->db,
+					 "UPDATE pkglist SET preferred = (repo_order = "
+					 "(SELECT MIN(p2.repo_order) FROM pkglist AS p2 WHERE p2.name = pkglist.name))",
+					 NULL,
+					 NULL,
+					 NULL) != SQLITE_OK)
+		pk_backend_job_error_code(job, PK_ERROR_ENUM_INTERNAL_ERROR, "%s", sqlite3_errmsg(job_data->db));
 
 out:
 	sqlite3_finalize(stmt);
+	if (schema)
+		g_string_free(schema, TRUE);
+	if (caches) {
+		for (i = 0; i < g_slist_length(repos); i++)
+			g_free(caches[i].staging);
+		g_free(caches);
+	}
+	g_free(first);
+	if (targets)
+		g_ptr_array_free(targets, TRUE);
+	if (downloads)
+		g_ptr_array_free(downloads, TRUE);
 	if (file_info)
 		g_object_unref(file_info);
 	if (db_file)
@@ -21,6 +21,7 @@
 
 #include <sys/types.h>
 #include <pwd.h>
+#include <glib/gstdio.h>
 
 #include <pk-backend.h>
 
@@ -83,6 +84,13 @@ typedef struct {
 	struct poldek_ctx	*ctx;
 	struct poclidek_ctx	*cctx;
 	struct pkgdb		*db;
+
+	/* installed state of packages, valid as long as rpmdb is not modified */
+	GHashTable		*installed;
+	gint64			 rpmdb_mtime;
+
+	/* dent path -> (name -> GPtrArray of struct pkg) */
+	GHashTable		*dents;
 } PkBackendPoldekPriv;
 
 typedef struct {
@@ -140,6 +148,8 @@ static GHashTable *clv;
 
 static PkBackendPoldekPriv *priv = NULL;
 
+static void poldek_forget_installed (void);
+
 /**
  * execute_command:
  *
@@ -175,6 +185,9 @@ execute_command (const gchar *format, ...)
 	poclidek_rcmd_free (rcmd);
 	poldek_ts_free (ts);
 
+	/* don't trust the mtime, it has a resolution of seconds */
+	poldek_forget_installed ();
+
 	g_free (command);
 
 	return result;
@@ -820,19 +833,85 @@ pk_backend_poldek_open_pkgdb (void)
 	}
 }
 
+/**
+ * poldek_rpmdb_get_mtime:
+ *
+ * Returns the time rpmdb was modified last, or 0 when it can't be found.
+ **/
+static gint64
+poldek_rpmdb_get_mtime (void)
+{
+	const gchar *files[] = { "/var/lib/rpm/Packages", "/var/lib/rpm/rpmdb.sqlite", NULL };
+	GStatBuf st;
+	guint i;
+
+	for (i = 0; files[i] != NULL; i++) {
+		if (g_stat (files[i], &st) == 0)
+			return (gint64) st.st_mtime;
+	}
+
+	return 0;
+}
+
+/**
+ * poldek_forget_installed:
+ *
+ * Drops everything cached about the installed packages.
+ **/
+static void
+poldek_forget_installed (void)
+{
+	g_hash_table_remove_all (priv->installed);
+	g_hash_table_remove (priv->dents, "installed");
+	priv->rpmdb_mtime = 0;
+}
+
+/**
+ * poldek_check_rpmdb:
+ *
+ * Forgets the installed packages once rpmdb has been changed, also by
+ * something else than us.
+ **/
+static void
+poldek_check_rpmdb (void)
+{
+	gint64 mtime;
+
+	mtime = poldek_rpmdb_get_mtime ();
+	if (mtime == 0 || mtime != priv->rpmdb_mtime) {
+		poldek_forget_installed ();
+		priv->rpmdb_mtime = mtime;
+	}
+}
+
 static gboolean
 pkg_is_installed (struct pkg *pkg)
 {
 	gint cmprc, is_installed = 0;
+	gchar *evr, *key;
+	gpointer value;
 
 	g_return_val_if_fail (pkg != NULL, FALSE);
 
+	poldek_check_rpmdb ();
+
+	evr = poldek_pkg_evr (pkg);
+	key = g_strdup_printf ("%s-%s.%s", pkg->name, evr, pkg_arch (pkg));
+	g_free (evr);
+
+	if (g_hash_table_lookup_extended (priv->installed, key, NULL, &value)) {
+		g_free (key);
+		return GPOINTER_TO_INT (value);
+	}
+
 	pk_backend_poldek_open_pkgdb ();
 
 	if (priv->db) {
 		is_installed = pkgdb_is_pkg_installed (priv->db, pkg, &cmprc);
 	}
 
+	g_hash_table_insert (priv->installed, key, GINT_TO_POINTER (is_installed ? TRUE : FALSE));
+
 	return is_installed ? TRUE : FALSE;
 }
 
@@ -1497,6 +1576,54 @@ poldek_backend_package (PkBackendJob *job, struct pkg *pkg, PkInfoEnum infoenum,
 	g_free (package_id);
 }
 
+/**
+ * poldek_get_dent_index:
+ *
+ * Returns packages from the specified directory grouped by name. The index
+ * is built once and kept until poldek is reloaded, or for "installed" until
+ * rpmdb is changed.
+ **/
+static GHashTable*
+poldek_get_dent_index (const gchar *dir)
+{
+	GHashTable *index;
+	tn_array   *packages;
+	gchar      *path;
+	size_t      i;
+
+	poldek_check_rpmdb ();
+
+	if ((index = g_hash_table_lookup (priv->dents, dir)) != NULL)
+		return index;
+
+	path = g_strdup_printf ("/%s", dir);
+	packages = poclidek_get_dent_packages (priv->cctx, path);
+	g_free (path);
+
+	if (packages == NULL)
+		return NULL;
+
+	index = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_ptr_array_unref);
+
+	for (i = 0; i < n_array_size (packages); i++) {
+		struct pkg *pkg = n_array_nth (packages, i);
+		GPtrArray  *pkgs;
+
+		if ((pkgs = g_hash_table_lookup (index, pkg->name)) == NULL) {
+			pkgs = g_ptr_array_new_with_free_func ((GDestroyNotify)pkg_free);
+			g_hash_table_insert (index, g_strdup (pkg->name), pkgs);
+		}
+
+		g_ptr_array_add (pkgs, pkg_link (pkg));
+	}
+
+	n_array_free (packages);
+
+	g_hash_table_insert (priv->dents, g_strdup (dir), index);
+
+	return index;
+}
+
 /**
  * poldek_get_pkg_from_package_id:
  */
@@ -1509,18 +1636,31 @@ poldek_get_pkg_from_package_id (const gchar *package_id)
 	g_return_val_if_fail (package_id != NULL, NULL);
 
 	if ((parts = pk_package_id_split (package_id))) {
-		tn_array *packages = NULL;
-		gchar    *vr = NULL;
+		GHashTable *index;
+		GPtrArray  *pkgs;
+		gchar      *vr = NULL;
+		guint       i;
 
 		vr = poldek_get_vr_from_package_id_evr (parts[PK_PACKAGE_ID_VERSION]);
 
-		if ((packages = execute_packages_command ("cd /%s; ls -q %s-%s.%s", parts[PK_PACKAGE_ID_DATA],
-										    parts[PK_PACKAGE_ID_NAME],
-										    vr,
-										    parts[PK_PACKAGE_ID_ARCH]))) {
-			if (n_array_size (packages) > 0) {
-				/* only one package is needed */
-				pkg = pkg_link (n_array_nth (packages, 0));
+		/* look the package up directly instead of running 'ls' through poclidek */
+		if ((index = poldek_get_dent_index (parts[PK_PACKAGE_ID_DATA])) != NULL &&
+		    (pkgs = g_hash_table_lookup (index, parts[PK_PACKAGE_ID_NAME])) != NULL) {
+			for (i = 0; i < pkgs->len; i++) {
+				struct pkg *p = g_ptr_array_index (pkgs, i);
+				gchar      *pvr;
+				gboolean    found;
+
+				pvr = g_strdup_printf ("%s-%s", p->ver, p->rel);
+				found = (g_strcmp0 (pvr, vr) == 0 &&
+					 g_strcmp0 (pkg_arch (p), parts[PK_PACKAGE_ID_ARCH]) == 0);
+				g_free (pvr);
+
+				if (found) {
+					/* only one package is needed */
+					pkg = pkg_link (p);
+					break;
+				}
 			}
 		}
 
@@ -1531,6 +1671,44 @@ poldek_get_pkg_from_package_id (const gchar *package_id)
 	return pkg;
 }
 
+/**
+ * poldek_resolve_from_dent:
+ *
+ * Returns packages from the specified directory named exactly as one of the
+ * values, or NULL when there are none.
+ **/
+static tn_array*
+poldek_resolve_from_dent (const gchar *dir, gchar **values)
+{
+	GHashTable *index;
+	tn_array   *pkgs;
+	guint       i, j;
+
+	if ((index = poldek_get_dent_index (dir)) == NULL)
+		return NULL;
+
+	pkgs = n_array_new (4, (tn_fn_free)pkg_free, (tn_fn_cmp)pkg_cmp_name_evr);
+
+	for (i = 0; values[i] != NULL; i++) {
+		GPtrArray *bucket;
+
+		if ((bucket = g_hash_table_lookup (index, values[i])) == NULL)
+			continue;
+
+		for (j = 0; j < bucket->len; j++)
+			n_array_push (pkgs, pkg_link (g_ptr_array_index (bucket, j)));
+	}
+
+	if (n_array_size (pkgs) == 0) {
+		n_array_free (pkgs);
+		return NULL;
+	}
+
+	n_array_sort_ex (pkgs, (tn_fn_cmp)pkg_cmp_name_evr_rev_recno);
+
+	return pkgs;
+}
+
 static tn_array*
 do_search_details (const gchar *tree, gchar **values)
 {
@@ -1705,24 +1883,19 @@ search_package_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
 		search_cmd_installed = g_strdup_printf ("search -qp --perlre /%s/", search);
 		search_cmd_available = g_strdup_printf ("search -qp --perlre /%s/", search);
 
-		g_free (search);
-	/* Resolve */
-	} else if (role == PK_ROLE_ENUM_RESOLVE) {
-		search = g_strjoinv(" ", values);
-
-		search_cmd_installed = g_strdup_printf ("ls -q %s", search);
-		search_cmd_available = g_strdup (search_cmd_installed);
-
 		g_free (search);
 	}
 
-	if ((search_cmd_installed != NULL && search_cmd_available != NULL) || role == PK_ROLE_ENUM_SEARCH_DETAILS) {
+	if ((search_cmd_installed != NULL && search_cmd_available != NULL) ||
+	    role == PK_ROLE_ENUM_SEARCH_DETAILS || role == PK_ROLE_ENUM_RESOLVE) {
 		tn_array *installed = NULL;
 		tn_array *available = NULL;
 
 		if (!pk_bitfield_contain (filters, PK_FILTER_ENUM_NOT_INSTALLED)) {
 			if (role == PK_ROLE_ENUM_SEARCH_DETAILS)
 				installed = do_search_details ("cd /installed", values);
+			else if (role == PK_ROLE_ENUM_RESOLVE)
+				installed = poldek_resolve_from_dent ("installed", values);
 			else
 				installed = execute_packages_command ("cd /installed; %s", search_cmd_installed);
 		}
@@ -1730,6 +1903,8 @@ search_package_thread (PkBackendJob *job, GVariant *params, gpointer user_data)
 		if (!pk_bitfield_contain (filters, PK_FILTER_ENUM_INSTALLED)) {
 			if (role == PK_ROLE_ENUM_SEARCH_DETAILS)
 				available = do_search_details ("cd /all-avail", values);
+			else if (role == PK_ROLE_ENUM_RESOLVE)
+				available = poldek_resolve_from_dent ("all-avail", values);
 			else
 				available = execute_packages_command ("cd /all-avail; %s", search_cmd_available);
 		}
@@ -2273,6 +2448,10 @@ do_poldek_destroy (PkBackend *backend)
 		priv->db = NULL;
 	}
 
+	/* packages are owned by poclidek */
+	g_hash_table_remove_all (priv->dents);
+	g_hash_table_remove_all (priv->installed);
+
 	poclidek_free (priv->cctx);
 	poldek_free (priv->ctx);
 
@@ -2329,6 +2508,8 @@ pk_backend_initialize (GKeyFile *conf, PkBackend *backend)
 	pberror->tslog = g_string_new ("");
 
 	priv = g_new0 (PkBackendPoldekPriv, 1);
+	priv->installed = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->dents = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_hash_table_unref);
 
 	do_poldek_init (backend);
 
@@ -2342,6 +2523,8 @@ pk_backend_destroy (PkBackend *backend)
 {
 	do_poldek_destroy (backend);
 
+	g_hash_table_unref (priv->installed);
+	g_hash_table_unref (priv->dents);
 	g_free (priv);
 
 	/* release PbError struct */
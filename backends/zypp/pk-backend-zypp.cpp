@@ -104,11 +104,31 @@ typedef enum {
 } PerformType;
 
 
+/* what the report receivers track for one job */
+typedef struct {
+	PkBackendJob *job;
+	gchar *package_id;
+	guint sub_percentage;
+} ZyppJobReport;
+
+/// \class ZyppJob
+/// \brief Guards the zypp pool for the lifetime of a backend job.
+///
+/// Roles which modify the target or the repositories hold the lock
+/// exclusively. Read-only roles share it, and only ever see a pool
+/// which has been fully built before the shared lock was granted.
 class ZyppJob {
  public:
 	ZyppJob(PkBackendJob *job);
 	~ZyppJob();
 	zypp::ZYpp::Ptr get_zypp();
+ private:
+	PkBackendJob *_job;
+	gboolean _exclusive;
+	gboolean _refresh_failed;
+	ZyppJobReport _report;
+	void lock_shared();
+	gboolean prepare_pool();
 };
 
 enum PkgSearchType {
@@ -184,23 +204,27 @@ namespace ZyppBackend
 class PkBackendZYppPrivate;
 static PkBackendZYppPrivate *priv = 0;
 
+/* the report state of the job running on the current thread; zypp emits
+ * its callbacks from the thread doing the work, so this routes each report
+ * to the job that caused it even when several jobs are running */
+static GPrivate _current_report;
+
 class ZyppBackendReceiver
 {
 public:
-	PkBackendJob *_job;
-	gchar *_package_id;
-	guint _sub_percentage;
+	ZyppJobReport *report () const {
+		return (ZyppJobReport *) g_private_get (&_current_report);
+	}
 
-	ZyppBackendReceiver() {
-		_job = NULL;
-		_package_id = NULL;
-		_sub_percentage = 0;
+	PkBackendJob *job () const {
+		ZyppJobReport *r = report ();
+		return r != NULL ? r->job : NULL;
 	}
 
 	virtual void clear_package_id () {
-		if (_package_id != NULL) {
-			g_free (_package_id);
-			_package_id = NULL;
+		if (report ()->package_id != NULL) {
+			g_free (report ()->package_id);
+			report ()->package_id = NULL;
 		}
 	}
 
@@ -215,11 +239,11 @@ public:
 		// fact that libzypp may skip over a "divisible by ten"
 		// value (i.e., 28, 29, 31, 32).
 
-		//MIL << percentage << " " << _sub_percentage << std::endl;
-		if (percentage == _sub_percentage)
+		//MIL << percentage << " " << report ()->sub_percentage << std::endl;
+		if (percentage == report ()->sub_percentage)
 			return;
 
-		if (!_package_id) {
+		if (!report ()->package_id) {
 			MIL << "percentage without package" << std::endl;
 			return;
 		}
@@ -229,14 +253,14 @@ public:
 			return;
 		}
 		
-		_sub_percentage = percentage;
-		pk_backend_job_set_item_progress(_job, _package_id, status, _sub_percentage);
+		report ()->sub_percentage = percentage;
+		pk_backend_job_set_item_progress(job (), report ()->package_id, status, report ()->sub_percentage);
 	}
 	
 	void reset_sub_percentage ()
 	{
-		_sub_percentage = 0;
-		//pk_backend_set_sub_percentage (_backend, _sub_percentage);
+		report ()->sub_percentage = 0;
+		//pk_backend_set_sub_percentage (_backend, report ()->sub_percentage);
 	}
 	
 protected:
@@ -255,12 +279,12 @@ struct InstallResolvableReportReceiver : public zypp::callback::ReceiveReport<zy
 			_dl_progress = 0;
 			_dl_status = PK_INFO_ENUM_INSTALLING;
 		}
-		_package_id = zypp_build_package_id_from_resolvable (resolvable->satSolvable ());
-		MIL << resolvable << " " << _package_id << std::endl;
+		report ()->package_id = zypp_build_package_id_from_resolvable (resolvable->satSolvable ());
+		MIL << resolvable << " " << report ()->package_id << std::endl;
 		gchar* summary = g_strdup(zypp::asKind<zypp::ResObject>(resolvable)->summary().c_str ());
-		if (_package_id != NULL) {
-			pk_backend_job_set_status (_job, PK_STATUS_ENUM_INSTALL);
-			pk_backend_job_package (_job, PK_INFO_ENUM_INSTALLING, _package_id, summary);
+		if (report ()->package_id != NULL) {
+			pk_backend_job_set_status (job (), PK_STATUS_ENUM_INSTALL);
+			pk_backend_job_package (job (), PK_INFO_ENUM_INSTALLING, report ()->package_id, summary);
 			reset_sub_percentage ();
 		}
 		g_free (summary);
@@ -269,21 +293,21 @@ struct InstallResolvableReportReceiver : public zypp::callback::ReceiveReport<zy
 	virtual bool progress (int value, zypp::Resolvable::constPtr resolvable) {
 		// we need to have extra logic here as progress is reported twice
 		// and PackageKit does not like percentages going back
-		//MIL << value << " " << _package_id << std::endl;
+		//MIL << value << " " << report ()->package_id << std::endl;
 		update_sub_percentage (value, PK_STATUS_ENUM_INSTALL);
 		return true;
 	}
 
 	virtual Action problem (zypp::Resolvable::constPtr resolvable, Error error, const std::string &description, RpmLevel level) {
-		pk_backend_job_error_code (_job, PK_ERROR_ENUM_PACKAGE_FAILED_TO_INSTALL, "%s", description.c_str ());
+		pk_backend_job_error_code (job (), PK_ERROR_ENUM_PACKAGE_FAILED_TO_INSTALL, "%s", description.c_str ());
 		return ABORT;
 	}
 
 	virtual void finish (zypp::Resolvable::constPtr resolvable, Error error, const std::string &reason, RpmLevel level) {
-		MIL << reason << " " << _package_id << " " << resolvable << std::endl;
-		pk_backend_job_set_percentage(_job, (double)++_dl_progress / _dl_count * 100);
-		if (_package_id != NULL) {
-			//pk_backend_job_package (_backend, PK_INFO_ENUM_INSTALLED, _package_id, "TODO: Put the package summary here if possible");
+		MIL << reason << " " << report ()->package_id << " " << resolvable << std::endl;
+		pk_backend_job_set_percentage(job (), (double)++_dl_progress / _dl_count * 100);
+		if (report ()->package_id != NULL) {
+			//pk_backend_job_package (_backend, PK_INFO_ENUM_INSTALLED, report ()->package_id, "TODO: Put the package summary here if possible");
 			update_sub_percentage (100, PK_STATUS_ENUM_INSTALL);
 			clear_package_id ();
 		}
@@ -296,10 +320,10 @@ struct RemoveResolvableReportReceiver : public zypp::callback::ReceiveReport<zyp
 
 	virtual void start (zypp::Resolvable::constPtr resolvable) {
 		clear_package_id ();
-		_package_id = zypp_build_package_id_from_resolvable (resolvable->satSolvable ());
-		if (_package_id != NULL) {
-			pk_backend_job_set_status (_job, PK_STATUS_ENUM_REMOVE);
-			pk_backend_job_package (_job, PK_INFO_ENUM_REMOVING, _package_id, "");
+		report ()->package_id = zypp_build_package_id_from_resolvable (resolvable->satSolvable ());
+		if (report ()->package_id != NULL) {
+			pk_backend_job_set_status (job (), PK_STATUS_ENUM_REMOVE);
+			pk_backend_job_package (job (), PK_INFO_ENUM_REMOVING, report ()->package_id, "");
 			reset_sub_percentage ();
 		}
 	}
@@ -310,13 +334,13 @@ struct RemoveResolvableReportReceiver : public zypp::callback::ReceiveReport<zyp
 	}
 
 	virtual Action problem (zypp::Resolvable::constPtr resolvable, Error error, const std::string &description) {
-                pk_backend_job_error_code (_job, PK_ERROR_ENUM_CANNOT_REMOVE_SYSTEM_PACKAGE, "%s", description.c_str ());
+                pk_backend_job_error_code (job (), PK_ERROR_ENUM_CANNOT_REMOVE_SYSTEM_PACKAGE, "%s", description.c_str ());
 		return ABORT;
 	}
 
 	virtual void finish (zypp::Resolvable::constPtr resolvable, Error error, const std::string &reason) {
-		if (_package_id != NULL) {
-			pk_backend_job_package (_job, PK_INFO_ENUM_FINISHED, _package_id, "");
+		if (report ()->package_id != NULL) {
+			pk_backend_job_package (job (), PK_INFO_ENUM_FINISHED, report ()->package_id, "");
 			clear_package_id ();
 		}
 	}
@@ -375,14 +399,14 @@ struct DownloadProgressReportReceiver : public zypp::callback::ReceiveReport<zyp
 			_dl_progress = 0;
 			_dl_status = PK_INFO_ENUM_DOWNLOADING;
 		}
-		_package_id = zypp_build_package_id_from_resolvable (resolvable->satSolvable ());
+		report ()->package_id = zypp_build_package_id_from_resolvable (resolvable->satSolvable ());
 		gchar* summary = g_strdup(zypp::asKind<zypp::ResObject>(resolvable)->summary().c_str ());
 
 		fprintf (stderr, "DownloadProgressReportReceiver::start():%s --%s\n",
-			 g_strdup (file.asString().c_str()),	_package_id);
-		if (_package_id != NULL) {
-			pk_backend_job_set_status (_job, PK_STATUS_ENUM_DOWNLOAD); 
-			pk_backend_job_package (_job, PK_INFO_ENUM_DOWNLOADING, _package_id, summary);
+			 g_strdup (file.asString().c_str()),	report ()->package_id);
+		if (report ()->package_id != NULL) {
+			pk_backend_job_set_status (job (), PK_STATUS_ENUM_DOWNLOAD); 
+			pk_backend_job_package (job (), PK_INFO_ENUM_DOWNLOADING, report ()->package_id, summary);
 			reset_sub_percentage ();
 		}
 		g_free(summary);
@@ -390,17 +414,17 @@ struct DownloadProgressReportReceiver : public zypp::callback::ReceiveReport<zyp
 
 	virtual bool progress (int value, zypp::Resolvable::constPtr resolvable)
 	{
-		//MIL << resolvable << " " << value << " " << _package_id << std::endl;
+		//MIL << resolvable << " " << value << " " << report ()->package_id << std::endl;
 		update_sub_percentage (value, PK_STATUS_ENUM_DOWNLOAD);
-		//pk_backend_job_set_speed (_job, static_cast<guint>(dbps_current));
+		//pk_backend_job_set_speed (job (), static_cast<guint>(dbps_current));
 		return true;
 	}
 
 	virtual void finish (zypp::Resolvable::constPtr resolvable, Error error, const std::string &konreason)
 	{
-		MIL << resolvable << " " << error << " " << _package_id << std::endl;
+		MIL << resolvable << " " << error << " " << report ()->package_id << std::endl;
 		update_sub_percentage (100, PK_STATUS_ENUM_DOWNLOAD);
-		pk_backend_job_set_percentage(_job, (double)++_dl_progress / _dl_count * 100);
+		pk_backend_job_set_percentage(job (), (double)++_dl_progress / _dl_count * 100);
 		clear_package_id ();
 	}
 };
@@ -409,7 +433,7 @@ struct MediaChangeReportReceiver : public zypp::callback::ReceiveReport<zypp::me
 {
 	virtual Action requestMedia (zypp::Url &url, unsigned mediaNr, const std::string &label, zypp::media::MediaChangeReport::Error error, const std::string &description, const std::vector<std::string> & devices, unsigned int &dev_current)
 	{
-		pk_backend_job_error_code (_job, PK_ERROR_ENUM_REPO_NOT_AVAILABLE, "%s", description.c_str ());
+		pk_backend_job_error_code (job (), PK_ERROR_ENUM_REPO_NOT_AVAILABLE, "%s", description.c_str ());
 		// We've to abort here, because there is currently no feasible way to inform the user to insert/change media
 		return ABORT;
 	}
@@ -475,13 +499,13 @@ struct DigestReportReceiver : public zypp::callback::ReceiveReport<zypp::DigestR
 
 	virtual bool askUserToAcceptUnknownDigest (const zypp::Pathname &file, const std::string &name)
 	{
-		pk_backend_job_error_code(_job, PK_ERROR_ENUM_GPG_FAILURE, "Repo: %s Digest: %s", file.c_str (), name.c_str ());
+		pk_backend_job_error_code(job (), PK_ERROR_ENUM_GPG_FAILURE, "Repo: %s Digest: %s", file.c_str (), name.c_str ());
 		return zypp_signature_required(file.asString ());
 	}
 
 	virtual bool askUserToAcceptWrongDigest (const zypp::Pathname &file, const std::string &requested, const std::string &found)
 	{
-		pk_backend_job_error_code(_job, PK_ERROR_ENUM_GPG_FAILURE, "For repo %s %s is requested but %s was found!",
+		pk_backend_job_error_code(job (), PK_ERROR_ENUM_GPG_FAILURE, "For repo %s %s is requested but %s was found!",
 				file.c_str (), requested.c_str (), found.c_str ());
 		return zypp_signature_required(file.asString ());
 	}
@@ -514,17 +538,9 @@ class EventDirector
                         _progressReport.connect ();
 		}
 
-		void setJob(PkBackendJob *job)
+		void setReport(ZyppJobReport *report)
 		{
-			_repoReport._job = job;
-			_repoProgressReport._job = job;
-			_installResolvableReport._job = job;
-			_removeResolvableReport._job = job;
-			_downloadProgressReport._job = job;
-                        _keyRingReport._job = job;
-			_digestReport._job = job;
-                        _mediaChangeReport._job = job;
-                        _progressReport._job = job;	
+			g_private_set (&_current_report, report);
 		}
 
 		~EventDirector ()
@@ -545,37 +561,217 @@ class PkBackendZYppPrivate {
  public:
 	std::vector<std::string> signatures;
 	EventDirector eventDirector;
-	PkBackendJob *currentJob;
-	
-	pthread_mutex_t zypp_mutex;
+
+	/* a reader/writer lock which can be downgraded, readers wait
+	 * for queued writers so these are not starved */
+	GMutex zypp_mutex;
+	GCond zypp_cond;
+	guint readers;
+	guint writers_waiting;
+	gboolean writer;
+	/* the pool is only modified with the lock held for writing */
+	gboolean pool_ready;
 };
 
 }; // namespace ZyppBackend
 
 using namespace ZyppBackend;
 
-ZyppJob::ZyppJob(PkBackendJob *job)
+ResPool zypp_build_pool (ZYpp::Ptr zypp, gboolean include_local);
+static gboolean zypp_refresh_cache (PkBackendJob *job, ZYpp::Ptr zypp, gboolean force);
+
+/**
+ * Roles which only look at the pool and never change the target,
+ * the repositories or the resolver state. RequiredBy is not one of
+ * them: it marks packages for removal and runs the resolver.
+ */
+static gboolean
+zypp_role_is_read_only (PkRoleEnum role)
 {
-	MIL << "locking zypp" << std::endl;
-	pthread_mutex_lock(&priv->zypp_mutex);
+	switch (role) {
+	case PK_ROLE_ENUM_DEPENDS_ON:
+	case PK_ROLE_ENUM_GET_DETAILS:
+	case PK_ROLE_ENUM_GET_DISTRO_UPGRADES:
+	case PK_ROLE_ENUM_GET_FILES:
+	case PK_ROLE_ENUM_GET_PACKAGES:
+	case PK_ROLE_ENUM_GET_UPDATE_DETAIL:
+	case PK_ROLE_ENUM_RESOLVE:
+	case PK_ROLE_ENUM_SEARCH_DETAILS:
+	case PK_ROLE_ENUM_SEARCH_FILE:
+	case PK_ROLE_ENUM_SEARCH_GROUP:
+	case PK_ROLE_ENUM_SEARCH_NAME:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
 
-	if (priv->currentJob) {
-		MIL << "currentjob is already defined - highly impossible" << endl;
+/**
+ * Read-only roles which refresh the expired repos before they look
+ * at the pool.
+ */
+static gboolean
+zypp_role_refreshes (PkRoleEnum role)
+{
+	switch (role) {
+	case PK_ROLE_ENUM_GET_DISTRO_UPGRADES:
+	case PK_ROLE_ENUM_SEARCH_DETAILS:
+	case PK_ROLE_ENUM_SEARCH_FILE:
+	case PK_ROLE_ENUM_SEARCH_NAME:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+static void
+zypp_lock_exclusive ()
+{
+	g_mutex_lock (&priv->zypp_mutex);
+	priv->writers_waiting++;
+	while (priv->writer || priv->readers > 0)
+		g_cond_wait (&priv->zypp_cond, &priv->zypp_mutex);
+	priv->writers_waiting--;
+	priv->writer = TRUE;
+	g_mutex_unlock (&priv->zypp_mutex);
+}
+
+static void
+zypp_lock_shared ()
+{
+	g_mutex_lock (&priv->zypp_mutex);
+	while (priv->writer || priv->writers_waiting > 0)
+		g_cond_wait (&priv->zypp_cond, &priv->zypp_mutex);
+	priv->readers++;
+	g_mutex_unlock (&priv->zypp_mutex);
+}
+
+/**
+ * Turn the exclusive lock into a shared one without letting a
+ * writer in between, so the pool we just built is the one we read.
+ */
+static void
+zypp_lock_downgrade ()
+{
+	g_mutex_lock (&priv->zypp_mutex);
+	priv->writer = FALSE;
+	priv->readers++;
+	g_cond_broadcast (&priv->zypp_cond);
+	g_mutex_unlock (&priv->zypp_mutex);
+}
+
+static void
+zypp_unlock ()
+{
+	g_mutex_lock (&priv->zypp_mutex);
+	if (priv->writer)
+		priv->writer = FALSE;
+	else
+		priv->readers--;
+	g_cond_broadcast (&priv->zypp_cond);
+	g_mutex_unlock (&priv->zypp_mutex);
+}
+
+ZyppJob::ZyppJob(PkBackendJob *job)
+{
+	_job = job;
+	_exclusive = !zypp_role_is_read_only (pk_backend_job_get_role (job));
+	_refresh_failed = FALSE;
+	_report.job = job;
+	_report.package_id = NULL;
+	_report.sub_percentage = 0;
+	priv->eventDirector.setReport(&_report);
+
+	if (_exclusive) {
+		MIL << "locking zypp" << std::endl;
+		zypp_lock_exclusive ();
+		pk_backend_job_set_locked(job, true);
+	} else {
+		MIL << "locking zypp for reading" << std::endl;
+		lock_shared();
 	}
-	
-	pk_backend_job_set_locked(job, true);
-	priv->currentJob = job;
-	priv->eventDirector.setJob(job);
 }
 
 ZyppJob::~ZyppJob()
 {
-	if (priv->currentJob)
-		pk_backend_job_set_locked(priv->currentJob, false);
-	priv->currentJob = 0;
-	priv->eventDirector.setJob(0);
+	if (_exclusive) {
+		pk_backend_job_set_locked(_job, false);
+		// whatever we did, the next reader has to rebuild the pool
+		priv->pool_ready = FALSE;
+	}
+	priv->eventDirector.setReport(NULL);
+	g_free (_report.package_id);
 	MIL << "unlocking zypp" << std::endl;
-	pthread_mutex_unlock(&priv->zypp_mutex);
+	zypp_unlock ();
+}
+
+/**
+ * Take the shared lock, building the pool first if a writer ran since
+ * it was last built, and refreshing the repos first for the roles that
+ * always did. The pool is only ever modified with the lock held for
+ * writing, so once we hold it shared it stays untouched until we
+ * release it.
+ */
+void
+ZyppJob::lock_shared()
+{
+	gboolean refresh = zypp_role_refreshes (pk_backend_job_get_role (_job));
+
+	if (!refresh) {
+		zypp_lock_shared ();
+		if (priv->pool_ready)
+			return;
+		zypp_unlock ();
+	}
+
+	zypp_lock_exclusive ();
+	if (refresh) {
+		ZYpp::Ptr zypp = get_zypp();
+
+		// this reloads the target, so the pool has to be built again
+		priv->pool_ready = FALSE;
+		if (zypp == NULL || !zypp_refresh_cache (_job, zypp, FALSE)) {
+			// the error is already set, get_zypp() makes the job stop
+			_refresh_failed = TRUE;
+			_exclusive = TRUE;
+			pk_backend_job_set_locked(_job, true);
+			return;
+		}
+	}
+	if (!priv->pool_ready && !prepare_pool ()) {
+		// keep the lock exclusive, so that the job building the
+		// pool on its own can never race other readers
+		MIL << "no shared pool, running exclusively" << std::endl;
+		_exclusive = TRUE;
+		pk_backend_job_set_locked(_job, true);
+		return;
+	}
+	zypp_lock_downgrade ();
+}
+
+/**
+ * Load the target and the cached repos into the pool. This never
+ * refreshes the repos, that is left to the roles which hold the lock
+ * exclusively anyway.
+ * Must be called with the lock held for writing.
+ */
+gboolean
+ZyppJob::prepare_pool()
+{
+	MIL << "rebuilding shared pool" << std::endl;
+
+	ZYpp::Ptr zypp = get_zypp();
+	if (zypp == NULL)
+		return FALSE;
+
+	zypp_build_pool (zypp, TRUE);
+
+	// build the lazily created indexes now, so readers never do
+	sat::Pool::instance ().prepare ();
+	zypp->pool ().proxy ();
+
+	priv->pool_ready = TRUE;
+	return TRUE;
 }
 
 /**
@@ -587,6 +783,9 @@ ZyppJob::get_zypp()
 	static gboolean initialized = FALSE;
 	ZYpp::Ptr zypp = NULL;
 
+	if (_refresh_failed)
+		return NULL;
+
 	try {
 		zypp = ZYppFactory::instance ().getZYpp ();
 
@@ -599,10 +798,10 @@ ZyppJob::get_zypp()
 			initialized = TRUE;
 		}
 	} catch (const ZYppFactoryException &ex) {
-		pk_backend_job_error_code (priv->currentJob, PK_ERROR_ENUM_FAILED_INITIALIZATION, "%s", ex.asUserString().c_str() );
+		pk_backend_job_error_code (_job, PK_ERROR_ENUM_FAILED_INITIALIZATION, "%s", ex.asUserString().c_str() );
 		return NULL;
 	} catch (const Exception &ex) {
-		pk_backend_job_error_code (priv->currentJob, PK_ERROR_ENUM_INTERNAL_ERROR, "%s", ex.asUserString().c_str() );
+		pk_backend_job_error_code (_job, PK_ERROR_ENUM_INTERNAL_ERROR, "%s", ex.asUserString().c_str() );
 		return NULL;
 	}
 
@@ -1672,12 +1871,13 @@ zypp_backend_finished_error (PkBackendJob  *job, PkErrorEnum err_code,
 
 
 /**
- * We do not pretend we're thread safe when all we do is having a huge mutex
+ * Read-only roles share the pool, everything else is serialized by
+ * ZyppJob taking the zypp lock exclusively
  */
 gboolean
 pk_backend_supports_parallelization (PkBackend *backend)
 {
-        return FALSE;
+	return TRUE;
 }
 
 
@@ -1711,8 +1911,12 @@ pk_backend_initialize (GKeyFile *conf, PkBackend *backend)
 {
 	/* create private area */
 	priv = new PkBackendZYppPrivate;
-	priv->currentJob = 0;
-	priv->zypp_mutex = PTHREAD_MUTEX_INITIALIZER;
+	g_mutex_init (&priv->zypp_mutex);
+	g_cond_init (&priv->zypp_cond);
+	priv->readers = 0;
+	priv->writers_waiting = 0;
+	priv->writer = FALSE;
+	priv->pool_ready = FALSE;
 	zypp_logging ();
 
 	g_debug ("zypp_backend_initialize");
@@ -1728,6 +1932,8 @@ pk_backend_destroy (PkBackend *backend)
 	g_debug ("zypp_backend_destroy");
 
 	g_free (_repoName);
+	g_mutex_clear (&priv->zypp_mutex);
+	g_cond_clear (&priv->zypp_cond);
 	delete priv;
 }
 
@@ -2101,11 +2307,7 @@ backend_get_distro_upgrades_thread(PkBackendJob *job, GVariant *params, gpointer
 	}
 	pk_backend_job_set_status (job, PK_STATUS_ENUM_QUERY);
 
-	// refresh the repos before checking for updates
-	if (!zypp_refresh_cache (job, zypp, FALSE)) {
-		return;
-	}
-
+	// the repos were refreshed before the shared lock was granted
 	vector<parser::ProductFileData> result;
 	if (!parser::ProductFileReader::scanDir (functor::getAll (back_inserter (result)), "/etc/products.d")) {
 		zypp_backend_finished_error (job, PK_ERROR_ENUM_INTERNAL_ERROR, 
@@ -2785,11 +2987,7 @@ backend_find_packages_thread (PkBackendJob *job, GVariant *params, gpointer user
 		return;
 	}
 
-	// refresh the repos before searching
-	if (!zypp_refresh_cache (job, zypp, FALSE)) {
-		return;
-	}
-
+	// the repos were refreshed before the shared lock was granted
 	search = values[0];  //Fixme - support the possible multiple values (logical OR search)
 	role = pk_backend_job_get_role(job);
 
@@ -3634,12 +3832,12 @@ ZyppBackend::ZyppBackendReceiver::zypp_signature_required (const PublicKey &key)
 	bool ok = false;
 
 	if (find (priv->signatures.begin (), priv->signatures.end (), key.id ()) == priv->signatures.end ()) {
-		RepoInfo info = zypp_get_Repository (_job, _repoName);
+		RepoInfo info = zypp_get_Repository (job (), _repoName);
 		if (info.type () == repo::RepoType::NONE)
-			pk_backend_job_error_code (_job, PK_ERROR_ENUM_INTERNAL_ERROR,
+			pk_backend_job_error_code (job (), PK_ERROR_ENUM_INTERNAL_ERROR,
 						   "Repository unknown");
 		else {
-			pk_backend_job_repo_signature_required (_job,
+			pk_backend_job_repo_signature_required (job (),
 								"dummy;0.0.1;i386;data",
 								_repoName,
 								info.baseUrlsBegin ()->asString ().c_str (),
@@ -3648,7 +3846,7 @@ ZyppBackend::ZyppBackendReceiver::zypp_signature_required (const PublicKey &key)
 								key.fingerprint ().c_str (),
 								key.created ().asString ().c_str (),
 								PK_SIGTYPE_ENUM_GPG);
-			pk_backend_job_error_code (_job, PK_ERROR_ENUM_GPG_FAILURE,
+			pk_backend_job_error_code (job (), PK_ERROR_ENUM_GPG_FAILURE,
 						   "Signature verification for Repository %s failed", _repoName);
 		}
 		throw AbortTransactionException();
@@ -3667,12 +3865,12 @@ ZyppBackend::ZyppBackendReceiver::zypp_signature_required (const string &file, c
 	bool ok = false;
 
 	if (find (priv->signatures.begin (), priv->signatures.end (), id) == priv->signatures.end ()) {
-		RepoInfo info = zypp_get_Repository (_job, _repoName);
+		RepoInfo info = zypp_get_Repository (job (), _repoName);
 		if (info.type () == repo::RepoType::NONE)
-			pk_backend_job_error_code (_job, PK_ERROR_ENUM_INTERNAL_ERROR,
+			pk_backend_job_error_code (job (), PK_ERROR_ENUM_INTERNAL_ERROR,
 					       "Repository unknown");
 		else {
-			pk_backend_job_repo_signature_required (_job,
+			pk_backend_job_repo_signature_required (job (),
 				"dummy;0.0.1;i386;data",
 				_repoName,
 				info.baseUrlsBegin ()->asString ().c_str (),
@@ -3681,7 +3879,7 @@ ZyppBackend::ZyppBackendReceiver::zypp_signature_required (const string &file, c
 				"UNKNOWN",
 				"UNKNOWN",
 				PK_SIGTYPE_ENUM_GPG);
-			pk_backend_job_error_code (_job, PK_ERROR_ENUM_GPG_FAILURE,
+			pk_backend_job_error_code (job (), PK_ERROR_ENUM_GPG_FAILURE,
 					       "Signature verification for Repository %s failed", _repoName);
 		}
 		throw AbortTransactionException();
@@ -3700,12 +3898,12 @@ ZyppBackend::ZyppBackendReceiver::zypp_signature_required (const string &file)
 	bool ok = false;
 
 	if (find (priv->signatures.begin (), priv->signatures.end (), file) == priv->signatures.end ()) {
-		RepoInfo info = zypp_get_Repository (_job, _repoName);
+		RepoInfo info = zypp_get_Repository (job (), _repoName);
 		if (info.type () == repo::RepoType::NONE)
-			pk_backend_job_error_code (_job, PK_ERROR_ENUM_INTERNAL_ERROR,
+			pk_backend_job_error_code (job (), PK_ERROR_ENUM_INTERNAL_ERROR,
 					       "Repository unknown");
 		else {
-			pk_backend_job_repo_signature_required (_job,
+			pk_backend_job_repo_signature_required (job (),
 				"dummy;0.0.1;i386;data",
 				_repoName,
 				info.baseUrlsBegin ()->asString ().c_str (),
@@ -3714,7 +3912,7 @@ ZyppBackend::ZyppBackendReceiver::zypp_signature_required (const string &file)
 				"UNKNOWN",
 				"UNKNOWN",
 				PK_SIGTYPE_ENUM_GPG);
-			pk_backend_job_error_code (_job, PK_ERROR_ENUM_GPG_FAILURE,
+			pk_backend_job_error_code (job (), PK_ERROR_ENUM_GPG_FAILURE,
 					       "Signature verification for Repository %s failed", _repoName);
 		}
 		throw AbortTransactionException();
@@ -41,6 +41,9 @@
 
 #define PK_CONSOLE_ERROR	1
 
+/* the progress bar cannot usefully redraw faster than this */
+#define PK_CONSOLE_PROGRESS_INTERVAL	100 /* ms */
+
 typedef struct {
 	GCancellable	*cancellable;
 	GMainLoop	*loop;
@@ -53,6 +56,8 @@ typedef struct {
 	PkBitfield	 filters;
 	guint		 defered_status_id;
 	PkStatusEnum	 defered_status;
+	gboolean	 stream;
+	guint		 items_streamed;
 } PkConsoleCtx;
 
 /**
@@ -526,6 +531,54 @@ pk_console_files_cb (PkFiles *item, gpointer data)
 		g_print ("  %s\n", files[i]);
 }
 
+/**
+ * pk_console_item_cb:
+ *
+ * Prints each result item as it arrives when using --stream.
+ **/
+static void
+pk_console_item_cb (PkSource *item, gpointer data)
+{
+	PkConsoleCtx *ctx = (PkConsoleCtx *) data;
+
+	/* TRANSLATORS: the results from the transaction */
+	if (ctx->items_streamed++ == 0)
+		g_print ("%s\n", _("Results:"));
+
+	if (PK_IS_PACKAGE (item))
+		pk_console_package_cb (PK_PACKAGE (item), ctx);
+	else if (PK_IS_TRANSACTION_PAST (item))
+		pk_console_transaction_cb (PK_TRANSACTION_PAST (item), ctx);
+	else if (PK_IS_DISTRO_UPGRADE (item))
+		pk_console_distro_upgrade_cb (PK_DISTRO_UPGRADE (item), ctx);
+	else if (PK_IS_CATEGORY (item))
+		pk_console_category_cb (PK_CATEGORY (item), ctx);
+	else if (PK_IS_UPDATE_DETAIL (item))
+		pk_console_update_detail_cb (PK_UPDATE_DETAIL (item), ctx);
+	else if (PK_IS_REPO_DETAIL (item))
+		pk_console_repo_detail_cb (PK_REPO_DETAIL (item), ctx);
+	else if (PK_IS_DETAILS (item))
+		pk_console_details_cb (PK_DETAILS (item), ctx);
+	else if (PK_IS_FILES (item))
+		pk_console_files_cb (PK_FILES (item), ctx);
+}
+
+/**
+ * pk_console_set_streaming:
+ *
+ * Turns off streaming while pkcon needs the complete results itself, for
+ * instance when resolving package names.
+ **/
+static void
+pk_console_set_streaming (PkConsoleCtx *ctx, gboolean enabled)
+{
+	if (!ctx->stream)
+		return;
+	pk_client_set_item_callback (PK_CLIENT (ctx->task),
+				     enabled ? pk_console_item_cb : NULL,
+				     ctx);
+}
+
 /**
  * pk_console_defer_status_update_cb:
  **/
@@ -691,7 +744,7 @@ pk_console_finished_cb (GObject *object, GAsyncResult *res, gpointer data)
 	/* no more progress */
 	if (ctx->is_console) {
 		pk_progress_bar_end (ctx->progressbar);
-	} else {
+	} else if (!ctx->stream) {
 		/* TRANSLATORS: the results from the transaction */
 		g_print ("%s\n", _("Results:"));
 	}
@@ -754,7 +807,7 @@ pk_console_finished_cb (GObject *object, GAsyncResult *res, gpointer data)
 	}
 
 	/* special case */
-	if (array->len == 0 &&
+	if (array->len == 0 && ctx->items_streamed == 0 &&
 	    (role == PK_ROLE_ENUM_GET_UPDATES ||
 	     role == PK_ROLE_ENUM_UPDATE_PACKAGES)) {
 		/* TRANSLATORS: print a message when there are no updates */
@@ -770,7 +823,7 @@ pk_console_finished_cb (GObject *object, GAsyncResult *res, gpointer data)
 	g_ptr_array_foreach (array, (GFunc) pk_console_transaction_cb, ctx);
 
 	/* special case */
-	if (array->len == 0 && role == PK_ROLE_ENUM_GET_OLD_TRANSACTIONS)
+	if (array->len == 0 && ctx->items_streamed == 0 && role == PK_ROLE_ENUM_GET_OLD_TRANSACTIONS)
 		ctx->retval = PK_EXIT_CODE_NOTHING_USEFUL;
 
 	g_ptr_array_unref (array);
@@ -780,7 +833,7 @@ pk_console_finished_cb (GObject *object, GAsyncResult *res, gpointer data)
 	g_ptr_array_foreach (array, (GFunc) pk_console_distro_upgrade_cb, ctx);
 
 	/* special case */
-	if (array->len == 0 && role == PK_ROLE_ENUM_GET_DISTRO_UPGRADES) {
+	if (array->len == 0 && ctx->items_streamed == 0 && role == PK_ROLE_ENUM_GET_DISTRO_UPGRADES) {
 		g_print ("%s\n", _("There are no upgrades available at this time."));
 		ctx->retval = PK_EXIT_CODE_NOTHING_USEFUL;
 	}
@@ -792,7 +845,7 @@ pk_console_finished_cb (GObject *object, GAsyncResult *res, gpointer data)
 	g_ptr_array_foreach (array, (GFunc) pk_console_category_cb, ctx);
 
 	/* special case */
-	if (array->len == 0 && role == PK_ROLE_ENUM_GET_CATEGORIES)
+	if (array->len == 0 && ctx->items_streamed == 0 && role == PK_ROLE_ENUM_GET_CATEGORIES)
 		ctx->retval = PK_EXIT_CODE_NOTHING_USEFUL;
 
 	g_ptr_array_unref (array);
@@ -802,7 +855,7 @@ pk_console_finished_cb (GObject *object, GAsyncResult *res, gpointer data)
 	g_ptr_array_foreach (array, (GFunc) pk_console_update_detail_cb, ctx);
 
 	/* special case */
-	if (array->len == 0 && role == PK_ROLE_ENUM_GET_UPDATE_DETAIL)
+	if (array->len == 0 && ctx->items_streamed == 0 && role == PK_ROLE_ENUM_GET_UPDATE_DETAIL)
 		ctx->retval = PK_EXIT_CODE_NOTHING_USEFUL;
 
 	g_ptr_array_unref (array);
@@ -812,7 +865,7 @@ pk_console_finished_cb (GObject *object, GAsyncResult *res, gpointer data)
 	g_ptr_array_foreach (array, (GFunc) pk_console_repo_detail_cb, ctx);
 
 	/* special case */
-	if (array->len == 0 && role == PK_ROLE_ENUM_GET_REPO_LIST)
+	if (array->len == 0 && ctx->items_streamed == 0 && role == PK_ROLE_ENUM_GET_REPO_LIST)
 		ctx->retval = PK_EXIT_CODE_NOTHING_USEFUL;
 
 	g_ptr_array_unref (array);
@@ -827,7 +880,7 @@ pk_console_finished_cb (GObject *object, GAsyncResult *res, gpointer data)
 	g_ptr_array_foreach (array, (GFunc) pk_console_details_cb, ctx);
 
 	/* special case */
-	if (array->len == 0 && role == PK_ROLE_ENUM_GET_DETAILS)
+	if (array->len == 0 && ctx->items_streamed == 0 && role == PK_ROLE_ENUM_GET_DETAILS)
 		ctx->retval = PK_EXIT_CODE_NOTHING_USEFUL;
 
 	g_ptr_array_unref (array);
@@ -894,11 +947,13 @@ pk_console_resolve_package (PkConsoleCtx *ctx, const gchar *package_name, GError
 	tmp = g_strsplit (package_name, ",", -1);
 
 	/* get the list of possibles */
+	pk_console_set_streaming (ctx, FALSE);
 	results = pk_client_resolve (PK_CLIENT (ctx->task),
 				     ctx->filters, tmp,
 				     ctx->cancellable,
 				     pk_console_progress_cb, ctx,
 				     error);
+	pk_console_set_streaming (ctx, TRUE);
 	if (results == NULL)
 		return NULL;
 
@@ -1180,11 +1235,13 @@ pk_console_update_system (PkConsoleCtx *ctx, GError **error)
 
 	/* get the current updates */
 	pk_bitfield_add (ctx->filters, PK_FILTER_ENUM_NEWEST);
+	pk_console_set_streaming (ctx, FALSE);
 	results = pk_task_get_updates_sync (PK_TASK (ctx->task),
 					    ctx->filters,
 					    ctx->cancellable,
 					    pk_console_progress_cb, ctx,
 					    error);
+	pk_console_set_streaming (ctx, TRUE);
 	if (results == NULL)
 		return FALSE;
 
@@ -1676,6 +1733,7 @@ main (int argc, char *argv[])
 	guint cache_age = G_MAXUINT;
 	gint retval_copy = 0;
 	gboolean plain = FALSE;
+	gboolean stream = FALSE;
 	gboolean allow_untrusted = FALSE;
 	gboolean program_version = FALSE;
 	gboolean run_mainloop = TRUE;
@@ -1715,6 +1773,9 @@ main (int argc, char *argv[])
 		{ "plain", 'p', 0, G_OPTION_ARG_NONE, &plain,
 			/* TRANSLATORS: command line argument, just output without fancy formatting */
 			_("Print to screen a machine readable output, rather than using animated widgets"), NULL},
+		{ "stream", '\0', 0, G_OPTION_ARG_NONE, &stream,
+			/* TRANSLATORS: command line argument, print results as they arrive */
+			_("Print each result as soon as it arrives, without sorting or keeping them all in memory"), NULL},
 		{ "cache-age", 'c', 0, G_OPTION_ARG_INT, &cache_age,
 			/* TRANSLATORS: command line argument, just output without fancy formatting */
 			_("The maximum metadata cache age. Use -1 for 'never'."), NULL},
@@ -1776,8 +1837,10 @@ main (int argc, char *argv[])
 	g_option_context_set_summary (context, summary) ;
 	options_help = g_option_context_get_help (context, TRUE, NULL);
 
-	/* check if we are on console */
-	if (!plain && isatty (fileno (stdout)) == 1)
+	/* check if we are on console, streamed results would mix with the
+	 * animated progress bar so they imply plain output */
+	ctx->stream = stream;
+	if (!plain && !stream && isatty (fileno (stdout)) == 1)
 		ctx->is_console = TRUE;
 
 	if (program_version) {
@@ -1807,6 +1870,13 @@ main (int argc, char *argv[])
 		      "cache-age", cache_age,
 		      "only-trusted", !allow_untrusted,
 		      NULL);
+	pk_console_set_streaming (ctx, TRUE);
+
+	/* plain output prints every package, so only limit the bar */
+	if (ctx->is_console) {
+		pk_client_set_progress_interval (PK_CLIENT (ctx->task),
+						 PK_CONSOLE_PROGRESS_INTERVAL);
+	}
 
 	/* set the proxy */
 	ret = pk_console_set_proxy (ctx, &error);
@@ -38,12 +38,14 @@
 
 #include <packagekit-glib2/pk-client.h>
 #include <packagekit-glib2/pk-client-helper.h>
+#include <packagekit-glib2/pk-client-private.h>
 #include <packagekit-glib2/pk-common.h>
 #include <packagekit-glib2/pk-control.h>
 #include <packagekit-glib2/pk-debug.h>
 #include <packagekit-glib2/pk-enum.h>
 #include <packagekit-glib2/pk-package-id.h>
 #include <packagekit-glib2/pk-package-ids.h>
+#include <packagekit-glib2/pk-results-private.h>
 
 static void     pk_client_finalize	(GObject     *object);
 
@@ -66,6 +68,10 @@ struct _PkClientPrivate
 	gboolean		 interactive;
 	gboolean		 idle;
 	guint			 cache_age;
+	guint			 progress_interval;
+	gchar			*plan_token;
+	PkClientItemCallback	 item_callback;
+	gpointer		 item_user_data;
 };
 
 enum {
@@ -75,6 +81,7 @@ enum {
 	PROP_INTERACTIVE,
 	PROP_IDLE,
 	PROP_CACHE_AGE,
+	PROP_PROGRESS_INTERVAL,
 	PROP_LAST
 };
 
@@ -100,6 +107,7 @@ typedef struct {
 	gchar				*tid;
 	gchar				*distro_id;
 	gchar				*transaction_id;
+	gchar				*plan_token;
 	gchar				*value;
 	gpointer			 progress_user_data;
 	gpointer			 user_data;
@@ -114,12 +122,18 @@ typedef struct {
 	PkClient			*client;
 	PkProgress			*progress;
 	PkProgressCallback		 progress_callback;
+	guint				 progress_pending;
+	gint64				 progress_emitted;
+	GSource				*progress_source;
 	PkResults			*results;
 	PkRoleEnum			 role;
 	PkSigTypeEnum			 type;
 	PkUpgradeKindEnum		 upgrade_kind;
 	guint				 refcount;
 	PkClientHelper			*client_helper;
+	GPtrArray			*hints;
+	GVariant			*properties;
+	guint				 properties_changed_id;
 } PkClientState;
 
 static void
@@ -168,6 +182,9 @@ pk_client_get_property (GObject *object, guint prop_id, GValue *value, GParamSpe
 	case PROP_CACHE_AGE:
 		g_value_set_uint (value, priv->cache_age);
 		break;
+	case PROP_PROGRESS_INTERVAL:
+		g_value_set_uint (value, priv->progress_interval);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -197,6 +214,9 @@ pk_client_set_property (GObject *object, guint prop_id, const GValue *value, GPa
 	case PROP_CACHE_AGE:
 		priv->cache_age = g_value_get_uint (value);
 		break;
+	case PROP_PROGRESS_INTERVAL:
+		priv->progress_interval = g_value_get_uint (value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -388,6 +408,134 @@ pk_client_percentage_to_signed (guint percentage)
 	return (gint) percentage;
 }
 
+/**
+ * pk_client_progress_type_can_coalesce:
+ *
+ * Only the values that change many times a second are held back, the
+ * status, role and the rest are sent as soon as they change.
+ **/
+static gboolean
+pk_client_progress_type_can_coalesce (PkProgressType type)
+{
+	switch (type) {
+	case PK_PROGRESS_TYPE_PACKAGE_ID:
+	case PK_PROGRESS_TYPE_PACKAGE:
+	case PK_PROGRESS_TYPE_PERCENTAGE:
+	case PK_PROGRESS_TYPE_ITEM_PROGRESS:
+	case PK_PROGRESS_TYPE_ELAPSED_TIME:
+	case PK_PROGRESS_TYPE_REMAINING_TIME:
+	case PK_PROGRESS_TYPE_SPEED:
+	case PK_PROGRESS_TYPE_DOWNLOAD_SIZE_REMAINING:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/**
+ * pk_client_state_progress_emit:
+ **/
+static void
+pk_client_state_progress_emit (PkClientState *state, PkProgressType type)
+{
+	if (state->progress_callback == NULL)
+		return;
+	state->progress_callback (state->progress,
+				  type,
+				  state->progress_user_data);
+}
+
+/**
+ * pk_client_state_progress_flush:
+ *
+ * Sends the progress changes that were held back, once for each type.
+ **/
+static void
+pk_client_state_progress_flush (PkClientState *state)
+{
+	guint i;
+	guint pending = state->progress_pending;
+
+	if (state->progress_source != NULL) {
+		g_source_destroy (state->progress_source);
+		g_source_unref (state->progress_source);
+		state->progress_source = NULL;
+	}
+	if (pending == 0)
+		return;
+	state->progress_pending = 0;
+	state->progress_emitted = g_get_monotonic_time ();
+	g_object_thaw_notify (G_OBJECT (state->progress));
+	for (i = 0; i < PK_PROGRESS_TYPE_INVALID; i++) {
+		if ((pending & (1u << i)) > 0)
+			pk_client_state_progress_emit (state, i);
+	}
+}
+
+/**
+ * pk_client_state_progress_timeout_cb:
+ **/
+static gboolean
+pk_client_state_progress_timeout_cb (gpointer user_data)
+{
+	PkClientState *state = (PkClientState *) user_data;
+	pk_client_state_progress_flush (state);
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * pk_client_state_progress_changed:
+ *
+ * Runs the progress callback, or holds the change back if the client has
+ * a progress interval and the callback ran too recently. Changes that are
+ * held back are merged, and the PkProgress notify signals are frozen until
+ * they are sent.
+ **/
+static void
+pk_client_state_progress_changed (PkClientState *state, PkProgressType type)
+{
+	gint64 elapsed;
+	gint64 now;
+	guint interval = 0;
+
+	if (state->client != NULL)
+		interval = state->client->priv->progress_interval;
+
+	/* always sent straight away, after anything already held back */
+	if (interval == 0 || !pk_client_progress_type_can_coalesce (type)) {
+		pk_client_state_progress_flush (state);
+		pk_client_state_progress_emit (state, type);
+		return;
+	}
+
+	/* merge with the changes waiting for the timeout */
+	if (state->progress_pending != 0) {
+		state->progress_pending |= 1u << type;
+		return;
+	}
+
+	/* not sent anything recently */
+	now = g_get_monotonic_time ();
+	elapsed = (now - state->progress_emitted) / 1000;
+	if (elapsed >= interval) {
+		state->progress_emitted = now;
+		pk_client_state_progress_emit (state, type);
+		return;
+	}
+
+	/* hold back until the interval has passed, using the context
+	 * of the caller so this works with the sync methods */
+	g_object_freeze_notify (G_OBJECT (state->progress));
+	state->progress_pending = 1u << type;
+	state->progress_source = g_timeout_source_new (interval - elapsed);
+	g_source_set_callback (state->progress_source,
+			       pk_client_state_progress_timeout_cb,
+			       state, NULL);
+	g_source_set_name (state->progress_source, "[PkClient] progress");
+	g_source_attach (state->progress_source,
+			 g_main_context_get_thread_default ());
+}
+
 /**
  * pk_client_set_property_value:
  **/
@@ -403,11 +551,8 @@ pk_client_set_property_value (PkClientState *state,
 	if (g_strcmp0 (key, "Role") == 0) {
 		ret = pk_progress_set_role (state->progress,
 					    g_variant_get_uint32 (value));
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_ROLE,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_ROLE);
 		return;
 	}
 
@@ -415,11 +560,8 @@ pk_client_set_property_value (PkClientState *state,
 	if (g_strcmp0 (key, "Status") == 0) {
 		ret = pk_progress_set_status (state->progress,
 					      g_variant_get_uint32 (value));
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_STATUS,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_STATUS);
 		return;
 	}
 
@@ -432,11 +574,8 @@ pk_client_set_property_value (PkClientState *state,
 			return;
 		ret = pk_progress_set_package_id (state->progress,
 						  package_id);
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_PACKAGE_ID,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_PACKAGE_ID);
 		return;
 	}
 
@@ -444,11 +583,8 @@ pk_client_set_property_value (PkClientState *state,
 	if (g_strcmp0 (key, "Percentage") == 0) {
 		ret = pk_progress_set_percentage (state->progress,
 						  pk_client_percentage_to_signed (g_variant_get_uint32 (value)));
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_PERCENTAGE,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_PERCENTAGE);
 		return;
 	}
 
@@ -456,11 +592,8 @@ pk_client_set_property_value (PkClientState *state,
 	if (g_strcmp0 (key, "AllowCancel") == 0) {
 		ret = pk_progress_set_allow_cancel (state->progress,
 						  g_variant_get_boolean (value));
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_ALLOW_CANCEL,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_ALLOW_CANCEL);
 		return;
 	}
 
@@ -468,11 +601,8 @@ pk_client_set_property_value (PkClientState *state,
 	if (g_strcmp0 (key, "CallerActive") == 0) {
 		ret = pk_progress_set_caller_active (state->progress,
 						  g_variant_get_boolean (value));
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_CALLER_ACTIVE,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_CALLER_ACTIVE);
 		return;
 	}
 
@@ -480,11 +610,8 @@ pk_client_set_property_value (PkClientState *state,
 	if (g_strcmp0 (key, "ElapsedTime") == 0) {
 		ret = pk_progress_set_elapsed_time (state->progress,
 						  g_variant_get_uint32 (value));
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_ELAPSED_TIME,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_ELAPSED_TIME);
 		return;
 	}
 
@@ -492,11 +619,8 @@ pk_client_set_property_value (PkClientState *state,
 	if (g_strcmp0 (key, "RemainingTime") == 0) {
 		ret = pk_progress_set_elapsed_time (state->progress,
 						    g_variant_get_uint32 (value));
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_REMAINING_TIME,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_REMAINING_TIME);
 		return;
 	}
 
@@ -504,11 +628,8 @@ pk_client_set_property_value (PkClientState *state,
 	if (g_strcmp0 (key, "Speed") == 0) {
 		ret = pk_progress_set_speed (state->progress,
 					     g_variant_get_uint32 (value));
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_SPEED,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_SPEED);
 		return;
 	}
 
@@ -516,11 +637,8 @@ pk_client_set_property_value (PkClientState *state,
 	if (g_strcmp0 (key, "DownloadSizeRemaining") == 0) {
 		ret = pk_progress_set_download_size_remaining (state->progress,
 							       g_variant_get_uint64 (value));
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_DOWNLOAD_SIZE_REMAINING,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_DOWNLOAD_SIZE_REMAINING);
 		return;
 	}
 
@@ -528,11 +646,8 @@ pk_client_set_property_value (PkClientState *state,
 	if (g_strcmp0 (key, "TransactionFlags") == 0) {
 		ret = pk_progress_set_transaction_flags (state->progress,
 							 g_variant_get_uint64 (value));
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_TRANSACTION_FLAGS,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_TRANSACTION_FLAGS);
 		return;
 	}
 
@@ -540,11 +655,8 @@ pk_client_set_property_value (PkClientState *state,
 	if (g_strcmp0 (key, "Uid") == 0) {
 		ret = pk_progress_set_uid (state->progress,
 						  g_variant_get_uint32 (value));
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_UID,
-						  state->progress_user_data);
-		}
+		if (ret)
+			pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_UID);
 		return;
 	}
 
@@ -642,13 +754,13 @@ pk_client_state_finish (PkClientState *state, const GError *error)
 	gboolean ret;
 	g_autoptr(GError) error_local = NULL;
 
+	/* send anything held back by the progress interval */
+	pk_client_state_progress_flush (state);
+
 	/* force finished (if not already set) so clients can update the UI's */
 	ret = pk_progress_set_status (state->progress, PK_STATUS_ENUM_FINISHED);
-	if (ret && state->progress_callback != NULL) {
-		state->progress_callback (state->progress,
-					  PK_PROGRESS_TYPE_STATUS,
-					  state->progress_user_data);
-	}
+	if (ret)
+		pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_STATUS);
 
 	if (state->cancellable_id > 0) {
 		g_cancellable_disconnect (state->cancellable_client,
@@ -658,6 +770,10 @@ pk_client_state_finish (PkClientState *state, const GError *error)
 		g_object_unref (state->cancellable);
 
 	if (state->proxy != NULL) {
+		if (state->properties_changed_id > 0) {
+			g_dbus_connection_signal_unsubscribe (g_dbus_proxy_get_connection (state->proxy),
+							      state->properties_changed_id);
+		}
 		g_signal_handlers_disconnect_by_func (state->proxy,
 						      G_CALLBACK (pk_client_properties_changed_cb),
 						      state);
@@ -703,8 +819,11 @@ pk_client_state_finish (PkClientState *state, const GError *error)
 	g_free (state->tid);
 	g_free (state->distro_id);
 	g_free (state->transaction_id);
+	g_free (state->plan_token);
 	g_strfreev (state->files);
 	g_strfreev (state->package_ids);
+	if (state->hints != NULL)
+		g_ptr_array_unref (state->hints);
 	/* results will no exists if the CreateTransaction fails */
 	if (state->results != NULL)
 		g_object_unref (state->results);
@@ -738,6 +857,83 @@ pk_client_properties_changed_cb (GDBusProxy *proxy,
 	}
 }
 
+/**
+ * pk_client_properties_changed_signal_cb:
+ *
+ * PropertiesChanged for proxies that were created without loading the
+ * properties, as those do not listen for it themselves.
+ **/
+static void
+pk_client_properties_changed_signal_cb (GDBusConnection *connection,
+					const gchar *sender_name,
+					const gchar *object_path,
+					const gchar *interface_name,
+					const gchar *signal_name,
+					GVariant *parameters,
+					gpointer user_data)
+{
+	PkClientState *state = (PkClientState *) user_data;
+	GVariantIter iter;
+	GVariant *value;
+	const gchar *interface;
+	const gchar *name;
+	g_autofree const gchar **invalidated = NULL;
+	g_autoptr(GVariant) changed = NULL;
+
+	g_variant_get (parameters, "(&s@a{sv}^a&s)",
+		       &interface, &changed, &invalidated);
+
+	/* keep the cache current for anything reading it from the proxy */
+	g_variant_iter_init (&iter, changed);
+	while (g_variant_iter_next (&iter, "{&sv}", &name, &value)) {
+		g_dbus_proxy_set_cached_property (state->proxy, name, value);
+		g_variant_unref (value);
+	}
+	pk_client_properties_changed_cb (state->proxy, changed, invalidated, state);
+}
+
+/**
+ * pk_client_state_is_streaming:
+ *
+ * Return value: %TRUE if result items go to the item callback rather than
+ * being stored in the results
+ **/
+static gboolean
+pk_client_state_is_streaming (PkClientState *state)
+{
+	if (state->client == NULL)
+		return FALSE;
+	if (state->client->priv->item_callback == NULL)
+		return FALSE;
+
+	/* the simulated plan is consumed as a whole, e.g. by PkTask */
+	if (pk_bitfield_contain (state->transaction_flags,
+				 PK_TRANSACTION_FLAG_ENUM_SIMULATE))
+		return FALSE;
+
+	/* the downloaded files are copied using the results when finished */
+	if (state->role == PK_ROLE_ENUM_DOWNLOAD_PACKAGES)
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * pk_client_state_stream_item:
+ *
+ * Return value: %TRUE if the item was consumed and should not be stored
+ **/
+static gboolean
+pk_client_state_stream_item (PkClientState *state, PkSource *item)
+{
+	PkClientPrivate *priv;
+
+	if (!pk_client_state_is_streaming (state))
+		return FALSE;
+	priv = state->client->priv;
+	priv->item_callback (item, priv->item_user_data);
+	return TRUE;
+}
+
 /**
  * pk_client_signal_package:
  */
@@ -748,9 +944,45 @@ pk_client_signal_package (PkClientState *state,
 			  const gchar *summary)
 {
 	gboolean ret;
+	gboolean verb = TRUE;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(PkPackage) package = NULL;
 
+	/* only verb packages are needed as objects for the progress, so just
+	 * store the others as the result sets can be huge */
+	switch (info_enum) {
+	case PK_INFO_ENUM_DOWNLOADING:
+	case PK_INFO_ENUM_UPDATING:
+	case PK_INFO_ENUM_INSTALLING:
+	case PK_INFO_ENUM_REMOVING:
+	case PK_INFO_ENUM_CLEANUP:
+	case PK_INFO_ENUM_OBSOLETING:
+	case PK_INFO_ENUM_REINSTALLING:
+	case PK_INFO_ENUM_DOWNGRADING:
+	case PK_INFO_ENUM_PREPARING:
+	case PK_INFO_ENUM_DECOMPRESSING:
+	case PK_INFO_ENUM_FINISHED:
+		break;
+	default:
+		if (!pk_package_id_check (package_id)) {
+			g_warning ("failed to set package id for %s", package_id);
+			return;
+		}
+		if (pk_client_state_is_streaming (state)) {
+			verb = FALSE;
+			break;
+		}
+		if (state->results != NULL) {
+			pk_results_add_package_compact (state->results,
+							info_enum,
+							package_id,
+							summary,
+							state->role,
+							state->transaction_id);
+		}
+		return;
+	}
+
 	/* create virtual package */
 	package = pk_package_new ();
 	if (!pk_package_set_id (package, package_id, &error)) {
@@ -765,38 +997,21 @@ pk_client_signal_package (PkClientState *state,
 		      NULL);
 
 	/* add to results */
-	if (state->results != NULL && info_enum != PK_INFO_ENUM_FINISHED)
+	if (state->results != NULL && info_enum != PK_INFO_ENUM_FINISHED &&
+	    !pk_client_state_stream_item (state, PK_SOURCE (package)))
 		pk_results_add_package (state->results, package);
 
-	/* only emit progress for verb packages */
-	switch (info_enum) {
-	case PK_INFO_ENUM_DOWNLOADING:
-	case PK_INFO_ENUM_UPDATING:
-	case PK_INFO_ENUM_INSTALLING:
-	case PK_INFO_ENUM_REMOVING:
-	case PK_INFO_ENUM_CLEANUP:
-	case PK_INFO_ENUM_OBSOLETING:
-	case PK_INFO_ENUM_REINSTALLING:
-	case PK_INFO_ENUM_DOWNGRADING:
-	case PK_INFO_ENUM_PREPARING:
-	case PK_INFO_ENUM_DECOMPRESSING:
-	case PK_INFO_ENUM_FINISHED:
-		ret = pk_progress_set_package_id (state->progress, package_id);
-		if (state->progress_callback != NULL && ret) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_PACKAGE_ID,
-						  state->progress_user_data);
-		}
-		ret = pk_progress_set_package (state->progress, package);
-		if (state->progress_callback != NULL && ret) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_PACKAGE,
-						  state->progress_user_data);
-		}
-		break;
-	default:
-		break;
-	}
+	/* streamed results are not progress, so do not emit them twice */
+	if (!verb)
+		return;
+
+	/* emit progress */
+	ret = pk_progress_set_package_id (state->progress, package_id);
+	if (ret)
+		pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_PACKAGE_ID);
+	ret = pk_progress_set_package (state->progress, package);
+	if (ret)
+		pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_PACKAGE);
 }
 
 /**
@@ -871,11 +1086,8 @@ pk_client_copy_progress_cb (goffset current_num_bytes, goffset total_num_bytes,
 
 	/* save status */
 	ret = pk_progress_set_status (state->progress, PK_STATUS_ENUM_COPY_FILES);
-	if (state->progress_callback != NULL && ret) {
-		state->progress_callback (state->progress,
-					  PK_PROGRESS_TYPE_STATUS,
-					  state->progress_user_data);
-	}
+	if (ret)
+		pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_STATUS);
 
 	/* calculate percentage */
 	if (total_num_bytes > 0)
@@ -883,11 +1095,8 @@ pk_client_copy_progress_cb (goffset current_num_bytes, goffset total_num_bytes,
 
 	/* save percentage */
 	ret = pk_progress_set_percentage (state->progress, percentage);
-	if (state->progress_callback != NULL && ret) {
-		state->progress_callback (state->progress,
-					  PK_PROGRESS_TYPE_PERCENTAGE,
-					  state->progress_user_data);
-	}
+	if (ret)
+		pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_PERCENTAGE);
 }
 
 /**
@@ -972,11 +1181,8 @@ pk_client_copy_downloaded (PkClientState *state)
 
 	/* save percentage */
 	ret = pk_progress_set_percentage (state->progress, -1);
-	if (state->progress_callback != NULL && ret) {
-		state->progress_callback (state->progress,
-					  PK_PROGRESS_TYPE_PERCENTAGE,
-					  state->progress_user_data);
-	}
+	if (ret)
+		pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_PERCENTAGE);
 
 	/* do the copies pipelined */
 	for (i = 0; i < len; i++) {
@@ -1040,350 +1246,609 @@ pk_client_signal_finished (PkClientState *state,
 }
 
 /**
- * pk_client_signal_cb:
+ * pk_client_signal_finished_cb:
  **/
 static void
-pk_client_signal_cb (GDBusProxy *proxy,
-		     const gchar *sender_name,
-		     const gchar *signal_name,
-		     GVariant *parameters,
-		     gpointer user_data)
+pk_client_signal_finished_cb (PkClientState *state, GVariant *parameters)
 {
-	PkClientState *state = (PkClientState *) user_data;
-	gchar *tmp_str[12];
-	gchar **tmp_strv[5];
-	gboolean tmp_bool;
-	gboolean ret;
-	guint tmp_uint;
-	guint tmp_uint2;
-	guint tmp_uint3;
+	guint exit_enum;
+	guint runtime;
 
-	if (g_strcmp0 (signal_name, "Finished") == 0) {
-		g_variant_get (parameters,
-			       "(uu)",
-			       &tmp_uint2,
-			       &tmp_uint);
-		pk_client_signal_finished (state,
-					   tmp_uint2,
-					   tmp_uint);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "Package") == 0) {
-		g_variant_get (parameters,
-			       "(u&s&s)",
-			       &tmp_uint,
-			       &tmp_str[1],
-			       &tmp_str[2]);
-		pk_client_signal_package (state,
-					  tmp_uint,
-					  tmp_str[1],
-					  tmp_str[2]);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "Details") == 0) {
-		gchar *key;
-		GVariantIter *dictionary;
-		GVariant *value;
-		g_autoptr(PkDetails) item = NULL;
-		item = pk_details_new ();
-
-		if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})"))) {
-			g_variant_get_child (parameters, 0, "a{sv}", &dictionary);
-			while (g_variant_iter_loop (dictionary, "{sv}", &key, &value)) {
-				if (g_strcmp0 (key, "group") == 0)
-					g_object_set (item, "group", g_variant_get_uint32 (value), NULL);
-				else if (g_strcmp0 (key, "size") == 0)
-					g_object_set (item, "size", g_variant_get_uint64 (value), NULL);
-				else
-					g_object_set (item, key, g_variant_get_string (value, NULL), NULL);
-			}
-			g_variant_iter_free (dictionary);
-		} else {
-			guint64 tmp_uint64;
-			g_variant_get (parameters,
-				       "(&s&su&s&st)",
-				       &tmp_str[0],
-				       &tmp_str[1],
-				       &tmp_uint,
-				       &tmp_str[3],
-				       &tmp_str[4],
-				       &tmp_uint64);
-			g_object_set (item,
-				      "package-id", tmp_str[0],
-				      "license", tmp_str[1],
-				      "group", tmp_uint,
-				      "description", tmp_str[3],
-				      "url", tmp_str[4],
-				      "size", tmp_uint64,
-				      "role", state->role,
-				      "transaction-id", state->transaction_id,
-				      NULL);
-		}
-		pk_results_add_details (state->results, item);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "UpdateDetail") == 0) {
-		g_autoptr(PkUpdateDetail) item = NULL;
+	g_variant_get (parameters, "(uu)", &exit_enum, &runtime);
+	pk_client_signal_finished (state, exit_enum, runtime);
+}
+
+/**
+ * pk_client_signal_package_cb:
+ **/
+static void
+pk_client_signal_package_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *package_id;
+	const gchar *summary;
+	guint info_enum;
+
+	g_variant_get (parameters, "(u&s&s)", &info_enum, &package_id, &summary);
+	pk_client_signal_package (state, info_enum, package_id, summary);
+}
+
+/**
+ * pk_client_signal_details_cb:
+ **/
+static void
+pk_client_signal_details_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *key;
+	GVariant *value;
+	GVariantIter iter;
+	g_autoptr(GVariant) dictionary = NULL;
+	g_autoptr(PkDetails) item = NULL;
+
+	item = pk_details_new ();
+
+	/* old-style fixed signature */
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})"))) {
+		const gchar *package_id;
+		const gchar *license;
+		const gchar *description;
+		const gchar *url;
+		guint group;
+		guint64 size;
 		g_variant_get (parameters,
-			       "(&s^a&s^a&s^a&s^a&s^a&su&s&su&s&s)",
-			       &tmp_str[0],
-			       &tmp_strv[0],
-			       &tmp_strv[1],
-			       &tmp_strv[2],
-			       &tmp_strv[3],
-			       &tmp_strv[4],
-			       &tmp_uint,
-			       &tmp_str[7],
-			       &tmp_str[8],
-			       &tmp_uint2,
-			       &tmp_str[10],
-			       &tmp_str[11]);
-		item = pk_update_detail_new ();
+			       "(&s&su&s&st)",
+			       &package_id,
+			       &license,
+			       &group,
+			       &description,
+			       &url,
+			       &size);
 		g_object_set (item,
-			      "package-id", tmp_str[0],
-			      "updates", tmp_strv[0][0] != NULL ? tmp_strv[0] : NULL,
-			      "obsoletes", tmp_strv[1][0] != NULL ? tmp_strv[1] : NULL,
-			      "vendor-urls", tmp_strv[2][0] != NULL ? tmp_strv[2] : NULL,
-			      "bugzilla-urls", tmp_strv[3][0] != NULL ? tmp_strv[3] : NULL,
-			      "cve-urls", tmp_strv[4][0] != NULL ? tmp_strv[4] : NULL,
-			      "restart", tmp_uint,
-			      "update-text", tmp_str[7],
-			      "changelog", tmp_str[8],
-			      "state", tmp_uint2,
-			      "issued", tmp_str[10],
-			      "updated", tmp_str[11],
+			      "package-id", package_id,
+			      "license", license,
+			      "group", group,
+			      "description", description,
+			      "url", url,
+			      "size", size,
 			      "role", state->role,
 			      "transaction-id", state->transaction_id,
 			      NULL);
-		pk_results_add_update_detail (state->results, item);
+		if (!pk_client_state_stream_item (state, PK_SOURCE (item)))
+			pk_results_add_details (state->results, item);
 		return;
 	}
-	if (g_strcmp0 (signal_name, "Transaction") == 0) {
-		g_autoptr(PkTransactionPast) item = NULL;
-		g_variant_get (parameters,
-			       "(&o&sbuu&su&s)",
-			       &tmp_str[0],
-			       &tmp_str[1],
-			       &tmp_bool,
-			       &tmp_uint3,
-			       &tmp_uint,
-			       &tmp_str[3],
-			       &tmp_uint2,
-			       &tmp_str[4]);
-		item = pk_transaction_past_new ();
-		g_object_set (item,
-			      "tid", tmp_str[0],
-			      "timespec", tmp_str[1],
-			      "succeeded", tmp_bool,
-			      "role", tmp_uint3,
-			      "duration", tmp_uint,
-			      "data", tmp_str[3],
-			      "uid", tmp_uint2,
-			      "cmdline", tmp_str[4],
-			      "PkSource::role", state->role,
-			      "transaction-id", state->transaction_id,
-			      NULL);
-		pk_results_add_transaction (state->results, item);
-		return;
+
+	dictionary = g_variant_get_child_value (parameters, 0);
+	g_variant_iter_init (&iter, dictionary);
+	while (g_variant_iter_loop (&iter, "{&sv}", &key, &value)) {
+		if (g_strcmp0 (key, "group") == 0)
+			g_object_set (item, "group", g_variant_get_uint32 (value), NULL);
+		else if (g_strcmp0 (key, "size") == 0)
+			g_object_set (item, "size", g_variant_get_uint64 (value), NULL);
+		else
+			g_object_set (item, key, g_variant_get_string (value, NULL), NULL);
 	}
-	if (g_strcmp0 (signal_name, "DistroUpgrade") == 0) {
-		g_autoptr(PkDistroUpgrade) item = NULL;
-		g_variant_get (parameters,
-			       "(u&s&s)",
-			       &tmp_uint,
-			       &tmp_str[1],
-			       &tmp_str[2]);
-		item = pk_distro_upgrade_new ();
-		g_object_set (item,
-			      "state", tmp_uint,
-			      "name", tmp_str[1],
-			      "summary", tmp_str[2],
-			      "role", state->role,
-			      "transaction-id", state->transaction_id,
-			      NULL);
+	if (!pk_client_state_stream_item (state, PK_SOURCE (item)))
+		pk_results_add_details (state->results, item);
+}
+
+/**
+ * pk_client_strv_or_null:
+ **/
+static const gchar * const *
+pk_client_strv_or_null (const gchar **strv)
+{
+	if (strv == NULL || strv[0] == NULL)
+		return NULL;
+	return (const gchar * const *) strv;
+}
+
+/**
+ * pk_client_signal_update_detail_cb:
+ **/
+static void
+pk_client_signal_update_detail_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *package_id;
+	const gchar *update_text;
+	const gchar *changelog;
+	const gchar *issued;
+	const gchar *updated;
+	guint restart;
+	guint update_state;
+	g_autofree const gchar **updates = NULL;
+	g_autofree const gchar **obsoletes = NULL;
+	g_autofree const gchar **vendor_urls = NULL;
+	g_autofree const gchar **bugzilla_urls = NULL;
+	g_autofree const gchar **cve_urls = NULL;
+	g_autoptr(PkUpdateDetail) item = NULL;
+
+	g_variant_get (parameters,
+		       "(&s^a&s^a&s^a&s^a&s^a&su&s&su&s&s)",
+		       &package_id,
+		       &updates,
+		       &obsoletes,
+		       &vendor_urls,
+		       &bugzilla_urls,
+		       &cve_urls,
+		       &restart,
+		       &update_text,
+		       &changelog,
+		       &update_state,
+		       &issued,
+		       &updated);
+	item = pk_update_detail_new ();
+	g_object_set (item,
+		      "package-id", package_id,
+		      "updates", pk_client_strv_or_null (updates),
+		      "obsoletes", pk_client_strv_or_null (obsoletes),
+		      "vendor-urls", pk_client_strv_or_null (vendor_urls),
+		      "bugzilla-urls", pk_client_strv_or_null (bugzilla_urls),
+		      "cve-urls", pk_client_strv_or_null (cve_urls),
+		      "restart", restart,
+		      "update-text", update_text,
+		      "changelog", changelog,
+		      "state", update_state,
+		      "issued", issued,
+		      "updated", updated,
+		      "role", state->role,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	if (!pk_client_state_stream_item (state, PK_SOURCE (item)))
+		pk_results_add_update_detail (state->results, item);
+}
+
+/**
+ * pk_client_signal_transaction_cb:
+ **/
+static void
+pk_client_signal_transaction_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *tid;
+	const gchar *timespec;
+	const gchar *data;
+	const gchar *cmdline;
+	gboolean succeeded;
+	guint role;
+	guint duration;
+	guint uid;
+	g_autoptr(PkTransactionPast) item = NULL;
+
+	g_variant_get (parameters,
+		       "(&o&sbuu&su&s)",
+		       &tid,
+		       &timespec,
+		       &succeeded,
+		       &role,
+		       &duration,
+		       &data,
+		       &uid,
+		       &cmdline);
+	item = pk_transaction_past_new ();
+	g_object_set (item,
+		      "tid", tid,
+		      "timespec", timespec,
+		      "succeeded", succeeded,
+		      "role", role,
+		      "duration", duration,
+		      "data", data,
+		      "uid", uid,
+		      "cmdline", cmdline,
+		      "PkSource::role", state->role,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	if (!pk_client_state_stream_item (state, PK_SOURCE (item)))
+		pk_results_add_transaction (state->results, item);
+}
+
+/**
+ * pk_client_signal_distro_upgrade_cb:
+ **/
+static void
+pk_client_signal_distro_upgrade_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *name;
+	const gchar *summary;
+	guint upgrade_state;
+	g_autoptr(PkDistroUpgrade) item = NULL;
+
+	g_variant_get (parameters, "(u&s&s)", &upgrade_state, &name, &summary);
+	item = pk_distro_upgrade_new ();
+	g_object_set (item,
+		      "state", upgrade_state,
+		      "name", name,
+		      "summary", summary,
+		      "role", state->role,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	if (!pk_client_state_stream_item (state, PK_SOURCE (item)))
 		pk_results_add_distro_upgrade (state->results, item);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "RequireRestart") == 0) {
-		g_autoptr(PkRequireRestart) item = NULL;
-		g_variant_get (parameters,
-			       "(u&s)",
-			       &tmp_uint,
-			       &tmp_str[1]);
-		item = pk_require_restart_new ();
-		g_object_set (item,
-			      "restart", tmp_uint,
-			      "package-id", tmp_str[1],
-			      "role", state->role,
-			      "transaction-id", state->transaction_id,
-			      NULL);
-		pk_results_add_require_restart (state->results, item);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "Category") == 0) {
-		g_autoptr(PkCategory) item = NULL;
-		g_variant_get (parameters,
-			       "(&s&s&s&s&s)",
-			       &tmp_str[0],
-			       &tmp_str[1],
-			       &tmp_str[2],
-			       &tmp_str[3],
-			       &tmp_str[4]);
-		item = pk_category_new ();
-		g_object_set (item,
-			      "parent-id", tmp_str[0],
-			      "cat-id", tmp_str[1],
-			      "name", tmp_str[2],
-			      "summary", tmp_str[3],
-			      "icon", tmp_str[4],
-			      "role", state->role,
-			      "transaction-id", state->transaction_id,
-			      NULL);
+}
+
+/**
+ * pk_client_signal_require_restart_cb:
+ **/
+static void
+pk_client_signal_require_restart_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *package_id;
+	guint restart;
+	g_autoptr(PkRequireRestart) item = NULL;
+
+	g_variant_get (parameters, "(u&s)", &restart, &package_id);
+	item = pk_require_restart_new ();
+	g_object_set (item,
+		      "restart", restart,
+		      "package-id", package_id,
+		      "role", state->role,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	pk_results_add_require_restart (state->results, item);
+}
+
+/**
+ * pk_client_signal_category_cb:
+ **/
+static void
+pk_client_signal_category_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *parent_id;
+	const gchar *cat_id;
+	const gchar *name;
+	const gchar *summary;
+	const gchar *icon;
+	g_autoptr(PkCategory) item = NULL;
+
+	g_variant_get (parameters,
+		       "(&s&s&s&s&s)",
+		       &parent_id,
+		       &cat_id,
+		       &name,
+		       &summary,
+		       &icon);
+	item = pk_category_new ();
+	g_object_set (item,
+		      "parent-id", parent_id,
+		      "cat-id", cat_id,
+		      "name", name,
+		      "summary", summary,
+		      "icon", icon,
+		      "role", state->role,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	if (!pk_client_state_stream_item (state, PK_SOURCE (item)))
 		pk_results_add_category (state->results, item);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "Files") == 0) {
-		gchar **files;
-		g_autoptr(PkFiles) item = NULL;
-		g_variant_get (parameters,
-			       "(&s^a&s)",
-			       &tmp_str[0],
-			       &files);
-		item = pk_files_new ();
-		g_object_set (item,
-			      "package-id", tmp_str[0],
-			      "files", files,
-			      "role", state->role,
-			      "transaction-id", state->transaction_id,
-			      NULL);
+}
+
+/**
+ * pk_client_signal_files_cb:
+ **/
+static void
+pk_client_signal_files_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *package_id;
+	g_autofree const gchar **files = NULL;
+	g_autoptr(PkFiles) item = NULL;
+
+	g_variant_get (parameters, "(&s^a&s)", &package_id, &files);
+	item = pk_files_new ();
+	g_object_set (item,
+		      "package-id", package_id,
+		      "files", files,
+		      "role", state->role,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	if (!pk_client_state_stream_item (state, PK_SOURCE (item)))
 		pk_results_add_files (state->results, item);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "RepoSignatureRequired") == 0) {
-		g_autoptr(PkRepoSignatureRequired) item = NULL;
-		g_variant_get (parameters,
-			       "(&s&s&s&s&s&s&su)",
-			       &tmp_str[0],
-			       &tmp_str[1],
-			       &tmp_str[2],
-			       &tmp_str[3],
-			       &tmp_str[4],
-			       &tmp_str[5],
-			       &tmp_str[6],
-			       &tmp_uint);
-		item = pk_repo_signature_required_new ();
-		g_object_set (item,
-			      "package-id", tmp_str[0],
-			      "repository-name", tmp_str[1],
-			      "key-url", tmp_str[2],
-			      "key-userid", tmp_str[3],
-			      "key-id", tmp_str[4],
-			      "key-fingerprint", tmp_str[5],
-			      "key-timestamp", tmp_str[6],
-			      "type", tmp_uint,
-			      "role", state->role,
-			      "transaction-id", state->transaction_id,
-			      NULL);
-		pk_results_add_repo_signature_required (state->results, item);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "EulaRequired") == 0) {
-		g_autoptr(PkEulaRequired) item = NULL;
-		g_variant_get (parameters,
-			       "(&s&s&s&s)",
-			       &tmp_str[0],
-			       &tmp_str[1],
-			       &tmp_str[2],
-			       &tmp_str[3]);
-		item = pk_eula_required_new ();
-		g_object_set (item,
-			      "eula-id", tmp_str[0],
-			      "package-id", tmp_str[1],
-			      "vendor-name", tmp_str[2],
-			      "license-agreement", tmp_str[3],
-			      "role", state->role,
-			      "transaction-id", state->transaction_id,
-			      NULL);
-		pk_results_add_eula_required (state->results, item);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "RepoDetail") == 0) {
-		g_autoptr(PkRepoDetail) item = NULL;
-		g_variant_get (parameters,
-			       "(&s&sb)",
-			       &tmp_str[0],
-			       &tmp_str[1],
-			       &tmp_bool);
-		item = pk_repo_detail_new ();
-		g_object_set (item,
-			      "repo-id", tmp_str[0],
-			      "description", tmp_str[1],
-			      "enabled", tmp_bool,
-			      "role", state->role,
-			      "transaction-id", state->transaction_id,
-			      NULL);
+}
+
+/**
+ * pk_client_signal_repo_signature_required_cb:
+ **/
+static void
+pk_client_signal_repo_signature_required_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *package_id;
+	const gchar *repository_name;
+	const gchar *key_url;
+	const gchar *key_userid;
+	const gchar *key_id;
+	const gchar *key_fingerprint;
+	const gchar *key_timestamp;
+	guint type;
+	g_autoptr(PkRepoSignatureRequired) item = NULL;
+
+	g_variant_get (parameters,
+		       "(&s&s&s&s&s&s&su)",
+		       &package_id,
+		       &repository_name,
+		       &key_url,
+		       &key_userid,
+		       &key_id,
+		       &key_fingerprint,
+		       &key_timestamp,
+		       &type);
+	item = pk_repo_signature_required_new ();
+	g_object_set (item,
+		      "package-id", package_id,
+		      "repository-name", repository_name,
+		      "key-url", key_url,
+		      "key-userid", key_userid,
+		      "key-id", key_id,
+		      "key-fingerprint", key_fingerprint,
+		      "key-timestamp", key_timestamp,
+		      "type", type,
+		      "role", state->role,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	pk_results_add_repo_signature_required (state->results, item);
+}
+
+/**
+ * pk_client_signal_eula_required_cb:
+ **/
+static void
+pk_client_signal_eula_required_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *eula_id;
+	const gchar *package_id;
+	const gchar *vendor_name;
+	const gchar *license_agreement;
+	g_autoptr(PkEulaRequired) item = NULL;
+
+	g_variant_get (parameters,
+		       "(&s&s&s&s)",
+		       &eula_id,
+		       &package_id,
+		       &vendor_name,
+		       &license_agreement);
+	item = pk_eula_required_new ();
+	g_object_set (item,
+		      "eula-id", eula_id,
+		      "package-id", package_id,
+		      "vendor-name", vendor_name,
+		      "license-agreement", license_agreement,
+		      "role", state->role,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	pk_results_add_eula_required (state->results, item);
+}
+
+/**
+ * pk_client_signal_repo_detail_cb:
+ **/
+static void
+pk_client_signal_repo_detail_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *repo_id;
+	const gchar *description;
+	gboolean enabled;
+	g_autoptr(PkRepoDetail) item = NULL;
+
+	g_variant_get (parameters, "(&s&sb)", &repo_id, &description, &enabled);
+	item = pk_repo_detail_new ();
+	g_object_set (item,
+		      "repo-id", repo_id,
+		      "description", description,
+		      "enabled", enabled,
+		      "role", state->role,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	if (!pk_client_state_stream_item (state, PK_SOURCE (item)))
 		pk_results_add_repo_detail (state->results, item);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "ErrorCode") == 0) {
-		g_autoptr(PkError) item = NULL;
-		g_variant_get (parameters,
-			       "(u&s)",
-			       &tmp_uint,
-			       &tmp_str[1]);
-		item = pk_error_new ();
-		g_object_set (item,
-			      "code", tmp_uint,
-			      "details", tmp_str[1],
-			      "role", state->role,
-			      "transaction-id", state->transaction_id,
-			      NULL);
-		pk_results_set_error_code (state->results, item);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "MediaChangeRequired") == 0) {
-		g_autoptr(PkMediaChangeRequired) item = NULL;
-		g_variant_get (parameters,
-			       "(u&s&s)",
-			       &tmp_uint,
-			       &tmp_str[1],
-			       &tmp_str[2]);
-		item = pk_media_change_required_new ();
-		g_object_set (item,
-			      "media-type", tmp_uint,
-			      "media-id", tmp_str[1],
-			      "media-text", tmp_str[2],
-			      "role", state->role,
-			      "transaction-id", state->transaction_id,
-			      NULL);
-		pk_results_add_media_change_required (state->results, item);
-		return;
-	}
-	if (g_strcmp0 (signal_name, "ItemProgress") == 0) {
-		g_autoptr(PkItemProgress) item = NULL;
-		g_variant_get (parameters,
-			       "(&suu)",
-			       &tmp_str[0],
-			       &tmp_uint,
-			       &tmp_uint2);
-		item = pk_item_progress_new ();
-		g_object_set (item,
-			      "package-id", tmp_str[0],
-			      "status", tmp_uint,
-			      "percentage", tmp_uint2,
-			      "transaction-id", state->transaction_id,
-			      NULL);
-		ret = pk_progress_set_item_progress (state->progress,
-						     item);
-		if (ret && state->progress_callback != NULL) {
-			state->progress_callback (state->progress,
-						  PK_PROGRESS_TYPE_ITEM_PROGRESS,
-						  state->progress_user_data);
+}
+
+/**
+ * pk_client_signal_error_code_cb:
+ **/
+static void
+pk_client_signal_error_code_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *details;
+	guint code;
+	g_autoptr(PkError) item = NULL;
+
+	g_variant_get (parameters, "(u&s)", &code, &details);
+	item = pk_error_new ();
+	g_object_set (item,
+		      "code", code,
+		      "details", details,
+		      "role", state->role,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	pk_results_set_error_code (state->results, item);
+}
+
+/**
+ * pk_client_signal_media_change_required_cb:
+ **/
+static void
+pk_client_signal_media_change_required_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *media_id;
+	const gchar *media_text;
+	guint media_type;
+	g_autoptr(PkMediaChangeRequired) item = NULL;
+
+	g_variant_get (parameters, "(u&s&s)", &media_type, &media_id, &media_text);
+	item = pk_media_change_required_new ();
+	g_object_set (item,
+		      "media-type", media_type,
+		      "media-id", media_id,
+		      "media-text", media_text,
+		      "role", state->role,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	pk_results_add_media_change_required (state->results, item);
+}
+
+/**
+ * pk_client_signal_plan_cb:
+ **/
+static void
+pk_client_signal_plan_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *token;
+
+	g_variant_get (parameters, "(&s)", &token);
+	pk_results_set_plan_token (state->results, token);
+}
+
+/**
+ * pk_client_signal_item_progress_cb:
+ **/
+static void
+pk_client_signal_item_progress_cb (PkClientState *state, GVariant *parameters)
+{
+	const gchar *package_id;
+	guint status;
+	guint percentage;
+	gboolean ret;
+	g_autoptr(PkItemProgress) item = NULL;
+
+	g_variant_get (parameters, "(&suu)", &package_id, &status, &percentage);
+	item = pk_item_progress_new ();
+	g_object_set (item,
+		      "package-id", package_id,
+		      "status", status,
+		      "percentage", percentage,
+		      "transaction-id", state->transaction_id,
+		      NULL);
+	ret = pk_progress_set_item_progress (state->progress, item);
+	if (ret)
+		pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_ITEM_PROGRESS);
+}
+
+typedef void (*PkClientSignalFunc)	(PkClientState	*state,
+					 GVariant	*parameters);
+
+typedef struct {
+	const gchar		*signal_name;
+	const gchar		*signature;
+	PkClientSignalFunc	 func;
+} PkClientSignalHandler;
+
+/* Destroy is deliberately missing as there's nothing to do for it */
+static const PkClientSignalHandler pk_client_signal_handlers[] = {
+	{ "Package",			"(uss)",	pk_client_signal_package_cb },
+	{ "ItemProgress",		"(suu)",	pk_client_signal_item_progress_cb },
+	{ "Finished",			"(uu)",		pk_client_signal_finished_cb },
+	{ "Details",			NULL,		pk_client_signal_details_cb },
+	{ "UpdateDetail",		"(sasasasasasussuss)", pk_client_signal_update_detail_cb },
+	{ "Transaction",		"(osbuusus)",	pk_client_signal_transaction_cb },
+	{ "DistroUpgrade",		"(uss)",	pk_client_signal_distro_upgrade_cb },
+	{ "RequireRestart",		"(us)",		pk_client_signal_require_restart_cb },
+	{ "Category",			"(sssss)",	pk_client_signal_category_cb },
+	{ "Files",			"(sas)",	pk_client_signal_files_cb },
+	{ "RepoSignatureRequired",	"(sssssssu)",	pk_client_signal_repo_signature_required_cb },
+	{ "EulaRequired",		"(ssss)",	pk_client_signal_eula_required_cb },
+	{ "RepoDetail",			"(ssb)",	pk_client_signal_repo_detail_cb },
+	{ "ErrorCode",			"(us)",		pk_client_signal_error_code_cb },
+	{ "MediaChangeRequired",	"(uss)",	pk_client_signal_media_change_required_cb },
+	{ "Plan",			"(s)",		pk_client_signal_plan_cb },
+	{ NULL,				NULL,		NULL }
+};
+
+/**
+ * pk_client_signal_lookup:
+ *
+ * Finds the handler for a transaction signal using a hash table that is
+ * built the first time it is needed, rather than comparing the name
+ * against every known signal in turn.
+ **/
+static const PkClientSignalHandler *
+pk_client_signal_lookup (const gchar *signal_name)
+{
+	static GHashTable *hash = NULL;
+
+	if (g_once_init_enter (&hash)) {
+		GHashTable *hash_tmp;
+		guint i;
+		hash_tmp = g_hash_table_new (g_str_hash, g_str_equal);
+		for (i = 0; pk_client_signal_handlers[i].signal_name != NULL; i++) {
+			g_hash_table_insert (hash_tmp,
+					     (gpointer) pk_client_signal_handlers[i].signal_name,
+					     (gpointer) &pk_client_signal_handlers[i]);
 		}
-		return;
+		g_once_init_leave (&hash, hash_tmp);
 	}
-	if (g_strcmp0 (signal_name, "Destroy") == 0)
-		return;
+	return g_hash_table_lookup (hash, signal_name);
+}
+
+/**
+ * pk_client_signal_dispatch:
+ **/
+static gboolean
+pk_client_signal_dispatch (PkClientState *state,
+			   const gchar *signal_name,
+			   GVariant *parameters)
+{
+	const PkClientSignalHandler *handler;
+
+	handler = pk_client_signal_lookup (signal_name);
+	if (handler == NULL)
+		return FALSE;
+	if (handler->signature != NULL &&
+	    !g_variant_is_of_type (parameters, G_VARIANT_TYPE (handler->signature))) {
+		g_warning ("ignoring %s with unexpected type %s",
+			   signal_name, g_variant_get_type_string (parameters));
+		return FALSE;
+	}
+	handler->func (state, parameters);
+	return TRUE;
+}
+
+/**
+ * pk_client_signal_cb:
+ **/
+static void
+pk_client_signal_cb (GDBusProxy *proxy,
+		     const gchar *sender_name,
+		     const gchar *signal_name,
+		     GVariant *parameters,
+		     gpointer user_data)
+{
+	PkClientState *state = (PkClientState *) user_data;
+	pk_client_signal_dispatch (state, signal_name, parameters);
+}
+
+/**
+ * pk_client_replay_signal:
+ * @results: a #PkResults to add results to
+ * @progress: a #PkProgress for ItemProgress, or %NULL
+ * @role: the #PkRoleEnum to tag results with
+ * @transaction_id: the transaction ID to tag results with
+ * @signal_name: the D-Bus signal name
+ * @parameters: the D-Bus signal parameters
+ *
+ * Feeds one recorded transaction signal through the same handlers used for
+ * live transactions. The Finished signal is not handled as it needs a
+ * running request to complete.
+ *
+ * Return value: %TRUE if the signal was handled
+ **/
+gboolean
+pk_client_replay_signal (PkResults *results,
+			 PkProgress *progress,
+			 PkRoleEnum role,
+			 const gchar *transaction_id,
+			 const gchar *signal_name,
+			 GVariant *parameters)
+{
+	PkClientState state = { 0 };
+
+	g_return_val_if_fail (PK_IS_RESULTS (results), FALSE);
+	g_return_val_if_fail (signal_name != NULL, FALSE);
+
+	if (g_strcmp0 (signal_name, "Finished") == 0)
+		return FALSE;
+	if (progress == NULL &&
+	    g_strcmp0 (signal_name, "ItemProgress") == 0)
+		return FALSE;
+	state.results = results;
+	state.progress = progress;
+	state.role = role;
+	state.transaction_id = (gchar *) transaction_id;
+	return pk_client_signal_dispatch (&state, signal_name, parameters);
 }
 
 /**
@@ -1450,36 +1915,19 @@ pk_client_set_role (PkClientState *state, PkRoleEnum role)
 	pk_progress_set_transaction_flags (state->progress,
 					   state->transaction_flags);
 	ret = pk_progress_set_role (state->progress, role);
-	if (ret && state->progress_callback != NULL) {
-		state->progress_callback (state->progress,
-					  PK_PROGRESS_TYPE_ROLE,
-					  state->progress_user_data);
-	}
+	if (ret)
+		pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_ROLE);
 	return;
 }
 
 /**
- * pk_client_set_hints_cb:
+ * pk_client_call_method:
+ *
+ * Calls the method for the role on the transaction, once the hints are set.
  **/
 static void
-pk_client_set_hints_cb (GObject *source_object,
-			GAsyncResult *res,
-			gpointer user_data)
+pk_client_call_method (PkClientState *state)
 {
-	GDBusProxy *proxy = G_DBUS_PROXY (source_object);
-	PkClientState *state = (PkClientState *) user_data;
-	g_autoptr(GError) error = NULL;
-	g_autoptr(GVariant) value = NULL;
-
-	/* get the result */
-	value = g_dbus_proxy_call_finish (proxy, res, &error);
-	if (value == NULL) {
-		/* fix up the D-Bus error */
-		pk_client_fixup_dbus_error (error);
-		pk_client_state_finish (state, error);
-		return;
-	}
-
 	/* we'll have results from now on */
 	state->results = pk_results_new ();
 	g_object_set (state->results,
@@ -1846,6 +2294,31 @@ pk_client_set_hints_cb (GObject *source_object,
 	}
 }
 
+/**
+ * pk_client_set_hints_cb:
+ **/
+static void
+pk_client_set_hints_cb (GObject *source_object,
+			GAsyncResult *res,
+			gpointer user_data)
+{
+	GDBusProxy *proxy = G_DBUS_PROXY (source_object);
+	PkClientState *state = (PkClientState *) user_data;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) value = NULL;
+
+	/* get the result */
+	value = g_dbus_proxy_call_finish (proxy, res, &error);
+	if (value == NULL) {
+		/* fix up the D-Bus error */
+		pk_client_fixup_dbus_error (error);
+		pk_client_state_finish (state, error);
+		return;
+	}
+
+	pk_client_call_method (state);
+}
+
 /**
  * pk_client_bool_to_string:
  **/
@@ -1974,8 +2447,12 @@ pk_client_create_helper_socket (PkClientState *state)
 	/* create object */
 	state->client_helper = pk_client_helper_new ();
 
-	/* create socket to read from /tmp */
-	socket_id = g_strdup_printf ("gpk-%s.socket", &state->tid[1]);
+	/* create socket to read from /tmp, the tid is not known yet when the
+	 * hints are sent with CreateTransactionWithHints */
+	if (state->tid != NULL)
+		socket_id = g_strdup_printf ("gpk-%s.socket", &state->tid[1]);
+	else
+		socket_id = g_strdup_printf ("gpk-%08x%08x.socket", g_random_int (), g_random_int ());
 	socket_filename = g_build_filename (g_get_tmp_dir (), socket_id, NULL);
 
 	/* start the helper process */
@@ -1990,26 +2467,23 @@ pk_client_create_helper_socket (PkClientState *state)
 }
 
 /**
- * pk_client_get_proxy_cb:
+ * pk_client_get_hints:
+ *
+ * The hints are built once per state, as building them can start the
+ * frontend helper. Falling back from CreateTransactionWithHints to SetHints
+ * sends the same hints again.
+ *
+ * Return value: (transfer full): the hints for the transaction, %NULL terminated
  **/
-static void
-pk_client_get_proxy_cb (GObject *object,
-			GAsyncResult *res,
-			gpointer user_data)
+static GPtrArray *
+pk_client_get_hints (PkClientState *state)
 {
 	gchar *hint;
-	PkClientState *state = (PkClientState *) user_data;
-	g_autoptr(GError) error = NULL;
-	g_autoptr(GPtrArray) array = NULL;
-
-	state->proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
-	if (state->proxy == NULL)
-		g_error ("Cannot connect to PackageKit on %s", state->tid);
+	GPtrArray *array;
 
-	/* connect */
-	pk_client_proxy_connect (state);
+	if (state->hints != NULL)
+		return g_ptr_array_ref (state->hints);
 
-	/* get hints */
 	array = g_ptr_array_new_with_free_func (g_free);
 
 	/* locale */
@@ -2035,6 +2509,12 @@ pk_client_get_proxy_cb (GObject *object,
 		g_ptr_array_add (array, hint);
 	}
 
+	/* reuse the depsolve from the simulate */
+	if (state->plan_token != NULL) {
+		hint = g_strdup_printf ("plan-token=%s", state->plan_token);
+		g_ptr_array_add (array, hint);
+	}
+
 	/* create socket for roles that need interaction */
 	if (state->role == PK_ROLE_ENUM_INSTALL_FILES ||
 	    state->role == PK_ROLE_ENUM_INSTALL_PACKAGES ||
@@ -2045,8 +2525,32 @@ pk_client_get_proxy_cb (GObject *object,
 			g_ptr_array_add (array, hint);
 	}
 
-	/* set hints */
 	g_ptr_array_add (array, NULL);
+	state->hints = g_ptr_array_ref (array);
+	return array;
+}
+
+/**
+ * pk_client_get_proxy_cb:
+ **/
+static void
+pk_client_get_proxy_cb (GObject *object,
+			GAsyncResult *res,
+			gpointer user_data)
+{
+	PkClientState *state = (PkClientState *) user_data;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) array = NULL;
+
+	state->proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
+	if (state->proxy == NULL)
+		g_error ("Cannot connect to PackageKit on %s", state->tid);
+
+	/* connect */
+	pk_client_proxy_connect (state);
+
+	/* set hints */
+	array = pk_client_get_hints (state);
 	g_dbus_proxy_call (state->proxy, "SetHints",
 			   g_variant_new ("(^a&s)",
 					  array->pdata),
@@ -2089,6 +2593,155 @@ pk_client_get_tid_cb (GObject *object, GAsyncResult *res, PkClientState *state)
 				  state);
 }
 
+/**
+ * pk_client_get_proxy_with_hints_cb:
+ **/
+static void
+pk_client_get_proxy_with_hints_cb (GObject *object,
+				   GAsyncResult *res,
+				   gpointer user_data)
+{
+	PkClientState *state = (PkClientState *) user_data;
+	GVariant *properties = state->properties;
+	GVariantIter iter;
+	GVariant *value;
+	const gchar *name;
+	g_autoptr(GError) error = NULL;
+
+	state->properties = NULL;
+	state->proxy = g_dbus_proxy_new_finish (res, &error);
+	if (state->proxy == NULL) {
+		g_variant_unref (properties);
+		pk_client_state_finish (state, error);
+		return;
+	}
+
+	/* the properties came with the reply, so they were not loaded */
+	g_variant_iter_init (&iter, properties);
+	while (g_variant_iter_next (&iter, "{&sv}", &name, &value)) {
+		g_dbus_proxy_set_cached_property (state->proxy, name, value);
+		g_variant_unref (value);
+	}
+	g_variant_unref (properties);
+
+	/* connect, the proxy will not see PropertiesChanged by itself */
+	pk_client_proxy_connect (state);
+	state->properties_changed_id =
+		g_dbus_connection_signal_subscribe (g_dbus_proxy_get_connection (state->proxy),
+						    PK_DBUS_SERVICE,
+						    "org.freedesktop.DBus.Properties",
+						    "PropertiesChanged",
+						    state->tid,
+						    PK_DBUS_INTERFACE_TRANSACTION,
+						    G_DBUS_SIGNAL_FLAGS_NONE,
+						    pk_client_properties_changed_signal_cb,
+						    state,
+						    NULL);
+
+	/* track state */
+	g_ptr_array_add (state->client->priv->calls, state);
+
+	/* the hints are already set */
+	pk_client_call_method (state);
+}
+
+/**
+ * pk_client_create_transaction_cb:
+ **/
+static void
+pk_client_create_transaction_cb (GObject *source_object,
+				 GAsyncResult *res,
+				 gpointer user_data)
+{
+	GDBusConnection *connection = G_DBUS_CONNECTION (source_object);
+	PkClientState *state = (PkClientState *) user_data;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) value = NULL;
+
+	value = g_dbus_connection_call_finish (connection, res, &error);
+	if (value == NULL) {
+		/* older daemons only support CreateTransaction and SetHints */
+		if (g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+			g_debug ("falling back to CreateTransaction");
+			pk_control_get_tid_async (state->client->priv->control,
+						  state->cancellable,
+						  (GAsyncReadyCallback) pk_client_get_tid_cb,
+						  state);
+			return;
+		}
+		pk_client_fixup_dbus_error (error);
+		pk_client_state_finish (state, error);
+		return;
+	}
+
+	g_variant_get (value, "(o@a{sv})", &state->tid, &state->properties);
+	pk_progress_set_transaction_id (state->progress, state->tid);
+
+	/* get a connection to the transaction interface */
+	g_dbus_proxy_new (connection,
+			  G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
+			  NULL,
+			  PK_DBUS_SERVICE,
+			  state->tid,
+			  PK_DBUS_INTERFACE_TRANSACTION,
+			  state->cancellable,
+			  pk_client_get_proxy_with_hints_cb,
+			  state);
+}
+
+/**
+ * pk_client_create_transaction_bus_cb:
+ **/
+static void
+pk_client_create_transaction_bus_cb (GObject *source_object,
+				     GAsyncResult *res,
+				     gpointer user_data)
+{
+	PkClientState *state = (PkClientState *) user_data;
+	g_autoptr(GDBusConnection) connection = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) array = NULL;
+
+	connection = g_bus_get_finish (res, &error);
+	if (connection == NULL) {
+		pk_client_state_finish (state, error);
+		return;
+	}
+
+	/* create the transaction and set the hints in one go */
+	array = pk_client_get_hints (state);
+	g_dbus_connection_call (connection,
+				PK_DBUS_SERVICE,
+				PK_DBUS_PATH,
+				PK_DBUS_INTERFACE,
+				"CreateTransactionWithHints",
+				g_variant_new ("(^a&s)", array->pdata),
+				G_VARIANT_TYPE ("(oa{sv})"),
+				G_DBUS_CALL_FLAGS_NONE,
+				PK_CLIENT_DBUS_METHOD_TIMEOUT,
+				state->cancellable,
+				pk_client_create_transaction_cb,
+				state);
+}
+
+/**
+ * pk_client_create_transaction:
+ *
+ * Creates the transaction for the state and calls the role method on it.
+ **/
+static void
+pk_client_create_transaction (PkClientState *state)
+{
+	/* only the next transaction gets the plan */
+	state->plan_token = state->client->priv->plan_token;
+	state->client->priv->plan_token = NULL;
+
+	g_bus_get (G_BUS_TYPE_SYSTEM,
+		   state->cancellable,
+		   pk_client_create_transaction_bus_cb,
+		   state);
+}
+
 /**
  * pk_client_generic_finish:
  * @client: a valid #PkClient instance
@@ -2178,11 +2831,8 @@ pk_client_resolve_async (PkClient *client, PkBitfield filters, gchar **packages,
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2245,11 +2895,8 @@ pk_client_search_names_async (PkClient *client, PkBitfield filters, gchar **valu
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2313,11 +2960,8 @@ pk_client_search_details_async (PkClient *client, PkBitfield filters, gchar **va
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2379,11 +3023,8 @@ pk_client_search_groups_async (PkClient *client, PkBitfield filters, gchar **val
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2445,11 +3086,8 @@ pk_client_search_files_async (PkClient *client, PkBitfield filters, gchar **valu
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2511,11 +3149,8 @@ pk_client_get_details_async (PkClient *client, gchar **package_ids, GCancellable
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2581,11 +3216,8 @@ pk_client_get_details_local_async (PkClient *client, gchar **files, GCancellable
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2651,11 +3283,8 @@ pk_client_get_files_local_async (PkClient *client, gchar **files, GCancellable *
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2717,11 +3346,8 @@ pk_client_get_update_detail_async (PkClient *client, gchar **package_ids, GCance
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2784,11 +3410,8 @@ pk_client_download_packages_async (PkClient *client, gchar **package_ids, const
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2848,11 +3471,8 @@ pk_client_get_updates_async (PkClient *client, PkBitfield filters, GCancellable
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2912,11 +3532,8 @@ pk_client_get_old_transactions_async (PkClient *client, guint number, GCancellab
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -2981,11 +3598,8 @@ pk_client_depends_on_async (PkClient *client, PkBitfield filters, gchar **packag
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3045,11 +3659,8 @@ pk_client_get_packages_async (PkClient *client, PkBitfield filters, GCancellable
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3114,11 +3725,8 @@ pk_client_required_by_async (PkClient *client, PkBitfield filters, gchar **packa
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3185,11 +3793,8 @@ pk_client_what_provides_async (PkClient *client,
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3248,11 +3853,8 @@ pk_client_get_distro_upgrades_async (PkClient *client, GCancellable *cancellable
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3313,11 +3915,8 @@ pk_client_get_files_async (PkClient *client, gchar **package_ids, GCancellable *
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3375,11 +3974,8 @@ pk_client_get_categories_async (PkClient *client, GCancellable *cancellable,
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3455,11 +4051,8 @@ pk_client_remove_packages_async (PkClient *client,
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3522,11 +4115,8 @@ pk_client_refresh_cache_async (PkClient *client, gboolean force, GCancellable *c
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3589,11 +4179,8 @@ pk_client_install_packages_async (PkClient *client, PkBitfield transaction_flags
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3657,11 +4244,8 @@ pk_client_install_signature_async (PkClient *client, PkSigTypeEnum type, const g
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3729,11 +4313,8 @@ pk_client_update_packages_async (PkClient *client,
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -3753,10 +4334,7 @@ pk_client_copy_native_finished_cb (GFile *file, GAsyncResult *res, PkClientState
 	/* no more copies pending? */
 	if (--state->refcount == 0) {
 		/* now get tid and continue on our merry way */
-		pk_control_get_tid_async (state->client->priv->control,
-					  state->cancellable,
-					  (GAsyncReadyCallback) pk_client_get_tid_cb,
-					  state);
+		pk_client_create_transaction (state);
 	}
 }
 
@@ -3778,11 +4356,8 @@ pk_client_copy_non_native_then_get_tid (PkClientState *state)
 
 	/* save percentage */
 	ret = pk_progress_set_percentage (state->progress, -1);
-	if (state->progress_callback != NULL && ret) {
-		state->progress_callback (state->progress,
-					  PK_PROGRESS_TYPE_PERCENTAGE,
-					  state->progress_user_data);
-	}
+	if (ret)
+		pk_client_state_progress_changed (state, PK_PROGRESS_TYPE_PERCENTAGE);
 
 	/* copy each file that is non-native */
 	for (i = 0; state->files[i] != NULL; i++) {
@@ -3896,10 +4471,7 @@ pk_client_install_files_async (PkClient *client,
 	/* nothing to copy, common case */
 	if (state->refcount == 0) {
 		/* just get tid */
-		pk_control_get_tid_async (client->priv->control,
-					  cancellable,
-					  (GAsyncReadyCallback) pk_client_get_tid_cb,
-					  state);
+		pk_client_create_transaction (state);
 		return;
 	}
 
@@ -3964,11 +4536,8 @@ pk_client_accept_eula_async (PkClient *client, const gchar *eula_id, GCancellabl
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -4028,11 +4597,8 @@ pk_client_get_repo_list_async (PkClient *client, PkBitfield filters, GCancellabl
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -4094,11 +4660,8 @@ pk_client_repo_enable_async (PkClient *client, const gchar *repo_id, gboolean en
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -4163,11 +4726,8 @@ pk_client_repo_set_data_async (PkClient *client, const gchar *repo_id, const gch
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -4237,11 +4797,8 @@ pk_client_repo_remove_async (PkClient *client,
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -4312,11 +4869,8 @@ pk_client_upgrade_system_async (PkClient *client,
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control,
-				  cancellable,
-				  (GAsyncReadyCallback) pk_client_get_tid_cb,
-				  state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**
@@ -4380,8 +4934,8 @@ pk_client_repair_system_async (PkClient *client,
 	/* identify */
 	pk_client_set_role (state, state->role);
 
-	/* get tid */
-	pk_control_get_tid_async (client->priv->control, cancellable, (GAsyncReadyCallback) pk_client_get_tid_cb, state);
+	/* create transaction */
+	pk_client_create_transaction (state);
 }
 
 /**********************************************************************/
@@ -4525,6 +5079,8 @@ pk_client_get_progress_finish (PkClient *client, GAsyncResult *res, GError **err
 static void
 pk_client_get_progress_state_finish (PkClientState *state, const GError *error)
 {
+	pk_client_state_progress_flush (state);
+
 	if (state->cancellable_id > 0) {
 		g_cancellable_disconnect (state->cancellable_client,
 					  state->cancellable_id);
@@ -4842,6 +5398,92 @@ pk_client_get_cache_age (PkClient *client)
 	return client->priv->cache_age;
 }
 
+/**
+ * pk_client_set_progress_interval:
+ * @client: a valid #PkClient instance
+ * @progress_interval: the minimum time between progress callbacks in ms, or 0
+ *
+ * Limits how often the progress callback runs for changes that happen many
+ * times a second, such as the percentage, item progress and package. Changes
+ * within the interval are merged so the callback runs once for each type
+ * with the latest value. Status and role changes are never held back, and
+ * send any merged changes first.
+ *
+ * The default of 0 runs the callback for every change.
+ *
+ * Since: 1.1.3
+ **/
+void
+pk_client_set_progress_interval (PkClient *client, guint progress_interval)
+{
+	g_return_if_fail (PK_IS_CLIENT (client));
+	client->priv->progress_interval = progress_interval;
+	g_object_notify (G_OBJECT (client), "progress-interval");
+}
+
+/**
+ * pk_client_get_progress_interval:
+ * @client: a valid #PkClient instance
+ *
+ * Gets the minimum time between progress callbacks.
+ *
+ * Return value: The interval in milliseconds, or 0 for none
+ *
+ * Since: 1.1.3
+ **/
+guint
+pk_client_get_progress_interval (PkClient *client)
+{
+	g_return_val_if_fail (PK_IS_CLIENT (client), 0);
+	return client->priv->progress_interval;
+}
+
+/**
+ * pk_client_set_item_callback:
+ * @client: a valid #PkClient instance
+ * @callback: (allow-none): the function to call for each result item, or %NULL
+ * @user_data: (closure): user data to pass to @callback
+ *
+ * Makes the client deliver result items such as #PkPackage, #PkDetails and
+ * #PkFiles to @callback as they arrive from the daemon, rather than storing
+ * them in the #PkResults returned when the transaction is finished.
+ * This keeps memory use flat for very large queries.
+ *
+ * The callback is run from the main loop as each signal is processed,
+ * so a slow consumer slows down the processing of further items.
+ *
+ * Error codes, #PkRequireRestart items, requests such as #PkEulaRequired
+ * that need an answer, and the results of simulated or DownloadPackages
+ * transactions are always stored in the #PkResults.
+ *
+ * Since: 1.1.3
+ **/
+void
+pk_client_set_item_callback (PkClient *client,
+			     PkClientItemCallback callback,
+			     gpointer user_data)
+{
+	g_return_if_fail (PK_IS_CLIENT (client));
+	client->priv->item_callback = callback;
+	client->priv->item_user_data = user_data;
+}
+
+/**
+ * pk_client_set_plan_token:
+ * @client: a valid #PkClient instance
+ * @plan_token: (allow-none): the token from pk_results_get_plan_token(), or %NULL
+ *
+ * Sends @plan_token with the next transaction started on @client, so the
+ * backend can reuse the depsolve of the simulate it came from.
+ **/
+void
+pk_client_set_plan_token (PkClient *client, const gchar *plan_token)
+{
+	g_return_if_fail (PK_IS_CLIENT (client));
+	g_free (client->priv->plan_token);
+	client->priv->plan_token = g_strdup (plan_token);
+}
+
 /**
  * pk_client_class_init:
  **/
@@ -4905,6 +5547,16 @@ pk_client_class_init (PkClientClass *klass)
 				   0, G_MAXUINT, 0,
 				   G_PARAM_READWRITE);
 	g_object_class_install_property (object_class, PROP_CACHE_AGE, pspec);
+
+	/**
+	 * PkClient:progress-interval:
+	 *
+	 * Since: 1.1.3
+	 */
+	pspec = g_param_spec_uint ("progress-interval", NULL, NULL,
+				   0, G_MAXUINT, 0,
+				   G_PARAM_READWRITE);
+	g_object_class_install_property (object_class, PROP_PROGRESS_INTERVAL, pspec);
 }
 
 /**
@@ -4940,6 +5592,7 @@ pk_client_finalize (GObject *object)
 	pk_client_cancel_all_dbus_methods (client);
 
 	g_free (client->priv->locale);
+	g_free (client->priv->plan_token);
 	g_object_unref (priv->control);
 	g_ptr_array_unref (priv->calls);
 
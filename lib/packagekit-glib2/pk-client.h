@@ -102,6 +102,16 @@ struct _PkClientClass
 	void (*_pk_reserved5) (void);
 };
 
+/**
+ * PkClientItemCallback:
+ * @item: the result item, e.g. a #PkPackage or #PkFiles
+ * @user_data: user data set with pk_client_set_item_callback()
+ *
+ * The callback used when streaming result items.
+ **/
+typedef void	(*PkClientItemCallback)			(PkSource		*item,
+							 gpointer		 user_data);
+
 GQuark		 pk_client_error_quark			(void);
 GType		 pk_client_get_type		  	(void);
 PkClient	*pk_client_new				(void);
@@ -424,6 +434,12 @@ gboolean	 pk_client_get_idle			(PkClient		*client);
 void		 pk_client_set_cache_age		(PkClient		*client,
 							 guint			 cache_age);
 guint		 pk_client_get_cache_age		(PkClient		*client);
+void		 pk_client_set_progress_interval	(PkClient		*client,
+							 guint			 progress_interval);
+guint		 pk_client_get_progress_interval	(PkClient		*client);
+void		 pk_client_set_item_callback		(PkClient		*client,
+							 PkClientItemCallback	 callback,
+							 gpointer		 user_data);
 
 G_END_DECLS
 
@@ -54,6 +54,7 @@ struct _PkControlPrivate
 	GCancellable		*cancellable;
 	GPtrArray		*calls;
 	GDBusProxy		*proxy;
+	GPtrArray		*proxy_waiters;
 	guint			 version_major;
 	guint			 version_minor;
 	guint			 version_micro;
@@ -123,7 +124,6 @@ typedef struct {
 	PkControl		*control;
 	PkNetworkEnum		 network;
 	GVariant		*parameters;
-	GDBusProxy		*proxy;
 } PkControlState;
 
 /**
@@ -382,32 +382,118 @@ pk_control_signal_cb (GDBusProxy *proxy,
  * pk_control_proxy_connect:
  **/
 static void
-pk_control_proxy_connect (PkControlState *state)
+pk_control_proxy_connect (PkControl *control, GDBusProxy *proxy)
 {
 	guint i;
 	g_auto(GStrv) props = NULL;
 
 	/* coldplug properties */
-	props = g_dbus_proxy_get_cached_property_names (state->proxy);
+	props = g_dbus_proxy_get_cached_property_names (proxy);
 	for (i = 0; props != NULL && props[i] != NULL; i++) {
 		g_autoptr(GVariant) value_tmp = NULL;
-		value_tmp = g_dbus_proxy_get_cached_property (state->proxy, props[i]);
-		pk_control_set_property_value (state->control,
+		value_tmp = g_dbus_proxy_get_cached_property (proxy, props[i]);
+		pk_control_set_property_value (control,
 					       props[i],
 					       value_tmp);
 	}
 
 	/* connect up signals */
-	g_signal_connect (state->proxy, "g-properties-changed",
+	g_signal_connect (proxy, "g-properties-changed",
 			  G_CALLBACK (pk_control_properties_changed_cb),
-			  state->control);
-	g_signal_connect (state->proxy, "g-signal",
+			  control);
+	g_signal_connect (proxy, "g-signal",
 			  G_CALLBACK (pk_control_signal_cb),
-			  state->control);
+			  control);
+
+	/* this is the system wide proxy used for every call */
+	control->priv->proxy = g_object_ref (proxy);
+}
+
+typedef void (*PkControlStateFunc)		(PkControlState		*state);
+typedef void (*PkControlStateFinishFunc)	(PkControlState		*state,
+						 const GError		*error);
+
+typedef struct {
+	PkControlState			*state;
+	PkControlStateFunc		 func;
+	PkControlStateFinishFunc	 finish_func;
+} PkControlProxyWaiter;
+
+/**
+ * pk_control_proxy_ready_cb:
+ *
+ * Runs the calls that were queued while the shared proxy was created.
+ **/
+static void
+pk_control_proxy_ready_cb (GObject *source_object,
+			   GAsyncResult *res,
+			   gpointer user_data)
+{
+	PkControl *control = PK_CONTROL (user_data);
+	PkControlProxyWaiter *waiter;
+	guint i;
+	g_autoptr(GDBusProxy) proxy = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) waiters = NULL;
+
+	proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
+	if (proxy != NULL)
+		pk_control_proxy_connect (control, proxy);
+
+	/* the callbacks may queue new calls */
+	waiters = control->priv->proxy_waiters;
+	control->priv->proxy_waiters = g_ptr_array_new_with_free_func (g_free);
+	for (i = 0; i < waiters->len; i++) {
+		waiter = g_ptr_array_index (waiters, i);
+		if (proxy == NULL)
+			waiter->finish_func (waiter->state, error);
+		else
+			waiter->func (waiter->state);
+	}
+	g_object_unref (control);
+}
+
+/**
+ * pk_control_call_with_proxy:
+ * @func: the function that makes the D-Bus call
+ * @finish_func: the function to call if the proxy cannot be created
+ *
+ * Every #PkControl call goes through the one system wide proxy, which
+ * fetches the daemon properties and adds the signal match rule once. If the
+ * proxy is still being created the call is queued, so that concurrent calls
+ * do not each create their own.
+ **/
+static void
+pk_control_call_with_proxy (PkControlState *state,
+			    PkControlStateFunc func,
+			    PkControlStateFinishFunc finish_func)
+{
+	PkControl *control = state->control;
+	PkControlProxyWaiter *waiter;
+
+	if (control->priv->proxy != NULL) {
+		func (state);
+		return;
+	}
+
+	waiter = g_new0 (PkControlProxyWaiter, 1);
+	waiter->state = state;
+	waiter->func = func;
+	waiter->finish_func = finish_func;
+	g_ptr_array_add (control->priv->proxy_waiters, waiter);
 
-	/* if we have no generic system wide proxy, then use this */
-	if (state->control->priv->proxy == NULL)
-		state->control->priv->proxy = g_object_ref (state->proxy);
+	/* already being created */
+	if (control->priv->proxy_waiters->len > 1)
+		return;
+	g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
+				  G_DBUS_PROXY_FLAGS_NONE,
+				  NULL,
+				  PK_DBUS_SERVICE,
+				  PK_DBUS_PATH,
+				  PK_DBUS_INTERFACE,
+				  control->priv->cancellable,
+				  pk_control_proxy_ready_cb,
+				  g_object_ref (control));
 }
 
 /**********************************************************************/
@@ -442,8 +528,6 @@ pk_control_get_tid_state_finish (PkControlState *state, const GError *error)
 	g_free (state->tid);
 	g_object_unref (state->res);
 	g_object_unref (state->control);
-	if (state->proxy != NULL)
-		g_object_unref (state->proxy);
 	g_slice_free (PkControlState, state);
 }
 
@@ -492,26 +576,6 @@ pk_control_get_tid_internal (PkControlState *state)
 			   state);
 }
 
-/**
- * pk_control_get_tid_proxy_cb:
- **/
-static void
-pk_control_get_tid_proxy_cb (GObject *source_object,
-			     GAsyncResult *res,
-			     gpointer user_data)
-{
-	g_autoptr(GError) error = NULL;
-	PkControlState *state = (PkControlState *) user_data;
-
-	state->proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
-	if (state->proxy == NULL) {
-		pk_control_get_tid_state_finish (state, error);
-		return;
-	}
-	pk_control_proxy_connect (state);
-	pk_control_get_tid_internal (state);
-}
-
 /**
  * pk_control_get_tid_async:
  * @control: a valid #PkControl instance
@@ -556,20 +620,10 @@ pk_control_get_tid_async (PkControl *control,
 		return;
 	}
 
-	/* skip straight to the D-Bus method if already connection */
-	if (control->priv->proxy != NULL) {
-		pk_control_get_tid_internal (state);
-	} else {
-		g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
-					  G_DBUS_PROXY_FLAGS_NONE,
-					  NULL,
-					  PK_DBUS_SERVICE,
-					  PK_DBUS_PATH,
-					  PK_DBUS_INTERFACE,
-					  control->priv->cancellable,
-					  pk_control_get_tid_proxy_cb,
-					  state);
-	}
+	/* skip straight to the D-Bus method if already connected */
+	pk_control_call_with_proxy (state,
+				    pk_control_get_tid_internal,
+				    pk_control_get_tid_state_finish);
 
 	/* track state */
 	g_ptr_array_add (control->priv->calls, state);
@@ -642,8 +696,6 @@ pk_control_suggest_daemon_quit_state_finish (PkControlState *state,
 	}
 	g_object_unref (state->res);
 	g_object_unref (state->control);
-	if (state->proxy != NULL)
-		g_object_unref (state->proxy);
 	g_slice_free (PkControlState, state);
 }
 
@@ -690,26 +742,6 @@ pk_control_suggest_daemon_quit_internal (PkControlState *state)
 			   state);
 }
 
-/**
- * pk_control_suggest_daemon_quit_proxy_cb:
- **/
-static void
-pk_control_suggest_daemon_quit_proxy_cb (GObject *source_object,
-					 GAsyncResult *res,
-					 gpointer user_data)
-{
-	PkControlState *state = (PkControlState *) user_data;
-	g_autoptr(GError) error = NULL;
-
-	state->proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
-	if (state->proxy == NULL) {
-		pk_control_suggest_daemon_quit_state_finish (state, error);
-		return;
-	}
-	pk_control_proxy_connect (state);
-	pk_control_suggest_daemon_quit_internal (state);
-}
-
 /**
  * pk_control_suggest_daemon_quit_async:
  * @control: a valid #PkControl instance
@@ -754,20 +786,10 @@ pk_control_suggest_daemon_quit_async (PkControl *control,
 		return;
 	}
 
-	/* skip straight to the D-Bus method if already connection */
-	if (control->priv->proxy != NULL) {
-		pk_control_suggest_daemon_quit_internal (state);
-	} else {
-		g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
-					  G_DBUS_PROXY_FLAGS_NONE,
-					  NULL,
-					  PK_DBUS_SERVICE,
-					  PK_DBUS_PATH,
-					  PK_DBUS_INTERFACE,
-					  control->priv->cancellable,
-					  pk_control_suggest_daemon_quit_proxy_cb,
-					  state);
-	}
+	/* skip straight to the D-Bus method if already connected */
+	pk_control_call_with_proxy (state,
+				    pk_control_suggest_daemon_quit_internal,
+				    pk_control_suggest_daemon_quit_state_finish);
 
 	/* track state */
 	g_ptr_array_add (control->priv->calls, state);
@@ -838,8 +860,6 @@ pk_control_get_daemon_state_state_finish (PkControlState *state, const GError *e
 	g_free (state->daemon_state);
 	g_object_unref (state->res);
 	g_object_unref (state->control);
-	if (state->proxy != NULL)
-		g_object_unref (state->proxy);
 	g_slice_free (PkControlState, state);
 }
 
@@ -888,26 +908,6 @@ pk_control_get_daemon_state_internal (PkControlState *state)
 			   state);
 }
 
-/**
- * pk_control_get_daemon_state_proxy_cb:
- **/
-static void
-pk_control_get_daemon_state_proxy_cb (GObject *source_object,
-			     GAsyncResult *res,
-			     gpointer user_data)
-{
-	g_autoptr(GError) error = NULL;
-	PkControlState *state = (PkControlState *) user_data;
-
-	state->proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
-	if (state->proxy == NULL) {
-		pk_control_get_daemon_state_state_finish (state, error);
-		return;
-	}
-	pk_control_proxy_connect (state);
-	pk_control_get_daemon_state_internal (state);
-}
-
 /**
  * pk_control_get_daemon_state_async:
  * @control: a valid #PkControl instance
@@ -952,20 +952,10 @@ pk_control_get_daemon_state_async (PkControl *control,
 		return;
 	}
 
-	/* skip straight to the D-Bus method if already connection */
-	if (control->priv->proxy != NULL) {
-		pk_control_get_daemon_state_internal (state);
-	} else {
-		g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
-					  G_DBUS_PROXY_FLAGS_NONE,
-					  NULL,
-					  PK_DBUS_SERVICE,
-					  PK_DBUS_PATH,
-					  PK_DBUS_INTERFACE,
-					  control->priv->cancellable,
-					  pk_control_get_daemon_state_proxy_cb,
-					  state);
-	}
+	/* skip straight to the D-Bus method if already connected */
+	pk_control_call_with_proxy (state,
+				    pk_control_get_daemon_state_internal,
+				    pk_control_get_daemon_state_state_finish);
 
 	/* track state */
 	g_ptr_array_add (control->priv->calls, state);
@@ -1038,8 +1028,6 @@ pk_control_set_proxy_state_finish (PkControlState *state,
 	}
 	g_object_unref (state->res);
 	g_object_unref (state->control);
-	if (state->proxy != NULL)
-		g_object_unref (state->proxy);
 	g_variant_unref (state->parameters);
 	g_slice_free (PkControlState, state);
 }
@@ -1088,26 +1076,6 @@ pk_control_set_proxy_internal (PkControlState *state)
 			   state);
 }
 
-/**
- * pk_control_set_proxy_proxy_cb:
- **/
-static void
-pk_control_set_proxy_proxy_cb (GObject *source_object,
-			     GAsyncResult *res,
-			     gpointer user_data)
-{
-	g_autoptr(GError) error = NULL;
-	PkControlState *state = (PkControlState *) user_data;
-
-	state->proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
-	if (state->proxy == NULL) {
-		pk_control_set_proxy_state_finish (state, error);
-		return;
-	}
-	pk_control_proxy_connect (state);
-	pk_control_set_proxy_internal (state);
-}
-
 /**
  * pk_control_set_proxy2_async:
  * @control: a valid #PkControl instance
@@ -1172,20 +1140,10 @@ pk_control_set_proxy2_async (PkControl *control,
 		return;
 	}
 
-	/* skip straight to the D-Bus method if already connection */
-	if (control->priv->proxy != NULL) {
-		pk_control_set_proxy_internal (state);
-	} else {
-		g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
-					  G_DBUS_PROXY_FLAGS_NONE,
-					  NULL,
-					  PK_DBUS_SERVICE,
-					  PK_DBUS_PATH,
-					  PK_DBUS_INTERFACE,
-					  control->priv->cancellable,
-					  pk_control_set_proxy_proxy_cb,
-					  state);
-	}
+	/* skip straight to the D-Bus method if already connected */
+	pk_control_call_with_proxy (state,
+				    pk_control_set_proxy_internal,
+				    pk_control_set_proxy_state_finish);
 
 	/* track state */
 	g_ptr_array_add (control->priv->calls, state);
@@ -1295,8 +1253,6 @@ pk_control_get_transaction_list_state_finish (PkControlState *state,
 	g_strfreev (state->transaction_list);
 	g_object_unref (state->res);
 	g_object_unref (state->control);
-	if (state->proxy != NULL)
-		g_object_unref (state->proxy);
 	g_slice_free (PkControlState, state);
 }
 
@@ -1352,26 +1308,6 @@ pk_control_get_transaction_list_internal (PkControlState *state)
 			   state);
 }
 
-/**
- * pk_control_get_transaction_list_proxy_cb:
- **/
-static void
-pk_control_get_transaction_list_proxy_cb (GObject *source_object,
-					  GAsyncResult *res,
-					  gpointer user_data)
-{
-	g_autoptr(GError) error = NULL;
-	PkControlState *state = (PkControlState *) user_data;
-
-	state->proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
-	if (state->proxy == NULL) {
-		pk_control_get_transaction_list_state_finish (state, error);
-		return;
-	}
-	pk_control_proxy_connect (state);
-	pk_control_get_transaction_list_internal (state);
-}
-
 /**
  * pk_control_get_transaction_list_async:
  * @control: a valid #PkControl instance
@@ -1416,20 +1352,10 @@ pk_control_get_transaction_list_async (PkControl *control,
 		return;
 	}
 
-	/* skip straight to the D-Bus method if already connection */
-	if (control->priv->proxy != NULL) {
-		pk_control_get_transaction_list_internal (state);
-	} else {
-		g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
-					  G_DBUS_PROXY_FLAGS_NONE,
-					  NULL,
-					  PK_DBUS_SERVICE,
-					  PK_DBUS_PATH,
-					  PK_DBUS_INTERFACE,
-					  control->priv->cancellable,
-					  pk_control_get_transaction_list_proxy_cb,
-					  state);
-	}
+	/* skip straight to the D-Bus method if already connected */
+	pk_control_call_with_proxy (state,
+				    pk_control_get_transaction_list_internal,
+				    pk_control_get_transaction_list_state_finish);
 
 	/* track state */
 	g_ptr_array_add (control->priv->calls, state);
@@ -1501,8 +1427,6 @@ pk_control_get_time_since_action_state_finish (PkControlState *state,
 	}
 	g_object_unref (state->res);
 	g_object_unref (state->control);
-	if (state->proxy != NULL)
-		g_object_unref (state->proxy);
 	g_variant_unref (state->parameters);
 	g_slice_free (PkControlState, state);
 }
@@ -1557,26 +1481,6 @@ pk_control_get_time_since_action_internal (PkControlState *state)
 			   state);
 }
 
-/**
- * pk_control_get_time_since_action_proxy_cb:
- **/
-static void
-pk_control_get_time_since_action_proxy_cb (GObject *source_object,
-					   GAsyncResult *res,
-					   gpointer user_data)
-{
-	g_autoptr(GError) error = NULL;
-	PkControlState *state = (PkControlState *) user_data;
-
-	state->proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
-	if (state->proxy == NULL) {
-		pk_control_get_time_since_action_state_finish (state, error);
-		return;
-	}
-	pk_control_proxy_connect (state);
-	pk_control_get_time_since_action_internal (state);
-}
-
 /**
  * pk_control_get_time_since_action_async:
  * @control: a valid #PkControl instance
@@ -1626,20 +1530,10 @@ pk_control_get_time_since_action_async (PkControl *control,
 		return;
 	}
 
-	/* skip straight to the D-Bus method if already connection */
-	if (control->priv->proxy != NULL) {
-		pk_control_get_time_since_action_internal (state);
-	} else {
-		g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
-					  G_DBUS_PROXY_FLAGS_NONE,
-					  NULL,
-					  PK_DBUS_SERVICE,
-					  PK_DBUS_PATH,
-					  PK_DBUS_INTERFACE,
-					  control->priv->cancellable,
-					  pk_control_get_time_since_action_proxy_cb,
-					  state);
-	}
+	/* skip straight to the D-Bus method if already connected */
+	pk_control_call_with_proxy (state,
+				    pk_control_get_time_since_action_internal,
+				    pk_control_get_time_since_action_state_finish);
 
 	/* track state */
 	g_ptr_array_add (control->priv->calls, state);
@@ -1710,8 +1604,6 @@ pk_control_can_authorize_state_finish (PkControlState *state, const GError *erro
 	}
 	g_object_unref (state->res);
 	g_object_unref (state->control);
-	if (state->proxy != NULL)
-		g_object_unref (state->proxy);
 	g_variant_unref (state->parameters);
 	g_slice_free (PkControlState, state);
 }
@@ -1766,26 +1658,6 @@ pk_control_can_authorize_internal (PkControlState *state)
 			   state);
 }
 
-/**
- * pk_control_can_authorize_proxy_cb:
- **/
-static void
-pk_control_can_authorize_proxy_cb (GObject *source_object,
-				   GAsyncResult *res,
-				   gpointer user_data)
-{
-	g_autoptr(GError) error = NULL;
-	PkControlState *state = (PkControlState *) user_data;
-
-	state->proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
-	if (state->proxy == NULL) {
-		pk_control_can_authorize_state_finish (state, error);
-		return;
-	}
-	pk_control_proxy_connect (state);
-	pk_control_can_authorize_internal (state);
-}
-
 /**
  * pk_control_can_authorize_async:
  * @control: a valid #PkControl instance
@@ -1836,20 +1708,10 @@ pk_control_can_authorize_async (PkControl *control,
 	}
 	state->authorize = PK_AUTHORIZE_ENUM_UNKNOWN;
 
-	/* skip straight to the D-Bus method if already connection */
-	if (control->priv->proxy != NULL) {
-		pk_control_can_authorize_internal (state);
-	} else {
-		g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
-					  G_DBUS_PROXY_FLAGS_NONE,
-					  NULL,
-					  PK_DBUS_SERVICE,
-					  PK_DBUS_PATH,
-					  PK_DBUS_INTERFACE,
-					  control->priv->cancellable,
-					  pk_control_can_authorize_proxy_cb,
-					  state);
-	}
+	/* skip straight to the D-Bus method if already connected */
+	pk_control_call_with_proxy (state,
+				    pk_control_can_authorize_internal,
+				    pk_control_can_authorize_state_finish);
 
 	/* track state */
 	g_ptr_array_add (control->priv->calls, state);
@@ -1918,35 +1780,17 @@ pk_control_get_properties_state_finish (PkControlState *state, const GError *err
 	}
 	g_object_unref (state->res);
 	g_object_unref (state->control);
-	if (state->proxy != NULL)
-		g_object_unref (state->proxy);
 	g_slice_free (PkControlState, state);
 }
 
 /**
- * pk_control_get_properties_cb:
+ * pk_control_get_properties_internal:
  **/
 static void
-pk_control_get_properties_cb (GObject *source_object,
-			      GAsyncResult *res,
-			      gpointer user_data)
+pk_control_get_properties_internal (PkControlState *state)
 {
-	PkControlState *state = (PkControlState *) user_data;
-	g_autoptr(GError) error = NULL;
-
-	state->proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
-	if (state->proxy == NULL) {
-		pk_control_get_properties_state_finish (state, error);
-		return;
-	}
-
-	/* connect up proxy */
-	pk_control_proxy_connect (state);
-
-	/* save data */
+	/* the properties are cached on the proxy */
 	state->ret = TRUE;
-
-	/* we're done */
 	pk_control_get_properties_state_finish (state, NULL);
 }
 
@@ -1994,23 +1838,10 @@ pk_control_get_properties_async (PkControl *control,
 		return;
 	}
 
-	/* already done */
-	if (control->priv->proxy != NULL) {
-		state->ret = TRUE;
-		pk_control_get_properties_state_finish (state, NULL);
-		return;
-	}
-
-	/* get a connection to the main interface */
-	g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
-				  G_DBUS_PROXY_FLAGS_NONE,
-				  NULL,
-				  PK_DBUS_SERVICE,
-				  PK_DBUS_PATH,
-				  PK_DBUS_INTERFACE,
-				  control->priv->cancellable,
-				  pk_control_get_properties_cb,
-				  state);
+	/* already done if we have the proxy */
+	pk_control_call_with_proxy (state,
+				    pk_control_get_properties_internal,
+				    pk_control_get_properties_state_finish);
 
 	/* track state */
 	g_ptr_array_add (control->priv->calls, state);
@@ -2393,10 +2224,9 @@ pk_control_name_vanished_cb (GDBusConnection *connection,
 	g_debug ("notify::connected");
 	g_object_notify (G_OBJECT(control), "connected");
 
-	/* destroy the proxy, as even though it's "well known" we get a
-	 * GDBus.Error:org.freedesktop.DBus.Error.ServiceUnknown if we try to
-	 * use this after the server has restarted */
-	pk_control_proxy_destroy (control);
+	/* keep the proxy: it follows the name owner, so new calls activate
+	 * the daemon again and the properties are reloaded when it is back,
+	 * rather than every client fetching them and adding match rules anew */
 }
 
 /**
@@ -2413,6 +2243,7 @@ pk_control_init (PkControl *control)
 	control->priv->version_micro = G_MAXUINT;
 	control->priv->cancellable = g_cancellable_new ();
 	control->priv->calls = g_ptr_array_new ();
+	control->priv->proxy_waiters = g_ptr_array_new_with_free_func (g_free);
 	control->priv->watch_id = g_bus_watch_name (G_BUS_TYPE_SYSTEM,
 						    PK_DBUS_SERVICE,
 						    G_BUS_NAME_WATCHER_FLAGS_NONE,
@@ -2455,6 +2286,7 @@ pk_control_finalize (GObject *object)
 	g_strfreev (priv->mime_types);
 	g_free (priv->distro_id);
 	g_ptr_array_unref (priv->calls);
+	g_ptr_array_unref (priv->proxy_waiters);
 	g_object_unref (priv->cancellable);
 
 	G_OBJECT_CLASS (pk_control_parent_class)->finalize (object);
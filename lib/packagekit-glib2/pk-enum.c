@@ -379,6 +379,100 @@ static const PkEnumMatch enum_transaction_flag[] = {
 	{0, NULL}
 };
 
+/**
+ * PkEnumIndex:
+ *
+ * Lookup tables for one #PkEnumMatch table, built the first time they are
+ * used so that converting to and from strings does not scan the table.
+ **/
+typedef struct {
+	const PkEnumMatch	*table;
+	GHashTable		*values;	/* string -> value */
+	const gchar		**strings;	/* indexed by value */
+	guint			 strings_len;
+	gsize			 once;
+} PkEnumIndex;
+
+static PkEnumIndex enum_exit_index = { enum_exit };
+static PkEnumIndex enum_status_index = { enum_status };
+static PkEnumIndex enum_role_index = { enum_role };
+static PkEnumIndex enum_error_index = { enum_error };
+static PkEnumIndex enum_restart_index = { enum_restart };
+static PkEnumIndex enum_filter_index = { enum_filter };
+static PkEnumIndex enum_group_index = { enum_group };
+static PkEnumIndex enum_update_state_index = { enum_update_state };
+static PkEnumIndex enum_info_index = { enum_info };
+static PkEnumIndex enum_sig_type_index = { enum_sig_type };
+static PkEnumIndex enum_upgrade_index = { enum_upgrade };
+static PkEnumIndex enum_network_index = { enum_network };
+static PkEnumIndex enum_media_type_index = { enum_media_type };
+static PkEnumIndex enum_authorize_type_index = { enum_authorize_type };
+static PkEnumIndex enum_upgrade_kind_index = { enum_upgrade_kind };
+static PkEnumIndex enum_transaction_flag_index = { enum_transaction_flag };
+
+/**
+ * pk_enum_index_ensure:
+ **/
+static PkEnumIndex *
+pk_enum_index_ensure (PkEnumIndex *idx)
+{
+	const PkEnumMatch *table;
+	guint i;
+	guint max = 0;
+
+	if (!g_once_init_enter (&idx->once))
+		return idx;
+
+	/* the first match wins, as with pk_enum_find_value() */
+	table = idx->table;
+	idx->values = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; table[i].string != NULL; i++) {
+		if (!g_hash_table_contains (idx->values, table[i].string)) {
+			g_hash_table_insert (idx->values,
+					     (gpointer) table[i].string,
+					     GUINT_TO_POINTER (table[i].value));
+		}
+		max = MAX (max, table[i].value);
+	}
+	idx->strings_len = max + 1;
+	idx->strings = g_new0 (const gchar *, idx->strings_len);
+	for (i = 0; table[i].string != NULL; i++) {
+		if (idx->strings[table[i].value] == NULL)
+			idx->strings[table[i].value] = table[i].string;
+	}
+	g_once_init_leave (&idx->once, 1);
+	return idx;
+}
+
+/**
+ * pk_enum_index_find_value:
+ **/
+static guint
+pk_enum_index_find_value (PkEnumIndex *idx, const gchar *string)
+{
+	gpointer value;
+
+	/* return the first entry on non-found or error */
+	if (string == NULL)
+		return idx->table[0].value;
+	pk_enum_index_ensure (idx);
+	if (!g_hash_table_lookup_extended (idx->values, string, NULL, &value))
+		return idx->table[0].value;
+	return GPOINTER_TO_UINT (value);
+}
+
+/**
+ * pk_enum_index_find_string:
+ **/
+static const gchar *
+pk_enum_index_find_string (PkEnumIndex *idx, guint value)
+{
+	pk_enum_index_ensure (idx);
+	if (value < idx->strings_len && idx->strings[value] != NULL)
+		return idx->strings[value];
+	return idx->table[0].string;
+}
+
 /**
  * pk_enum_find_value:
  * @table: A #PkEnumMatch enum table of values
@@ -447,7 +541,7 @@ pk_enum_find_string (const PkEnumMatch *table, guint value)
 PkSigTypeEnum
 pk_sig_type_enum_from_string (const gchar *sig_type)
 {
-	return pk_enum_find_value (enum_sig_type, sig_type);
+	return pk_enum_index_find_value (&enum_sig_type_index, sig_type);
 }
 
 /**
@@ -463,7 +557,7 @@ pk_sig_type_enum_from_string (const gchar *sig_type)
 const gchar *
 pk_sig_type_enum_to_string (PkSigTypeEnum sig_type)
 {
-	return pk_enum_find_string (enum_sig_type, sig_type);
+	return pk_enum_index_find_string (&enum_sig_type_index, sig_type);
 }
 
 /**
@@ -479,7 +573,7 @@ pk_sig_type_enum_to_string (PkSigTypeEnum sig_type)
 PkDistroUpgradeEnum
 pk_distro_upgrade_enum_from_string (const gchar *upgrade)
 {
-	return pk_enum_find_value (enum_upgrade, upgrade);
+	return pk_enum_index_find_value (&enum_upgrade_index, upgrade);
 }
 
 /**
@@ -495,7 +589,7 @@ pk_distro_upgrade_enum_from_string (const gchar *upgrade)
 const gchar *
 pk_distro_upgrade_enum_to_string (PkDistroUpgradeEnum upgrade)
 {
-	return pk_enum_find_string (enum_upgrade, upgrade);
+	return pk_enum_index_find_string (&enum_upgrade_index, upgrade);
 }
 
 /**
@@ -511,7 +605,7 @@ pk_distro_upgrade_enum_to_string (PkDistroUpgradeEnum upgrade)
 PkInfoEnum
 pk_info_enum_from_string (const gchar *info)
 {
-	return pk_enum_find_value (enum_info, info);
+	return pk_enum_index_find_value (&enum_info_index, info);
 }
 
 /**
@@ -527,7 +621,7 @@ pk_info_enum_from_string (const gchar *info)
 const gchar *
 pk_info_enum_to_string (PkInfoEnum info)
 {
-	return pk_enum_find_string (enum_info, info);
+	return pk_enum_index_find_string (&enum_info_index, info);
 }
 
 /**
@@ -543,7 +637,7 @@ pk_info_enum_to_string (PkInfoEnum info)
 PkExitEnum
 pk_exit_enum_from_string (const gchar *exit_text)
 {
-	return pk_enum_find_value (enum_exit, exit_text);
+	return pk_enum_index_find_value (&enum_exit_index, exit_text);
 }
 
 /**
@@ -559,7 +653,7 @@ pk_exit_enum_from_string (const gchar *exit_text)
 const gchar *
 pk_exit_enum_to_string (PkExitEnum exit_enum)
 {
-	return pk_enum_find_string (enum_exit, exit_enum);
+	return pk_enum_index_find_string (&enum_exit_index, exit_enum);
 }
 
 /**
@@ -575,7 +669,7 @@ pk_exit_enum_to_string (PkExitEnum exit_enum)
 PkNetworkEnum
 pk_network_enum_from_string (const gchar *network)
 {
-	return pk_enum_find_value (enum_network, network);
+	return pk_enum_index_find_value (&enum_network_index, network);
 }
 
 /**
@@ -591,7 +685,7 @@ pk_network_enum_from_string (const gchar *network)
 const gchar *
 pk_network_enum_to_string (PkNetworkEnum network)
 {
-	return pk_enum_find_string (enum_network, network);
+	return pk_enum_index_find_string (&enum_network_index, network);
 }
 
 /**
@@ -607,7 +701,7 @@ pk_network_enum_to_string (PkNetworkEnum network)
 PkStatusEnum
 pk_status_enum_from_string (const gchar *status)
 {
-	return pk_enum_find_value (enum_status, status);
+	return pk_enum_index_find_value (&enum_status_index, status);
 }
 
 /**
@@ -623,7 +717,7 @@ pk_status_enum_from_string (const gchar *status)
 const gchar *
 pk_status_enum_to_string (PkStatusEnum status)
 {
-	return pk_enum_find_string (enum_status, status);
+	return pk_enum_index_find_string (&enum_status_index, status);
 }
 
 /**
@@ -639,7 +733,7 @@ pk_status_enum_to_string (PkStatusEnum status)
 PkRoleEnum
 pk_role_enum_from_string (const gchar *role)
 {
-	return pk_enum_find_value (enum_role, role);
+	return pk_enum_index_find_value (&enum_role_index, role);
 }
 
 /**
@@ -655,7 +749,7 @@ pk_role_enum_from_string (const gchar *role)
 const gchar *
 pk_role_enum_to_string (PkRoleEnum role)
 {
-	return pk_enum_find_string (enum_role, role);
+	return pk_enum_index_find_string (&enum_role_index, role);
 }
 
 /**
@@ -671,7 +765,7 @@ pk_role_enum_to_string (PkRoleEnum role)
 PkErrorEnum
 pk_error_enum_from_string (const gchar *code)
 {
-	return pk_enum_find_value (enum_error, code);
+	return pk_enum_index_find_value (&enum_error_index, code);
 }
 
 /**
@@ -687,7 +781,7 @@ pk_error_enum_from_string (const gchar *code)
 const gchar *
 pk_error_enum_to_string (PkErrorEnum code)
 {
-	return pk_enum_find_string (enum_error, code);
+	return pk_enum_index_find_string (&enum_error_index, code);
 }
 
 /**
@@ -703,7 +797,7 @@ pk_error_enum_to_string (PkErrorEnum code)
 PkRestartEnum
 pk_restart_enum_from_string (const gchar *restart)
 {
-	return pk_enum_find_value (enum_restart, restart);
+	return pk_enum_index_find_value (&enum_restart_index, restart);
 }
 
 /**
@@ -719,7 +813,7 @@ pk_restart_enum_from_string (const gchar *restart)
 const gchar *
 pk_restart_enum_to_string (PkRestartEnum restart)
 {
-	return pk_enum_find_string (enum_restart, restart);
+	return pk_enum_index_find_string (&enum_restart_index, restart);
 }
 
 /**
@@ -735,7 +829,7 @@ pk_restart_enum_to_string (PkRestartEnum restart)
 PkGroupEnum
 pk_group_enum_from_string (const gchar *group)
 {
-	return pk_enum_find_value (enum_group, group);
+	return pk_enum_index_find_value (&enum_group_index, group);
 }
 
 /**
@@ -751,7 +845,7 @@ pk_group_enum_from_string (const gchar *group)
 const gchar *
 pk_group_enum_to_string (PkGroupEnum group)
 {
-	return pk_enum_find_string (enum_group, group);
+	return pk_enum_index_find_string (&enum_group_index, group);
 }
 
 /**
@@ -767,7 +861,7 @@ pk_group_enum_to_string (PkGroupEnum group)
 PkUpdateStateEnum
 pk_update_state_enum_from_string (const gchar *update_state)
 {
-	return pk_enum_find_value (enum_update_state, update_state);
+	return pk_enum_index_find_value (&enum_update_state_index, update_state);
 }
 
 /**
@@ -783,7 +877,7 @@ pk_update_state_enum_from_string (const gchar *update_state)
 const gchar *
 pk_update_state_enum_to_string (PkUpdateStateEnum update_state)
 {
-	return pk_enum_find_string (enum_update_state, update_state);
+	return pk_enum_index_find_string (&enum_update_state_index, update_state);
 }
 
 /**
@@ -799,7 +893,7 @@ pk_update_state_enum_to_string (PkUpdateStateEnum update_state)
 PkFilterEnum
 pk_filter_enum_from_string (const gchar *filter)
 {
-	return pk_enum_find_value (enum_filter, filter);
+	return pk_enum_index_find_value (&enum_filter_index, filter);
 }
 
 /**
@@ -815,7 +909,7 @@ pk_filter_enum_from_string (const gchar *filter)
 const gchar *
 pk_filter_enum_to_string (PkFilterEnum filter)
 {
-	return pk_enum_find_string (enum_filter, filter);
+	return pk_enum_index_find_string (&enum_filter_index, filter);
 }
 
 /**
@@ -831,7 +925,7 @@ pk_filter_enum_to_string (PkFilterEnum filter)
 PkMediaTypeEnum
 pk_media_type_enum_from_string (const gchar *media_type)
 {
-	return pk_enum_find_value (enum_media_type, media_type);
+	return pk_enum_index_find_value (&enum_media_type_index, media_type);
 }
 
 /**
@@ -847,7 +941,7 @@ pk_media_type_enum_from_string (const gchar *media_type)
 const gchar *
 pk_media_type_enum_to_string (PkMediaTypeEnum media_type)
 {
-	return pk_enum_find_string (enum_media_type, media_type);
+	return pk_enum_index_find_string (&enum_media_type_index, media_type);
 }
 
 /**
@@ -863,7 +957,7 @@ pk_media_type_enum_to_string (PkMediaTypeEnum media_type)
 PkAuthorizeEnum
 pk_authorize_type_enum_from_string (const gchar *authorize_type)
 {
-	return pk_enum_find_value (enum_authorize_type, authorize_type);
+	return pk_enum_index_find_value (&enum_authorize_type_index, authorize_type);
 }
 
 /**
@@ -879,7 +973,7 @@ pk_authorize_type_enum_from_string (const gchar *authorize_type)
 const gchar *
 pk_authorize_type_enum_to_string (PkAuthorizeEnum authorize_type)
 {
-	return pk_enum_find_string (enum_authorize_type, authorize_type);
+	return pk_enum_index_find_string (&enum_authorize_type_index, authorize_type);
 }
 
 /**
@@ -895,7 +989,7 @@ pk_authorize_type_enum_to_string (PkAuthorizeEnum authorize_type)
 PkUpgradeKindEnum
 pk_upgrade_kind_enum_from_string (const gchar *upgrade_kind)
 {
-	return pk_enum_find_value (enum_upgrade_kind, upgrade_kind);
+	return pk_enum_index_find_value (&enum_upgrade_kind_index, upgrade_kind);
 }
 
 /**
@@ -911,7 +1005,7 @@ pk_upgrade_kind_enum_from_string (const gchar *upgrade_kind)
 const gchar *
 pk_upgrade_kind_enum_to_string (PkUpgradeKindEnum upgrade_kind)
 {
-	return pk_enum_find_string (enum_upgrade_kind, upgrade_kind);
+	return pk_enum_index_find_string (&enum_upgrade_kind_index, upgrade_kind);
 }
 
 /**
@@ -927,7 +1021,7 @@ pk_upgrade_kind_enum_to_string (PkUpgradeKindEnum upgrade_kind)
 PkTransactionFlagEnum
 pk_transaction_flag_enum_from_string (const gchar *transaction_flag)
 {
-	return pk_enum_find_value (enum_transaction_flag, transaction_flag);
+	return pk_enum_index_find_value (&enum_transaction_flag_index, transaction_flag);
 }
 
 /**
@@ -943,7 +1037,7 @@ pk_transaction_flag_enum_from_string (const gchar *transaction_flag)
 const gchar *
 pk_transaction_flag_enum_to_string (PkTransactionFlagEnum transaction_flag)
 {
-	return pk_enum_find_string (enum_transaction_flag, transaction_flag);
+	return pk_enum_index_find_string (&enum_transaction_flag_index, transaction_flag);
 }
 
 /**
@@ -26,10 +26,125 @@
 
 #include "config.h"
 
+#include <string.h>
 #include <glib.h>
 
 #include <packagekit-glib2/pk-package-id.h>
 
+/**
+ * pk_package_id_view_parse:
+ *
+ * Finds the sections of a PackageID in one pass, without copying.
+ * UTF-8 validation is only needed when a non-ASCII byte is seen.
+ **/
+static gboolean
+pk_package_id_view_parse (PkPackageIdView *view,
+			  const gchar *package_id,
+			  gboolean validate_utf8)
+{
+	gboolean ascii = TRUE;
+	guint cnt = 0;
+	guint i;
+
+	if (package_id == NULL)
+		return FALSE;
+
+	view->package_id = package_id;
+	view->offset[0] = 0;
+	for (i = 0; package_id[i] != '\0'; i++) {
+		if ((guchar) package_id[i] >= 0x80) {
+			ascii = FALSE;
+			continue;
+		}
+		if (package_id[i] != ';')
+			continue;
+		if (++cnt > 3)
+			return FALSE;
+		view->length[cnt - 1] = i - view->offset[cnt - 1];
+		view->offset[cnt] = i + 1;
+	}
+	if (cnt != 3)
+		return FALSE;
+	view->length[3] = i - view->offset[3];
+
+	/* name has to be valid */
+	if (view->length[PK_PACKAGE_ID_NAME] == 0)
+		return FALSE;
+
+	/* UTF8 */
+	if (validate_utf8 && !ascii && !g_utf8_validate (package_id, i, NULL))
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * pk_package_id_view_init:
+ * @view: a #PkPackageIdView to fill in
+ * @package_id: the ; delimited PackageID
+ *
+ * Checks a PackageID and finds its sections without allocating any
+ * memory. The view points into @package_id, which has to stay valid for
+ * as long as the view is used.
+ *
+ * Return value: %TRUE if the PackageID was well formed
+ *
+ * Since: 1.1.3
+ **/
+gboolean
+pk_package_id_view_init (PkPackageIdView *view, const gchar *package_id)
+{
+	g_return_val_if_fail (view != NULL, FALSE);
+	return pk_package_id_view_parse (view, package_id, TRUE);
+}
+
+/**
+ * pk_package_id_view_section_equal:
+ * @view: a #PkPackageIdView
+ * @section: the section, e.g. %PK_PACKAGE_ID_ARCH
+ * @value: the string to compare to, or %NULL
+ *
+ * Compares one section of a PackageID without copying it.
+ *
+ * Return value: %TRUE if the section is exactly @value
+ *
+ * Since: 1.1.3
+ **/
+gboolean
+pk_package_id_view_section_equal (const PkPackageIdView *view,
+				  guint section,
+				  const gchar *value)
+{
+	g_return_val_if_fail (view != NULL, FALSE);
+	g_return_val_if_fail (section <= PK_PACKAGE_ID_DATA, FALSE);
+
+	if (value == NULL)
+		return FALSE;
+	if (strncmp (view->package_id + view->offset[section],
+		     value, view->length[section]) != 0)
+		return FALSE;
+	return value[view->length[section]] == '\0';
+}
+
+/**
+ * pk_package_id_view_dup_section:
+ * @view: a #PkPackageIdView
+ * @section: the section, e.g. %PK_PACKAGE_ID_NAME
+ *
+ * Copies one section of a PackageID.
+ *
+ * Return value: the section, use g_free() to free.
+ *
+ * Since: 1.1.3
+ **/
+gchar *
+pk_package_id_view_dup_section (const PkPackageIdView *view, guint section)
+{
+	g_return_val_if_fail (view != NULL, NULL);
+	g_return_val_if_fail (section <= PK_PACKAGE_ID_DATA, NULL);
+	return g_strndup (view->package_id + view->offset[section],
+			  view->length[section]);
+}
+
 /**
  * pk_package_id_split:
  * @package_id: the ; delimited PackageID to split
@@ -44,22 +159,17 @@
 gchar **
 pk_package_id_split (const gchar *package_id)
 {
-	gchar **sections = NULL;
+	gchar **sections;
+	guint i;
+	PkPackageIdView view;
 
-	if (package_id == NULL)
-		goto out;
-
-	/* split by delimeter ';' */
-	sections = g_strsplit (package_id, ";", -1);
-	if (g_strv_length (sections) != 4)
-		goto out;
-
-	/* name has to be valid */
-	if (sections[0][0] != '\0')
-		return sections;
-out:
-	g_strfreev (sections);
-	return NULL;
+	if (!pk_package_id_view_parse (&view, package_id, FALSE))
+		return NULL;
+	sections = g_new (gchar *, 5);
+	for (i = 0; i < 4; i++)
+		sections[i] = pk_package_id_view_dup_section (&view, i);
+	sections[4] = NULL;
+	return sections;
 }
 
 /**
@@ -73,23 +183,8 @@ out:
 gboolean
 pk_package_id_check (const gchar *package_id)
 {
-	g_auto(GStrv) sections = NULL;
-	gboolean ret;
-
-	/* NULL check */
-	if (package_id == NULL)
-		return FALSE;
-
-	/* UTF8 */
-	ret = g_utf8_validate (package_id, -1, NULL);
-	if (!ret)
-		return FALSE;
-
-	/* correct number of sections */
-	sections = pk_package_id_split (package_id);
-	if (sections == NULL)
-		return FALSE;
-	return TRUE;
+	PkPackageIdView view;
+	return pk_package_id_view_parse (&view, package_id, TRUE);
 }
 
 /**
@@ -120,27 +215,13 @@ pk_package_id_build (const gchar *name, const gchar *version,
  * pk_arch_base_ix86:
  **/
 static gboolean
-pk_arch_base_ix86 (const gchar *arch)
+pk_arch_base_ix86 (const gchar *arch, guint len)
 {
-	if (g_strcmp0 (arch, "i386") == 0 ||
-	    g_strcmp0 (arch, "i486") == 0 ||
-	    g_strcmp0 (arch, "i586") == 0 ||
-	    g_strcmp0 (arch, "i686") == 0)
-		return TRUE;
-	return FALSE;
-}
-
-/**
- * pk_package_id_equal_fuzzy_arch_section:
- **/
-static gboolean
-pk_package_id_equal_fuzzy_arch_section (const gchar *arch1, const gchar *arch2)
-{
-	if (g_strcmp0 (arch1, arch2) == 0)
-		return TRUE;
-	if (pk_arch_base_ix86 (arch1) && pk_arch_base_ix86 (arch2))
-		return TRUE;
-	return FALSE;
+	return len == 4 &&
+	       arch[0] == 'i' &&
+	       arch[1] >= '3' && arch[1] <= '6' &&
+	       arch[2] == '8' &&
+	       arch[3] == '6';
 }
 
 /**
@@ -158,16 +239,29 @@ pk_package_id_equal_fuzzy_arch_section (const gchar *arch1, const gchar *arch2)
 gboolean
 pk_package_id_equal_fuzzy_arch (const gchar *package_id1, const gchar *package_id2)
 {
-	g_auto(GStrv) sections1 = NULL;
-	g_auto(GStrv) sections2 = NULL;
-
-	sections1 = pk_package_id_split (package_id1);
-	sections2 = pk_package_id_split (package_id2);
-	if (g_strcmp0 (sections1[0], sections2[0]) == 0 &&
-	    g_strcmp0 (sections1[1], sections2[1]) == 0 &&
-	    pk_package_id_equal_fuzzy_arch_section (sections1[2], sections2[2]))
+	PkPackageIdView view1;
+	PkPackageIdView view2;
+	const gchar *arch1;
+	const gchar *arch2;
+
+	if (!pk_package_id_view_parse (&view1, package_id1, FALSE) ||
+	    !pk_package_id_view_parse (&view2, package_id2, FALSE))
+		return FALSE;
+
+	/* the name and version, including the delimiters, have to match */
+	if (view1.offset[PK_PACKAGE_ID_ARCH] != view2.offset[PK_PACKAGE_ID_ARCH] ||
+	    view1.length[PK_PACKAGE_ID_NAME] != view2.length[PK_PACKAGE_ID_NAME] ||
+	    strncmp (package_id1, package_id2, view1.offset[PK_PACKAGE_ID_ARCH]) != 0)
+		return FALSE;
+
+	/* the arch can be any i*86 */
+	arch1 = package_id1 + view1.offset[PK_PACKAGE_ID_ARCH];
+	arch2 = package_id2 + view2.offset[PK_PACKAGE_ID_ARCH];
+	if (view1.length[PK_PACKAGE_ID_ARCH] == view2.length[PK_PACKAGE_ID_ARCH] &&
+	    strncmp (arch1, arch2, view1.length[PK_PACKAGE_ID_ARCH]) == 0)
 		return TRUE;
-	return FALSE;
+	return pk_arch_base_ix86 (arch1, view1.length[PK_PACKAGE_ID_ARCH]) &&
+	       pk_arch_base_ix86 (arch2, view2.length[PK_PACKAGE_ID_ARCH]);
 }
 
 /**
@@ -183,31 +277,33 @@ pk_package_id_equal_fuzzy_arch (const gchar *package_id1, const gchar *package_i
 gchar *
 pk_package_id_to_printable (const gchar *package_id)
 {
-	g_auto(GStrv) parts = NULL;
-	gchar *value = NULL;
-	GString *string = NULL;
+	GString *string;
+	PkPackageIdView view;
 
 	/* invalid */
-	if (package_id == NULL)
-		goto out;
-
-	/* split */
-	parts = pk_package_id_split (package_id);
-	if (parts == NULL)
-		goto out;
+	if (!pk_package_id_view_parse (&view, package_id, FALSE))
+		return NULL;
 
 	/* name */
-	string = g_string_new (parts[PK_PACKAGE_ID_NAME]);
+	string = g_string_sized_new (view.offset[PK_PACKAGE_ID_DATA] + 1);
+	g_string_append_len (string,
+			     package_id + view.offset[PK_PACKAGE_ID_NAME],
+			     view.length[PK_PACKAGE_ID_NAME]);
 
 	/* version if present */
-	if (parts[PK_PACKAGE_ID_VERSION][0] != '\0')
-		g_string_append_printf (string, "-%s", parts[PK_PACKAGE_ID_VERSION]);
+	if (view.length[PK_PACKAGE_ID_VERSION] > 0) {
+		g_string_append_c (string, '-');
+		g_string_append_len (string,
+				     package_id + view.offset[PK_PACKAGE_ID_VERSION],
+				     view.length[PK_PACKAGE_ID_VERSION]);
+	}
 
 	/* arch if present */
-	if (parts[PK_PACKAGE_ID_ARCH][0] != '\0')
-		g_string_append_printf (string, ".%s", parts[PK_PACKAGE_ID_ARCH]);
-out:
-	if (string != NULL)
-		value = g_string_free (string, FALSE);
-	return value;
+	if (view.length[PK_PACKAGE_ID_ARCH] > 0) {
+		g_string_append_c (string, '.');
+		g_string_append_len (string,
+				     package_id + view.offset[PK_PACKAGE_ID_ARCH],
+				     view.length[PK_PACKAGE_ID_ARCH]);
+	}
+	return g_string_free (string, FALSE);
 }
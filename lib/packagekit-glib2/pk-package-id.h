@@ -58,6 +58,20 @@ G_BEGIN_DECLS
  */
 #define PK_PACKAGE_ID_DATA	3
 
+/**
+ * PkPackageIdView:
+ * @package_id: the PackageID the view points into
+ * @offset: the byte offset of each section, e.g. @offset[%PK_PACKAGE_ID_ARCH]
+ * @length: the length in bytes of each section
+ *
+ * The sections of a PackageID found without copying them.
+ **/
+typedef struct {
+	const gchar	*package_id;
+	guint		 offset[4];
+	guint		 length[4];
+} PkPackageIdView;
+
 void		 pk_package_id_test			(gpointer		 user_data);
 gchar		*pk_package_id_build			(const gchar		*name,
 							 const gchar		*version,
@@ -68,6 +82,13 @@ gchar		**pk_package_id_split			(const gchar		*package_id);
 gchar		*pk_package_id_to_printable		(const gchar		*package_id);
 gboolean	 pk_package_id_equal_fuzzy_arch		(const gchar		*package_id1,
 							 const gchar		*package_id2);
+gboolean	 pk_package_id_view_init		(PkPackageIdView	*view,
+							 const gchar		*package_id);
+gboolean	 pk_package_id_view_section_equal	(const PkPackageIdView	*view,
+							 guint			 section,
+							 const gchar		*value);
+gchar		*pk_package_id_view_dup_section		(const PkPackageIdView	*view,
+							 guint			 section);
 G_END_DECLS
 
 #endif /* __PK_PACKAGE_ID_H */
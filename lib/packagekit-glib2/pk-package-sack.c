@@ -52,7 +52,11 @@ static void     pk_package_sack_finalize	(GObject     *object);
 struct _PkPackageSackPrivate
 {
 	GHashTable		*table;
-	GPtrArray		*array;
+	GHashTable		*positions;	/* PkPackage -> index in array */
+	GHashTable		*names;		/* name -> GPtrArray of PkPackage */
+	GHashTable		*name_arches;	/* "name;arch" -> GPtrArray of PkPackage */
+	GPtrArray		*array;		/* may contain NULL for removed packages */
+	guint			 tombstones;	/* number of NULL entries in array */
 	PkClient		*client;
 };
 
@@ -63,6 +67,135 @@ enum {
 
 G_DEFINE_TYPE (PkPackageSack, pk_package_sack, G_TYPE_OBJECT)
 
+/**
+ * pk_package_sack_index_key_name_arch:
+ **/
+static gchar *
+pk_package_sack_index_key_name_arch (const gchar *name, const gchar *arch)
+{
+	return g_strdup_printf ("%s;%s", name, arch);
+}
+
+/**
+ * pk_package_sack_index_add:
+ **/
+static void
+pk_package_sack_index_add (GHashTable *hash, gchar *key, PkPackage *package)
+{
+	GPtrArray *bucket;
+
+	bucket = g_hash_table_lookup (hash, key);
+	if (bucket == NULL) {
+		bucket = g_ptr_array_new ();
+		g_hash_table_insert (hash, key, bucket);
+	} else {
+		g_free (key);
+	}
+	g_ptr_array_add (bucket, package);
+}
+
+/**
+ * pk_package_sack_index_remove:
+ **/
+static void
+pk_package_sack_index_remove (GHashTable *hash, const gchar *key, PkPackage *package)
+{
+	GPtrArray *bucket;
+
+	bucket = g_hash_table_lookup (hash, key);
+	if (bucket == NULL)
+		return;
+	g_ptr_array_remove (bucket, package);
+	if (bucket->len == 0)
+		g_hash_table_remove (hash, key);
+}
+
+/**
+ * pk_package_sack_index_package:
+ *
+ * Adds the package to the name and name-arch lookup tables.
+ **/
+static void
+pk_package_sack_index_package (PkPackageSack *sack, PkPackage *package)
+{
+	PkPackageSackPrivate *priv = sack->priv;
+	const gchar *name = pk_package_get_name (package);
+
+	pk_package_sack_index_add (priv->names, g_strdup (name), package);
+	pk_package_sack_index_add (priv->name_arches,
+				   pk_package_sack_index_key_name_arch (name, pk_package_get_arch (package)),
+				   package);
+}
+
+/**
+ * pk_package_sack_unindex_package:
+ **/
+static void
+pk_package_sack_unindex_package (PkPackageSack *sack, PkPackage *package)
+{
+	PkPackageSackPrivate *priv = sack->priv;
+	const gchar *name = pk_package_get_name (package);
+	g_autofree gchar *key = NULL;
+
+	key = pk_package_sack_index_key_name_arch (name, pk_package_get_arch (package));
+	pk_package_sack_index_remove (priv->name_arches, key, package);
+	pk_package_sack_index_remove (priv->names, name, package);
+}
+
+/**
+ * pk_package_sack_update_positions:
+ *
+ * Rebuilds the package to array index map, e.g. after sorting.
+ **/
+static void
+pk_package_sack_update_positions (PkPackageSack *sack)
+{
+	PkPackageSackPrivate *priv = sack->priv;
+	guint i;
+
+	g_hash_table_remove_all (priv->positions);
+	for (i = 0; i < priv->array->len; i++) {
+		g_hash_table_insert (priv->positions,
+				     g_ptr_array_index (priv->array, i),
+				     GUINT_TO_POINTER (i));
+	}
+}
+
+/**
+ * pk_package_sack_compact:
+ *
+ * Closes the gaps left by removed packages, keeping the order of the others.
+ * Removal only leaves a %NULL in the array, so this has to be called before
+ * the array is iterated or handed out.
+ **/
+static void
+pk_package_sack_compact (PkPackageSack *sack)
+{
+	PkPackageSackPrivate *priv = sack->priv;
+	PkPackage *package;
+	guint i;
+	guint j = 0;
+
+	if (priv->tombstones == 0)
+		return;
+	for (i = 0; i < priv->array->len; i++) {
+		package = g_ptr_array_index (priv->array, i);
+		if (package == NULL)
+			continue;
+		if (i != j) {
+			g_ptr_array_index (priv->array, j) = package;
+			g_hash_table_insert (priv->positions, package, GUINT_TO_POINTER (j));
+		}
+		j++;
+	}
+
+	/* only the NULL entries are cut off */
+	g_ptr_array_set_free_func (priv->array, NULL);
+	g_ptr_array_set_size (priv->array, j);
+	g_ptr_array_set_free_func (priv->array, g_object_unref);
+	priv->tombstones = 0;
+}
+
 /**
  * pk_package_sack_clear:
  * @sack: a valid #PkPackageSack instance
@@ -76,8 +209,12 @@ pk_package_sack_clear (PkPackageSack *sack)
 {
 	g_return_if_fail (PK_IS_PACKAGE_SACK (sack));
 
-	g_ptr_array_set_size (sack->priv->array, 0);
+	pk_package_sack_compact (sack);
 	g_hash_table_remove_all (sack->priv->table);
+	g_hash_table_remove_all (sack->priv->positions);
+	g_hash_table_remove_all (sack->priv->names);
+	g_hash_table_remove_all (sack->priv->name_arches);
+	g_ptr_array_set_size (sack->priv->array, 0);
 }
 
 /**
@@ -95,7 +232,7 @@ pk_package_sack_get_size (PkPackageSack *sack)
 {
 	g_return_val_if_fail (PK_IS_PACKAGE_SACK (sack), 0);
 
-	return sack->priv->array->len;
+	return sack->priv->array->len - sack->priv->tombstones;
 }
 
 /**
@@ -118,6 +255,7 @@ pk_package_sack_get_ids (PkPackageSack *sack)
 
 	g_return_val_if_fail (PK_IS_PACKAGE_SACK (sack), NULL);
 
+	pk_package_sack_compact (sack);
 	array = sack->priv->array;
 	package_ids = g_new0 (gchar *, array->len + 1);
 	for (i = 0; i < array->len; i++) {
@@ -141,6 +279,7 @@ GPtrArray *
 pk_package_sack_get_array (PkPackageSack *sack)
 {
 	g_return_val_if_fail (PK_IS_PACKAGE_SACK (sack), NULL);
+	pk_package_sack_compact (sack);
 	return g_ptr_array_ref (sack->priv->array);
 }
 
@@ -169,6 +308,7 @@ pk_package_sack_filter_by_info (PkPackageSack *sack, PkInfoEnum info)
 
 	/* create new sack */
 	results = pk_package_sack_new ();
+	pk_package_sack_compact (sack);
 
 	/* add each that matches the info enum */
 	for (i = 0; i < priv->array->len; i++) {
@@ -207,6 +347,7 @@ pk_package_sack_filter (PkPackageSack *sack, PkPackageSackFilterFunc filter_cb,
 
 	/* create new sack */
 	results = pk_package_sack_new ();
+	pk_package_sack_compact (sack);
 
 	/* add each that matches the info enum */
 	for (i = 0; i < priv->array->len; i++) {
@@ -224,26 +365,73 @@ pk_package_sack_filter (PkPackageSack *sack, PkPackageSackFilterFunc filter_cb,
  *
  * Adds a package to the sack.
  *
- * Return value: %TRUE if the package was added to the sack
+ * Return value: %TRUE if the package was added to the sack, or %FALSE if
+ * this exact object is already in the sack
  *
  * Since: 0.5.2
  **/
 gboolean
 pk_package_sack_add_package (PkPackageSack *sack, PkPackage *package)
 {
+	PkPackageSackPrivate *priv;
+
 	g_return_val_if_fail (PK_IS_PACKAGE_SACK (sack), FALSE);
 	g_return_val_if_fail (PK_IS_PACKAGE (package), FALSE);
 
+	priv = sack->priv;
+	if (g_hash_table_contains (priv->positions, package))
+		return FALSE;
+
 	/* add to array */
-	g_ptr_array_add (sack->priv->array,
+	g_hash_table_insert (priv->positions,
+			     package,
+			     GUINT_TO_POINTER (priv->array->len));
+	g_ptr_array_add (priv->array,
 			 g_object_ref (package));
-	g_hash_table_insert (sack->priv->table,
-			     (gpointer) pk_package_get_id (package),
-			     (gpointer) package);
+	/* replace the key too, as it belongs to the package it points at */
+	g_hash_table_replace (priv->table,
+			      (gpointer) pk_package_get_id (package),
+			      (gpointer) package);
+	pk_package_sack_index_package (sack, package);
 
 	return TRUE;
 }
 
+/**
+ * pk_package_sack_merge:
+ * @sack: a valid #PkPackageSack instance
+ * @other: a #PkPackageSack to take packages from
+ *
+ * Adds all the packages from @other to @sack, skipping any package with
+ * a package ID that is already in @sack. The packages are shared and not
+ * copied.
+ *
+ * Return value: the number of packages that were added
+ *
+ * Since: 1.1.3
+ **/
+guint
+pk_package_sack_merge (PkPackageSack *sack, PkPackageSack *other)
+{
+	PkPackage *package;
+	guint added = 0;
+	guint i;
+
+	g_return_val_if_fail (PK_IS_PACKAGE_SACK (sack), 0);
+	g_return_val_if_fail (PK_IS_PACKAGE_SACK (other), 0);
+
+	pk_package_sack_compact (other);
+	for (i = 0; i < other->priv->array->len; i++) {
+		package = g_ptr_array_index (other->priv->array, i);
+		if (g_hash_table_contains (sack->priv->table,
+					   pk_package_get_id (package)))
+			continue;
+		if (pk_package_sack_add_package (sack, package))
+			added++;
+	}
+	return added;
+}
+
 /**
  * pk_package_sack_add_package_by_id:
  * @sack: a valid #PkPackageSack instance
@@ -374,6 +562,7 @@ pk_package_sack_to_file (PkPackageSack *sack, GFile *file, GError **error)
 	PkPackage *pkg;
 	g_autoptr(GString) string = NULL;
 
+	pk_package_sack_compact (sack);
 	string = g_string_new ("");
 	for (i = 0; i < sack->priv->array->len; i++) {
 		pkg = g_ptr_array_index (sack->priv->array, i);
@@ -397,6 +586,39 @@ pk_package_sack_to_file (PkPackageSack *sack, GFile *file, GError **error)
 	return TRUE;
 }
 
+/**
+ * pk_package_sack_forget_package:
+ *
+ * Drops the package from the lookup tables, but not from the array.
+ **/
+static void
+pk_package_sack_forget_package (PkPackageSack *sack, PkPackage *package)
+{
+	const gchar *package_id;
+	guint i;
+	GPtrArray *bucket;
+	PkPackageSackPrivate *priv = sack->priv;
+
+	g_hash_table_remove (priv->positions, package);
+	pk_package_sack_unindex_package (sack, package);
+
+	/* point the ID at any other package with the same ID */
+	package_id = pk_package_get_id (package);
+	if (g_hash_table_lookup (priv->table, package_id) != package)
+		return;
+	g_hash_table_remove (priv->table, package_id);
+	bucket = g_hash_table_lookup (priv->names, pk_package_get_name (package));
+	for (i = 0; bucket != NULL && i < bucket->len; i++) {
+		PkPackage *tmp = g_ptr_array_index (bucket, i);
+		if (g_strcmp0 (pk_package_get_id (tmp), package_id) == 0) {
+			g_hash_table_replace (priv->table,
+					      (gpointer) pk_package_get_id (tmp),
+					      tmp);
+			break;
+		}
+	}
+}
+
 /**
  * pk_package_sack_remove_package:
  * @sack: a valid #PkPackageSack instance
@@ -411,12 +633,24 @@ pk_package_sack_to_file (PkPackageSack *sack, GFile *file, GError **error)
 gboolean
 pk_package_sack_remove_package (PkPackageSack *sack, PkPackage *package)
 {
+	gpointer value;
+	guint idx;
+	PkPackageSackPrivate *priv;
+
 	g_return_val_if_fail (PK_IS_PACKAGE_SACK (sack), FALSE);
 	g_return_val_if_fail (PK_IS_PACKAGE (package), FALSE);
 
-	/* remove from array */
-	g_hash_table_remove (sack->priv->table, pk_package_get_id (package));
-	return g_ptr_array_remove (sack->priv->array, package);
+	priv = sack->priv;
+	if (!g_hash_table_lookup_extended (priv->positions, package, NULL, &value))
+		return FALSE;
+	idx = GPOINTER_TO_UINT (value);
+	pk_package_sack_forget_package (sack, package);
+
+	/* leave a gap, which is closed the next time the array is used */
+	g_ptr_array_index (priv->array, idx) = NULL;
+	priv->tombstones++;
+	g_object_unref (package);
+	return TRUE;
 }
 
 /**
@@ -436,21 +670,14 @@ pk_package_sack_remove_package_by_id (PkPackageSack *sack,
 				      const gchar *package_id)
 {
 	PkPackage *package;
-	guint i;
-	GPtrArray *array;
 
 	g_return_val_if_fail (PK_IS_PACKAGE_SACK (sack), FALSE);
 	g_return_val_if_fail (package_id != NULL, FALSE);
 
-	array = sack->priv->array;
-	for (i = 0; i < array->len; i++) {
-		package = g_ptr_array_index (array, i);
-		if (g_strcmp0 (package_id, pk_package_get_id (package)) == 0) {
-			pk_package_sack_remove_package (sack, package);
-			return TRUE;
-		}
-	}
-	return FALSE;
+	package = g_hash_table_lookup (sack->priv->table, package_id);
+	if (package == NULL)
+		return FALSE;
+	return pk_package_sack_remove_package (sack, package);
 }
 
 /**
@@ -473,23 +700,36 @@ pk_package_sack_remove_by_filter (PkPackageSack *sack,
 {
 	gboolean ret = FALSE;
 	PkPackage *package;
-	gint i;
+	guint i;
+	guint j = 0;
 	PkPackageSackPrivate *priv = sack->priv;
 
 	g_return_val_if_fail (PK_IS_PACKAGE_SACK (sack), FALSE);
 	g_return_val_if_fail (filter_cb != NULL, FALSE);
 
-	/* add each that matches the info enum */
-	for (i = 0; i < (gint) priv->array->len; i++) {
+	/* keep each that matches, closing up the gaps in one pass */
+	for (i = 0; i < priv->array->len; i++) {
 		package = g_ptr_array_index (priv->array, i);
+		if (package == NULL)
+			continue;
 		if (!filter_cb (package, user_data)) {
 			ret = TRUE;
-			pk_package_sack_remove_package (sack, package);
-
-			/* ensure we pick up subsequent matches */
-			i--;
+			pk_package_sack_forget_package (sack, package);
+			g_object_unref (package);
+			continue;
+		}
+		if (i != j) {
+			g_ptr_array_index (priv->array, j) = package;
+			g_hash_table_insert (priv->positions, package, GUINT_TO_POINTER (j));
 		}
+		j++;
 	}
+
+	/* the removed packages were already unreffed */
+	g_ptr_array_set_free_func (priv->array, NULL);
+	g_ptr_array_set_size (priv->array, j);
+	g_ptr_array_set_free_func (priv->array, g_object_unref);
+	priv->tombstones = 0;
 	return ret;
 }
 
@@ -525,8 +765,8 @@ pk_package_sack_find_by_id (PkPackageSack *sack, const gchar *package_id)
  * @sack: a valid #PkPackageSack instance
  * @package_id: a package_id descriptor
  *
- * Finds a package in a sack by package name and architecture. As soon as one
- * package is found the search is stopped.
+ * Finds a package in a sack by package name and architecture. If there is
+ * more than one, the one that comes first in the sack is returned.
  *
  * Return value: (transfer full): the #PkPackage object, or %NULL if not found.
  *
@@ -535,27 +775,69 @@ pk_package_sack_find_by_id (PkPackageSack *sack, const gchar *package_id)
 PkPackage *
 pk_package_sack_find_by_id_name_arch (PkPackageSack *sack, const gchar *package_id)
 {
-	PkPackage *pkg_tmp;
+	GPtrArray *bucket;
+	PkPackage *package;
+	PkPackage *first = NULL;
+	PkPackageIdView view;
+	guint first_idx = G_MAXUINT;
+	guint idx;
 	guint i;
-	g_auto(GStrv) split = NULL;
+	g_autofree gchar *key = NULL;
 
 	g_return_val_if_fail (PK_IS_PACKAGE_SACK (sack), NULL);
 	g_return_val_if_fail (package_id != NULL, NULL);
 
 	/* does the package name feature in the array */
-	split = pk_package_id_split (package_id);
-	if (split == NULL)
+	if (!pk_package_id_view_init (&view, package_id))
 		return NULL;
-	for (i = 0; i < sack->priv->array->len; i++) {
-		pkg_tmp = g_ptr_array_index (sack->priv->array, i);
-		if (g_strcmp0 (pk_package_get_name (pkg_tmp),
-			       split[PK_PACKAGE_ID_NAME]) == 0 &&
-		    g_strcmp0 (pk_package_get_arch (pkg_tmp),
-			       split[PK_PACKAGE_ID_ARCH]) == 0) {
-			return g_object_ref (pkg_tmp);
+	key = g_strdup_printf ("%.*s;%.*s",
+			       (gint) view.length[PK_PACKAGE_ID_NAME],
+			       package_id + view.offset[PK_PACKAGE_ID_NAME],
+			       (gint) view.length[PK_PACKAGE_ID_ARCH],
+			       package_id + view.offset[PK_PACKAGE_ID_ARCH]);
+	bucket = g_hash_table_lookup (sack->priv->name_arches, key);
+	if (bucket == NULL)
+		return NULL;
+
+	/* the bucket is in the order the packages were added */
+	for (i = 0; i < bucket->len; i++) {
+		package = g_ptr_array_index (bucket, i);
+		idx = GPOINTER_TO_UINT (g_hash_table_lookup (sack->priv->positions, package));
+		if (idx < first_idx) {
+			first = package;
+			first_idx = idx;
 		}
 	}
-	return NULL;
+	return g_object_ref (first);
+}
+
+/**
+ * pk_package_sack_find_by_name:
+ * @sack: a valid #PkPackageSack instance
+ * @name: a package name, e.g. "powertop"
+ *
+ * Finds all the packages in a sack with a specific name, for instance
+ * every version and architecture of a package.
+ *
+ * Return value: (element-type PkPackage) (transfer container): A #GPtrArray, free with g_ptr_array_unref().
+ *
+ * Since: 1.1.3
+ **/
+GPtrArray *
+pk_package_sack_find_by_name (PkPackageSack *sack, const gchar *name)
+{
+	GPtrArray *bucket;
+	GPtrArray *array;
+	guint i;
+
+	g_return_val_if_fail (PK_IS_PACKAGE_SACK (sack), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+
+	array = g_ptr_array_new_with_free_func (g_object_unref);
+	bucket = g_hash_table_lookup (sack->priv->names, name);
+	for (i = 0; bucket != NULL && i < bucket->len; i++)
+		g_ptr_array_add (array, g_object_ref (g_ptr_array_index (bucket, i)));
+	return array;
 }
 
 /**
@@ -632,6 +914,7 @@ void
 pk_package_sack_sort (PkPackageSack *sack, PkPackageSackSortType type)
 {
 	g_return_if_fail (PK_IS_PACKAGE_SACK (sack));
+	pk_package_sack_compact (sack);
 	if (type == PK_PACKAGE_SACK_SORT_TYPE_NAME)
 		g_ptr_array_sort (sack->priv->array, (GCompareFunc) pk_package_sack_sort_compare_name_func);
 	else if (type == PK_PACKAGE_SACK_SORT_TYPE_PACKAGE_ID)
@@ -640,6 +923,7 @@ pk_package_sack_sort (PkPackageSack *sack, PkPackageSackSortType type)
 		g_ptr_array_sort (sack->priv->array, (GCompareFunc) pk_package_sack_sort_compare_summary_func);
 	else if (type == PK_PACKAGE_SACK_SORT_TYPE_INFO)
 		g_ptr_array_sort (sack->priv->array, (GCompareFunc) pk_package_sack_sort_compare_info_func);
+	pk_package_sack_update_positions (sack);
 }
 
 /**
@@ -663,6 +947,7 @@ pk_package_sack_get_total_bytes (PkPackageSack *sack)
 
 	g_return_val_if_fail (PK_IS_PACKAGE_SACK (sack), FALSE);
 
+	pk_package_sack_compact (sack);
 	array = sack->priv->array;
 	for (i = 0; i < array->len; i++) {
 		package = g_ptr_array_index (array, i);
@@ -688,6 +973,7 @@ pk_package_sack_get_package_ids (PkPackageSack *sack)
 	guint i;
 
 	/* create array of package_ids */
+	pk_package_sack_compact (sack);
 	array = sack->priv->array;
 	package_ids = g_new0 (gchar *, array->len+1);
 	for (i = 0; i < array->len; i++) {
@@ -1142,6 +1428,11 @@ pk_package_sack_init (PkPackageSack *sack)
 	priv = sack->priv;
 
 	priv->table = g_hash_table_new (g_str_hash, g_str_equal);
+	priv->positions = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->names = g_hash_table_new_full (g_str_hash, g_str_equal,
+					     g_free, (GDestroyNotify) g_ptr_array_unref);
+	priv->name_arches = g_hash_table_new_full (g_str_hash, g_str_equal,
+						   g_free, (GDestroyNotify) g_ptr_array_unref);
 	priv->array = g_ptr_array_new_with_free_func (g_object_unref);
 	priv->client = pk_client_new ();
 }
@@ -1155,6 +1446,10 @@ pk_package_sack_finalize (GObject *object)
 	PkPackageSack *sack = PK_PACKAGE_SACK (object);
 	PkPackageSackPrivate *priv = sack->priv;
 
+	pk_package_sack_compact (sack);
+	g_hash_table_unref (priv->positions);
+	g_hash_table_unref (priv->names);
+	g_hash_table_unref (priv->name_arches);
 	g_ptr_array_unref (priv->array);
 	g_hash_table_unref (priv->table);
 	g_object_unref (priv->client);
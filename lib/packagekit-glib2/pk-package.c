@@ -30,6 +30,7 @@
 
 #include "config.h"
 
+#include <string.h>
 #include <glib-object.h>
 
 #include <packagekit-glib2/pk-package.h>
@@ -47,13 +48,8 @@ static void     pk_package_finalize	(GObject     *object);
  *
  * Private #PkPackage data
  **/
-struct _PkPackagePrivate
+typedef struct
 {
-	PkInfoEnum		 info;
-	gchar			*package_id;
-	gchar			*package_id_data;
-	const gchar		*package_id_split[4];
-	gchar			*summary;
 	gchar			*license;
 	PkGroupEnum		 group;
 	gchar			*description;
@@ -70,6 +66,20 @@ struct _PkPackagePrivate
 	PkUpdateStateEnum	 update_state;
 	gchar			*update_issued;
 	gchar			*update_updated;
+} PkPackageExtra;
+
+/* most packages only ever come from Package signals, so everything but the
+ * id, info and summary is only allocated once it is set */
+static const PkPackageExtra pk_package_extra_empty = { NULL };
+
+struct _PkPackagePrivate
+{
+	PkInfoEnum		 info;
+	gchar			*package_id;
+	gchar			*package_id_data;	/* in the package_id block */
+	const gchar		*package_id_split[4];
+	gchar			*summary;
+	PkPackageExtra		*extra;
 };
 
 enum {
@@ -161,44 +171,33 @@ gboolean
 pk_package_set_id (PkPackage *package, const gchar *package_id, GError **error)
 {
 	PkPackagePrivate *priv = package->priv;
-	gboolean ret;
-	guint cnt = 0;
+	PkPackageIdView view;
+	gsize len;
 	guint i;
 
 	g_return_val_if_fail (PK_IS_PACKAGE (package), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	/* free old data */
-	g_free (priv->package_id);
-	g_free (priv->package_id_data);
-
-	/* copy the package-id into package_id_data, change the ';' into '\0'
-	 * and reference the pointers in the const gchar * array */
-	priv->package_id = g_strdup (package_id);
-	priv->package_id_data = g_strdup (package_id);
-	priv->package_id_split[0] = priv->package_id_data;
-	for (i = 0; priv->package_id_data[i] != '\0'; i++) {
-		if (package_id[i] == ';') {
-			if (++cnt > 3)
-				continue;
-			priv->package_id_split[cnt] = &priv->package_id_data[i+1];
-			priv->package_id_data[i] = '\0';
-		}
-	}
-	if (cnt != 3) {
-		ret = FALSE;
-		g_set_error (error, 1, 0, "invalid number of sections %i", cnt);
-		goto out;
+	/* check before touching the old data */
+	if (!pk_package_id_view_init (&view, package_id)) {
+		g_set_error (error, 1, 0, "invalid package-id %s", package_id);
+		return FALSE;
 	}
 
-	/* name has to be valid */
-	ret = (priv->package_id_split[0][0] != '\0');
-	if (!ret) {
-		g_set_error_literal (error, 1, 0, "name invalid");
-		goto out;
+	/* copy the package-id twice into one block, and in the second copy
+	 * change the ';' into '\0' and reference the sections in the
+	 * const gchar * array */
+	g_free (priv->package_id);
+	len = strlen (package_id) + 1;
+	priv->package_id = g_malloc (len * 2);
+	memcpy (priv->package_id, package_id, len);
+	priv->package_id_data = priv->package_id + len;
+	memcpy (priv->package_id_data, package_id, len);
+	for (i = 0; i < 4; i++) {
+		priv->package_id_split[i] = priv->package_id_data + view.offset[i];
+		priv->package_id_data[view.offset[i] + view.length[i]] = '\0';
 	}
-out:
-	return ret;
+	return TRUE;
 }
 
 /**
@@ -412,6 +411,17 @@ pk_package_print (PkPackage *package)
 		 package->priv->summary);
 }
 
+/**
+ * pk_package_get_extra:
+ **/
+static PkPackageExtra *
+pk_package_get_extra (PkPackage *package)
+{
+	if (package->priv->extra == NULL)
+		package->priv->extra = g_new0 (PkPackageExtra, 1);
+	return package->priv->extra;
+}
+
 /**
  * pk_package_get_property:
  **/
@@ -420,6 +430,7 @@ pk_package_get_property (GObject *object, guint prop_id, GValue *value, GParamSp
 {
 	PkPackage *package = PK_PACKAGE (object);
 	PkPackagePrivate *priv = package->priv;
+	const PkPackageExtra *extra = priv->extra != NULL ? priv->extra : &pk_package_extra_empty;
 
 	switch (prop_id) {
 	case PROP_PACKAGE_ID:
@@ -432,52 +443,52 @@ pk_package_get_property (GObject *object, guint prop_id, GValue *value, GParamSp
 		g_value_set_enum (value, priv->info);
 		break;
 	case PROP_LICENSE:
-		g_value_set_string (value, priv->license);
+		g_value_set_string (value, extra->license);
 		break;
 	case PROP_GROUP:
-		g_value_set_enum (value, priv->group);
+		g_value_set_enum (value, extra->group);
 		break;
 	case PROP_DESCRIPTION:
-		g_value_set_string (value, priv->description);
+		g_value_set_string (value, extra->description);
 		break;
 	case PROP_URL:
-		g_value_set_string (value, priv->url);
+		g_value_set_string (value, extra->url);
 		break;
 	case PROP_SIZE:
-		g_value_set_uint64 (value, priv->size);
+		g_value_set_uint64 (value, extra->size);
 		break;
 	case PROP_UPDATE_UPDATES:
-		g_value_set_string (value, priv->update_updates);
+		g_value_set_string (value, extra->update_updates);
 		break;
 	case PROP_UPDATE_OBSOLETES:
-		g_value_set_string (value, priv->update_obsoletes);
+		g_value_set_string (value, extra->update_obsoletes);
 		break;
 	case PROP_UPDATE_VENDOR_URLS:
-		g_value_set_boxed (value, priv->update_vendor_urls);
+		g_value_set_boxed (value, extra->update_vendor_urls);
 		break;
 	case PROP_UPDATE_BUGZILLA_URLS:
-		g_value_set_boxed (value, priv->update_bugzilla_urls);
+		g_value_set_boxed (value, extra->update_bugzilla_urls);
 		break;
 	case PROP_UPDATE_CVE_URLS:
-		g_value_set_boxed (value, priv->update_cve_urls);
+		g_value_set_boxed (value, extra->update_cve_urls);
 		break;
 	case PROP_UPDATE_RESTART:
-		g_value_set_enum (value, priv->update_restart);
+		g_value_set_enum (value, extra->update_restart);
 		break;
 	case PROP_UPDATE_UPDATE_TEXT:
-		g_value_set_string (value, priv->update_text);
+		g_value_set_string (value, extra->update_text);
 		break;
 	case PROP_UPDATE_CHANGELOG:
-		g_value_set_string (value, priv->update_changelog);
+		g_value_set_string (value, extra->update_changelog);
 		break;
 	case PROP_UPDATE_STATE:
-		g_value_set_enum (value, priv->update_state);
+		g_value_set_enum (value, extra->update_state);
 		break;
 	case PROP_UPDATE_ISSUED:
-		g_value_set_string (value, priv->update_issued);
+		g_value_set_string (value, extra->update_issued);
 		break;
 	case PROP_UPDATE_UPDATED:
-		g_value_set_string (value, priv->update_updated);
+		g_value_set_string (value, extra->update_updated);
 		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -492,7 +503,12 @@ static void
 pk_package_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
 {
 	PkPackage *package = PK_PACKAGE (object);
-	PkPackagePrivate *priv = package->priv;
+	PkPackageExtra *extra = NULL;
+
+	if (prop_id != PROP_INFO &&
+	    prop_id != PROP_PACKAGE_ID &&
+	    prop_id != PROP_SUMMARY)
+		extra = pk_package_get_extra (package);
 
 	switch (prop_id) {
 	case PROP_INFO:
@@ -502,64 +518,64 @@ pk_package_set_property (GObject *object, guint prop_id, const GValue *value, GP
 		pk_package_set_summary (package, g_value_get_string (value));
 		break;
 	case PROP_LICENSE:
-		g_free (priv->license);
-		priv->license = g_strdup (g_value_get_string (value));
+		g_free (extra->license);
+		extra->license = g_strdup (g_value_get_string (value));
 		break;
 	case PROP_GROUP:
-		priv->group = g_value_get_enum (value);
+		extra->group = g_value_get_enum (value);
 		break;
 	case PROP_DESCRIPTION:
-		g_free (priv->description);
-		priv->description = g_strdup (g_value_get_string (value));
+		g_free (extra->description);
+		extra->description = g_strdup (g_value_get_string (value));
 		break;
 	case PROP_URL:
-		g_free (priv->url);
-		priv->url = g_strdup (g_value_get_string (value));
+		g_free (extra->url);
+		extra->url = g_strdup (g_value_get_string (value));
 		break;
 	case PROP_SIZE:
-		priv->size = g_value_get_uint64 (value);
+		extra->size = g_value_get_uint64 (value);
 		break;
 	case PROP_UPDATE_UPDATES:
-		g_free (priv->update_updates);
-		priv->update_updates = g_strdup (g_value_get_string (value));
+		g_free (extra->update_updates);
+		extra->update_updates = g_strdup (g_value_get_string (value));
 		break;
 	case PROP_UPDATE_OBSOLETES:
-		g_free (priv->update_obsoletes);
-		priv->update_obsoletes = g_strdup (g_value_get_string (value));
+		g_free (extra->update_obsoletes);
+		extra->update_obsoletes = g_strdup (g_value_get_string (value));
 		break;
 	case PROP_UPDATE_VENDOR_URLS:
-		g_strfreev (priv->update_vendor_urls);
-		priv->update_vendor_urls = g_strdupv (g_value_get_boxed (value));
+		g_strfreev (extra->update_vendor_urls);
+		extra->update_vendor_urls = g_strdupv (g_value_get_boxed (value));
 		break;
 	case PROP_UPDATE_BUGZILLA_URLS:
-		g_strfreev (priv->update_bugzilla_urls);
-		priv->update_bugzilla_urls = g_strdupv (g_value_get_boxed (value));
+		g_strfreev (extra->update_bugzilla_urls);
+		extra->update_bugzilla_urls = g_strdupv (g_value_get_boxed (value));
 		break;
 	case PROP_UPDATE_CVE_URLS:
-		g_strfreev (priv->update_cve_urls);
-		priv->update_cve_urls = g_strdupv (g_value_get_boxed (value));
+		g_strfreev (extra->update_cve_urls);
+		extra->update_cve_urls = g_strdupv (g_value_get_boxed (value));
 		break;
 	case PROP_UPDATE_RESTART:
-		priv->update_restart = g_value_get_enum (value);
+		extra->update_restart = g_value_get_enum (value);
 		break;
 	case PROP_UPDATE_UPDATE_TEXT:
-		g_free (priv->update_text);
-		priv->update_text = g_strdup (g_value_get_string (value));
+		g_free (extra->update_text);
+		extra->update_text = g_strdup (g_value_get_string (value));
 		break;
 	case PROP_UPDATE_CHANGELOG:
-		g_free (priv->update_changelog);
-		priv->update_changelog = g_strdup (g_value_get_string (value));
+		g_free (extra->update_changelog);
+		extra->update_changelog = g_strdup (g_value_get_string (value));
 		break;
 	case PROP_UPDATE_STATE:
-		priv->update_state = g_value_get_enum (value);
+		extra->update_state = g_value_get_enum (value);
 		break;
 	case PROP_UPDATE_ISSUED:
-		g_free (priv->update_issued);
-		priv->update_issued = g_strdup (g_value_get_string (value));
+		g_free (extra->update_issued);
+		extra->update_issued = g_strdup (g_value_get_string (value));
 		break;
 	case PROP_UPDATE_UPDATED:
-		g_free (priv->update_updated);
-		priv->update_updated = g_strdup (g_value_get_string (value));
+		g_free (extra->update_updated);
+		extra->update_updated = g_strdup (g_value_get_string (value));
 		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -831,19 +847,21 @@ pk_package_finalize (GObject *object)
 
 	g_free (priv->package_id);
 	g_free (priv->summary);
-	g_free (priv->license);
-	g_free (priv->description);
-	g_free (priv->url);
-	g_free (priv->update_updates);
-	g_free (priv->update_obsoletes);
-	g_strfreev (priv->update_vendor_urls);
-	g_strfreev (priv->update_bugzilla_urls);
-	g_strfreev (priv->update_cve_urls);
-	g_free (priv->update_text);
-	g_free (priv->update_changelog);
-	g_free (priv->update_issued);
-	g_free (priv->update_updated);
-	g_free (priv->package_id_data);
+	if (priv->extra != NULL) {
+		g_free (priv->extra->license);
+		g_free (priv->extra->description);
+		g_free (priv->extra->url);
+		g_free (priv->extra->update_updates);
+		g_free (priv->extra->update_obsoletes);
+		g_strfreev (priv->extra->update_vendor_urls);
+		g_strfreev (priv->extra->update_bugzilla_urls);
+		g_strfreev (priv->extra->update_cve_urls);
+		g_free (priv->extra->update_text);
+		g_free (priv->extra->update_changelog);
+		g_free (priv->extra->update_issued);
+		g_free (priv->extra->update_updated);
+		g_free (priv->extra);
+	}
 
 	G_OBJECT_CLASS (pk_package_parent_class)->finalize (object);
 }
@@ -34,6 +34,7 @@
 #include <glib-object.h>
 
 #include <packagekit-glib2/pk-results.h>
+#include <packagekit-glib2/pk-results-private.h>
 #include <packagekit-glib2/pk-enum.h>
 #include <packagekit-glib2/pk-enum-types.h>
 
@@ -41,6 +42,15 @@ static void     pk_results_finalize	(GObject     *object);
 
 #define PK_RESULTS_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), PK_TYPE_RESULTS, PkResultsPrivate))
 
+/* a package from a Package signal, the strings are owned by package_strings */
+typedef struct {
+	PkInfoEnum		 info;
+	PkRoleEnum		 role;
+	const gchar		*package_id;
+	const gchar		*summary;
+	const gchar		*transaction_id;
+} PkResultsCompactPackage;
+
 /**
  * PkResultsPrivate:
  *
@@ -54,6 +64,7 @@ struct _PkResultsPrivate
 	PkProgress		*progress;
 	PkExitEnum		 exit_enum;
 	PkError			*error_code;
+	gchar			*plan_token;
 	GPtrArray		*details_array;
 	GPtrArray		*update_detail_array;
 	GPtrArray		*category_array;
@@ -66,6 +77,8 @@ struct _PkResultsPrivate
 	GPtrArray		*media_change_required_array;
 	GPtrArray		*repo_detail_array;
 	PkPackageSack		*package_sack;
+	GArray			*package_compact;
+	GStringChunk		*package_strings;
 };
 
 enum {
@@ -159,6 +172,81 @@ pk_results_set_exit_code (PkResults *results, PkExitEnum exit_enum)
 	return TRUE;
 }
 
+/**
+ * pk_results_flush_packages:
+ *
+ * Creates the #PkPackage objects for the packages that were only stored
+ * in compact form, keeping the order they were added in.
+ **/
+static void
+pk_results_flush_packages (PkResults *results)
+{
+	PkResultsPrivate *priv = results->priv;
+	PkResultsCompactPackage *compact;
+	guint i;
+
+	if (priv->package_compact->len == 0)
+		return;
+
+	for (i = 0; i < priv->package_compact->len; i++) {
+		g_autoptr(PkPackage) package = NULL;
+
+		compact = &g_array_index (priv->package_compact, PkResultsCompactPackage, i);
+		package = pk_package_new ();
+		pk_package_set_id (package, compact->package_id, NULL);
+		pk_package_set_info (package, compact->info);
+		pk_package_set_summary (package, compact->summary);
+		if (compact->role != PK_ROLE_ENUM_UNKNOWN || compact->transaction_id != NULL) {
+			g_object_set (package,
+				      "role", compact->role,
+				      "transaction-id", compact->transaction_id,
+				      NULL);
+		}
+		pk_package_sack_add_package (priv->package_sack, package);
+	}
+	g_array_set_size (priv->package_compact, 0);
+	g_string_chunk_clear (priv->package_strings);
+}
+
+/**
+ * pk_results_add_package_compact:
+ * @results: a valid #PkResults instance
+ * @info: the #PkInfoEnum of the package
+ * @package_id: a valid package ID
+ * @summary: the package summary
+ * @role: the #PkRoleEnum the package came from
+ * @transaction_id: the transaction the package came from, or %NULL
+ *
+ * Adds a package to the results set without creating a #PkPackage for it,
+ * which is only done when the packages are requested.
+ **/
+void
+pk_results_add_package_compact (PkResults *results,
+				PkInfoEnum info,
+				const gchar *package_id,
+				const gchar *summary,
+				PkRoleEnum role,
+				const gchar *transaction_id)
+{
+	PkResultsPrivate *priv = results->priv;
+	PkResultsCompactPackage compact;
+
+	g_return_if_fail (PK_IS_RESULTS (results));
+	g_return_if_fail (package_id != NULL);
+	g_return_if_fail (info != PK_INFO_ENUM_FINISHED);
+
+	compact.info = info;
+	compact.role = role;
+	compact.package_id = g_string_chunk_insert (priv->package_strings, package_id);
+	compact.summary = g_string_chunk_insert_const (priv->package_strings,
+						       summary != NULL ? summary : "");
+	compact.transaction_id = NULL;
+	if (transaction_id != NULL)
+		compact.transaction_id = g_string_chunk_insert_const (priv->package_strings,
+								      transaction_id);
+	g_array_append_val (priv->package_compact, compact);
+}
+
 /**
  * pk_results_add_package:
  * @results: a valid #PkResults instance
@@ -181,6 +269,7 @@ pk_results_add_package (PkResults *results, PkPackage *item)
 		g_warning ("Finished packages cannot be added to PkResults");
 		return FALSE;
 	}
+	pk_results_flush_packages (results);
 	pk_package_sack_add_package (results->priv->package_sack, item);
 	return TRUE;
 }
@@ -463,6 +552,46 @@ pk_results_set_error_code (PkResults *results, PkError *item)
 	return TRUE;
 }
 
+/**
+ * pk_results_set_plan_token:
+ * @results: a valid #PkResults instance
+ * @plan_token: the token from the daemon, or %NULL
+ *
+ * Sets the token the daemon returned for the depsolve of a simulate.
+ *
+ * Return value: %TRUE if the value was set
+ *
+ * Since: 1.1.3
+ **/
+gboolean
+pk_results_set_plan_token (PkResults *results, const gchar *plan_token)
+{
+	g_return_val_if_fail (PK_IS_RESULTS (results), FALSE);
+
+	g_free (results->priv->plan_token);
+	results->priv->plan_token = g_strdup (plan_token);
+	return TRUE;
+}
+
+/**
+ * pk_results_get_plan_token:
+ * @results: a valid #PkResults instance
+ *
+ * Gets the token for the depsolve of a simulate. Passing it to the real
+ * transaction with the "plan-token" hint lets the backend reuse the
+ * depsolve if the package database has not changed in the meantime.
+ *
+ * Return value: the opaque token, or %NULL if the backend did not keep one
+ *
+ * Since: 1.1.3
+ **/
+const gchar *
+pk_results_get_plan_token (PkResults *results)
+{
+	g_return_val_if_fail (PK_IS_RESULTS (results), NULL);
+	return results->priv->plan_token;
+}
+
 /**
  * pk_results_get_exit_code:
  * @results: a valid #PkResults instance
@@ -557,6 +686,7 @@ GPtrArray *
 pk_results_get_package_array (PkResults *results)
 {
 	g_return_val_if_fail (PK_IS_RESULTS (results), NULL);
+	pk_results_flush_packages (results);
 	return pk_package_sack_get_array (results->priv->package_sack);
 }
 
@@ -574,6 +704,7 @@ PkPackageSack *
 pk_results_get_package_sack (PkResults *results)
 {
 	g_return_val_if_fail (PK_IS_RESULTS (results), NULL);
+	pk_results_flush_packages (results);
 	return g_object_ref (results->priv->package_sack);
 }
 
@@ -873,6 +1004,8 @@ pk_results_init (PkResults *results)
 	results->priv->progress = NULL;
 	results->priv->error_code = NULL;
 	results->priv->package_sack = pk_package_sack_new ();
+	results->priv->package_compact = g_array_new (FALSE, FALSE, sizeof (PkResultsCompactPackage));
+	results->priv->package_strings = g_string_chunk_new (16 * 1024);
 	results->priv->details_array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	results->priv->update_detail_array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	results->priv->category_array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
@@ -895,6 +1028,7 @@ pk_results_finalize (GObject *object)
 	PkResults *results = PK_RESULTS (object);
 	PkResultsPrivate *priv = results->priv;
 
+	g_free (priv->plan_token);
 	g_ptr_array_unref (priv->details_array);
 	g_ptr_array_unref (priv->update_detail_array);
 	g_ptr_array_unref (priv->category_array);
@@ -907,6 +1041,8 @@ pk_results_finalize (GObject *object)
 	g_ptr_array_unref (priv->media_change_required_array);
 	g_ptr_array_unref (priv->repo_detail_array);
 	g_object_unref (priv->package_sack);
+	g_array_unref (priv->package_compact);
+	g_string_chunk_free (priv->package_strings);
 	if (results->priv->progress != NULL)
 		g_object_unref (results->priv->progress);
 	if (results->priv->error_code != NULL)
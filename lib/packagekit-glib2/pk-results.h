@@ -87,6 +87,8 @@ gboolean	 pk_results_set_exit_code		(PkResults		*results,
 							 PkExitEnum		 exit_enum);
 gboolean	 pk_results_set_error_code 		(PkResults		*results,
 							 PkError		*item);
+gboolean	 pk_results_set_plan_token		(PkResults		*results,
+							 const gchar		*plan_token);
 
 /* add */
 gboolean	 pk_results_add_package			(PkResults		*results,
@@ -121,6 +123,7 @@ PkError		*pk_results_get_error_code		(PkResults		*results);
 PkRoleEnum	 pk_results_get_role			(PkResults		*results);
 PkBitfield	 pk_results_get_transaction_flags	(PkResults		*results);
 PkRestartEnum	 pk_results_get_require_restart_worst	(PkResults		*results);
+const gchar	*pk_results_get_plan_token		(PkResults		*results);
 
 /* get array objects */
 GPtrArray	*pk_results_get_package_array		(PkResults		*results);
@@ -30,6 +30,7 @@
 #include <gio/gio.h>
 
 #include <packagekit-glib2/pk-task.h>
+#include <packagekit-glib2/pk-client-private.h>
 #include <packagekit-glib2/pk-common.h>
 #include <packagekit-glib2/pk-enum.h>
 #include <packagekit-glib2/pk-results.h>
@@ -98,6 +99,7 @@ typedef struct {
 	gchar				**packages;
 	gchar				*repo_id;
 	gchar				*transaction_id;
+	gchar				*plan_token;
 	gchar				**values;
 	PkBitfield			 filters;
 	PkUpgradeKindEnum		 upgrade_kind;
@@ -175,6 +177,7 @@ pk_task_generic_state_finish (PkTaskState *state, const GError *error)
 	g_free (state->distro_id);
 	g_free (state->repo_id);
 	g_free (state->transaction_id);
+	g_free (state->plan_token);
 	g_strfreev (state->files);
 	g_strfreev (state->package_ids);
 	g_strfreev (state->packages);
@@ -210,6 +213,14 @@ pk_task_do_async_action (PkTaskState *state)
 				PK_TRANSACTION_FLAG_ENUM_ALLOW_DOWNGRADE);
 	}
 
+	/* let the backend skip the depsolve it did in the simulate; the
+	 * daemon only uses a plan once, so retries solve again */
+	if (state->plan_token != NULL) {
+		pk_client_set_plan_token (PK_CLIENT (state->task), state->plan_token);
+		g_free (state->plan_token);
+		state->plan_token = NULL;
+	}
+
 	/* do the correct action */
 	if (state->role == PK_ROLE_ENUM_INSTALL_PACKAGES) {
 		pk_client_install_packages_async (PK_CLIENT(state->task), transaction_flags, state->package_ids,
@@ -373,6 +384,10 @@ pk_task_simulate_ready_cb (GObject *source_object, GAsyncResult *res, PkTaskStat
 	/* we own a copy now */
 	state->results = g_object_ref (G_OBJECT(results));
 
+	/* the real transaction can reuse the depsolve */
+	g_free (state->plan_token);
+	state->plan_token = g_strdup (pk_results_get_plan_token (results));
+
 	/* get exit code */
 	state->exit_enum = pk_results_get_exit_code (state->results);
 	if (state->exit_enum == PK_EXIT_ENUM_NEED_UNTRUSTED) {
@@ -1011,12 +1011,82 @@ pk_test_package_sack_filter_cb (PkPackage *package, gpointer user_data)
 	return TRUE;
 }
 
+/**
+ * pk_test_package_sack_remove_func:
+ *
+ * Removing packages keeps the order of the rest, and a duplicate ID is
+ * still found once the package that added it first has gone.
+ **/
+static void
+pk_test_package_sack_remove_func (void)
+{
+	gboolean ret;
+	g_autoptr(GPtrArray) array = NULL;
+	g_autoptr(PkPackage) first = NULL;
+	g_autoptr(PkPackage) found = NULL;
+	g_autoptr(PkPackageSack) sack = NULL;
+
+	sack = pk_package_sack_new ();
+	first = pk_package_new ();
+	ret = pk_package_set_id (first, "powertop;1.8-1.fc8;i386;fedora", NULL);
+	g_assert (ret);
+	pk_package_sack_add_package (sack, first);
+	pk_package_sack_add_package_by_id (sack, "gtkhtml2;2.19.1-4.fc8;i386;fedora", NULL);
+	pk_package_sack_add_package_by_id (sack, "powertop;1.8-1.fc8;i386;fedora", NULL);
+	pk_package_sack_add_package_by_id (sack, "kernel;2.6.23-0.115.rc3.git1.fc8;i386;installed", NULL);
+	pk_package_sack_add_package_by_id (sack, "vips-doc;7.12.4-2.fc8;noarch;linva", NULL);
+
+	/* drop the package whose ID string the table was first keyed on */
+	ret = pk_package_sack_remove_package (sack, first);
+	g_assert (ret);
+	g_clear_object (&first);
+	found = pk_package_sack_find_by_id (sack, "powertop;1.8-1.fc8;i386;fedora");
+	g_assert (found != NULL);
+
+	/* the packages after the gap keep their order */
+	array = pk_package_sack_get_array (sack);
+	g_assert_cmpint (array->len, ==, 4);
+	g_assert_cmpstr (pk_package_get_name (g_ptr_array_index (array, 0)), ==, "gtkhtml2");
+	g_assert_cmpstr (pk_package_get_name (g_ptr_array_index (array, 1)), ==, "powertop");
+	g_assert_cmpstr (pk_package_get_name (g_ptr_array_index (array, 2)), ==, "kernel");
+	g_assert_cmpstr (pk_package_get_name (g_ptr_array_index (array, 3)), ==, "vips-doc");
+	g_ptr_array_unref (array);
+
+	/* all have an unknown info, so mark the ones to keep */
+	pk_package_set_info (found, PK_INFO_ENUM_AVAILABLE);
+	g_clear_object (&found);
+	found = pk_package_sack_find_by_id (sack, "vips-doc;7.12.4-2.fc8;noarch;linva");
+	pk_package_set_info (found, PK_INFO_ENUM_AVAILABLE);
+	ret = pk_package_sack_remove_by_filter (sack, pk_test_package_sack_filter_cb, NULL);
+	g_assert (ret);
+	array = pk_package_sack_get_array (sack);
+	g_assert_cmpint (array->len, ==, 2);
+	g_assert_cmpstr (pk_package_get_name (g_ptr_array_index (array, 0)), ==, "powertop");
+	g_assert_cmpstr (pk_package_get_name (g_ptr_array_index (array, 1)), ==, "vips-doc");
+
+	/* the positions were updated too */
+	ret = pk_package_sack_remove_package_by_id (sack, "vips-doc;7.12.4-2.fc8;noarch;linva");
+	g_assert (ret);
+	g_assert_cmpint (pk_package_sack_get_size (sack), ==, 1);
+
+	/* the name and arch lookup follows the sack order */
+	pk_package_sack_add_package_by_id (sack, "powertop;1.9-1.fc8;i386;updates", NULL);
+	pk_package_sack_add_package_by_id (sack, "powertop;1.7-1.fc8;i386;fedora", NULL);
+	pk_package_sack_sort (sack, PK_PACKAGE_SACK_SORT_TYPE_PACKAGE_ID);
+	g_clear_object (&found);
+	found = pk_package_sack_find_by_id_name_arch (sack, "powertop;1.9-1.fc8;i386;updates");
+	g_assert (found != NULL);
+	g_assert_cmpstr (pk_package_get_id (found), ==, "powertop;1.7-1.fc8;i386;fedora");
+}
+
 static void
 pk_test_package_sack_func (void)
 {
 	gboolean ret;
 	PkPackageSack *sack;
+	PkPackageSack *sack2;
 	PkPackage *package;
+	GPtrArray *array;
 	gchar *text;
 	gchar **strv;
 	guint size;
@@ -1130,6 +1200,47 @@ pk_test_package_sack_func (void)
 	size = pk_package_sack_get_size (sack);
 	g_assert_cmpint (size, ==, 0);
 
+	/* find by name and by name and arch */
+	pk_package_sack_add_package_by_id (sack, "powertop;1.8-1.fc8;i386;fedora", NULL);
+	pk_package_sack_add_package_by_id (sack, "powertop;1.8-1.fc8;x86_64;fedora", NULL);
+	pk_package_sack_add_package_by_id (sack, "kernel;2.6.23-0.115.rc3.git1.fc8;i386;installed", NULL);
+	array = pk_package_sack_find_by_name (sack, "powertop");
+	g_assert_cmpint (array->len, ==, 2);
+	g_ptr_array_unref (array);
+	package = pk_package_sack_find_by_id_name_arch (sack, "powertop;1.9-1.fc8;x86_64;updates");
+	g_assert (package != NULL);
+	g_assert_cmpstr (pk_package_get_id (package), ==, "powertop;1.8-1.fc8;x86_64;fedora");
+	g_object_unref (package);
+
+	/* the indexes follow removals */
+	ret = pk_package_sack_remove_package_by_id (sack, "powertop;1.8-1.fc8;i386;fedora");
+	g_assert (ret);
+	package = pk_package_sack_find_by_id_name_arch (sack, "powertop;1.8-1.fc8;i386;fedora");
+	g_assert (package == NULL);
+	array = pk_package_sack_find_by_name (sack, "powertop");
+	g_assert_cmpint (array->len, ==, 1);
+	g_ptr_array_unref (array);
+	package = pk_package_sack_find_by_id (sack, "kernel;2.6.23-0.115.rc3.git1.fc8;i386;installed");
+	g_assert (package != NULL);
+	ret = pk_package_sack_remove_package (sack, package);
+	g_assert (ret);
+	ret = pk_package_sack_remove_package (sack, package);
+	g_assert (!ret);
+	g_object_unref (package);
+	g_assert_cmpint (pk_package_sack_get_size (sack), ==, 1);
+
+	/* merge, skipping packages already present */
+	sack2 = pk_package_sack_new ();
+	pk_package_sack_add_package_by_id (sack2, "powertop;1.8-1.fc8;x86_64;fedora", NULL);
+	pk_package_sack_add_package_by_id (sack2, "gtk2;2.11.6-6.fc8;i386;fedora", NULL);
+	size = pk_package_sack_merge (sack, sack2);
+	g_assert_cmpint (size, ==, 1);
+	g_assert_cmpint (pk_package_sack_get_size (sack), ==, 2);
+	package = pk_package_sack_find_by_id (sack, "gtk2;2.11.6-6.fc8;i386;fedora");
+	g_assert (package != NULL);
+	g_object_unref (package);
+	g_object_unref (sack2);
+
 	g_object_unref (sack);
 }
 
@@ -1417,6 +1528,182 @@ pk_test_transaction_list_func (void)
 	g_object_unref (client);
 }
 
+static void
+pk_test_client_stream_cb (PkSource *item, gpointer user_data)
+{
+	guint *cnt = (guint *) user_data;
+	g_assert (PK_IS_PACKAGE (item));
+	(*cnt)++;
+}
+
+static void
+pk_test_client_stream_progress_cb (PkProgress *progress, PkProgressType type, gpointer user_data)
+{
+	guint *cnt = (guint *) user_data;
+	if (type == PK_PROGRESS_TYPE_PACKAGE)
+		(*cnt)++;
+}
+
+static void
+pk_test_client_stream_func (void)
+{
+	guint cnt = 0;
+	guint progress_cnt = 0;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) packages = NULL;
+	g_autoptr(PkClient) client = NULL;
+	g_autoptr(PkResults) results = NULL;
+
+	/* items go to the callback rather than into the results */
+	client = pk_client_new ();
+	pk_client_set_item_callback (client, pk_test_client_stream_cb, &cnt);
+	results = pk_client_get_packages (client,
+					  pk_bitfield_value (PK_FILTER_ENUM_NONE),
+					  NULL,
+					  pk_test_client_stream_progress_cb, &progress_cnt,
+					  &error);
+	g_assert_no_error (error);
+	g_assert (results != NULL);
+	g_assert_cmpint (pk_results_get_exit_code (results), ==, PK_EXIT_ENUM_SUCCESS);
+	g_assert_cmpint (cnt, >, 0);
+	packages = pk_results_get_package_array (results);
+	g_assert_cmpint (packages->len, ==, 0);
+
+	/* the result packages are not reported as progress too */
+	g_assert_cmpint (progress_cnt, ==, 0);
+}
+
+typedef struct {
+	guint		 percentage_cb;
+	gint		 percentage;
+	guint		 status_cb;
+	PkStatusEnum	 status;
+} PkTestProgressHelper;
+
+static void
+pk_test_client_progress_changes_cb (PkProgress *progress, PkProgressType type, gpointer user_data)
+{
+	PkTestProgressHelper *helper = (PkTestProgressHelper *) user_data;
+	if (type == PK_PROGRESS_TYPE_PERCENTAGE) {
+		helper->percentage_cb++;
+		helper->percentage = pk_progress_get_percentage (progress);
+	}
+	if (type == PK_PROGRESS_TYPE_STATUS) {
+		helper->status_cb++;
+		if (pk_progress_get_status (progress) != PK_STATUS_ENUM_FINISHED)
+			helper->status = pk_progress_get_status (progress);
+	}
+}
+
+/**
+ * pk_test_client_progress_func:
+ *
+ * The transaction properties change while the dummy install runs, and every
+ * change has to reach the progress callback.
+ **/
+static void
+pk_test_client_progress_func (void)
+{
+	PkTestProgressHelper helper = { 0 };
+	gchar *package_ids[] = { (gchar *) "gtkhtml2;2.19.1-4.fc8;i386;fedora", NULL };
+	g_autoptr(GError) error = NULL;
+	g_autoptr(PkClient) client = NULL;
+	g_autoptr(PkResults) results = NULL;
+
+	client = pk_client_new ();
+	results = pk_client_install_packages (client,
+					      pk_bitfield_value (PK_TRANSACTION_FLAG_ENUM_NONE),
+					      package_ids, NULL,
+					      pk_test_client_progress_changes_cb, &helper,
+					      &error);
+	g_assert_no_error (error);
+	g_assert (results != NULL);
+	g_assert_cmpint (pk_results_get_exit_code (results), ==, PK_EXIT_ENUM_SUCCESS);
+
+	/* the percentage goes up one step at a time */
+	g_assert_cmpint (helper.percentage_cb, >=, 10);
+	g_assert_cmpint (helper.percentage, ==, 100);
+
+	/* the status was set by the backend, not only forced at the end */
+	g_assert_cmpint (helper.status_cb, >, 1);
+	g_assert_cmpint (helper.status, ==, PK_STATUS_ENUM_INSTALL);
+}
+
+static void
+pk_test_client_progress_interval_cb (PkProgress *progress, PkProgressType type, gpointer user_data)
+{
+	PkTestProgressHelper *helper = (PkTestProgressHelper *) user_data;
+	if (type != PK_PROGRESS_TYPE_PERCENTAGE)
+		return;
+	helper->percentage_cb++;
+	helper->percentage = pk_progress_get_percentage (progress);
+}
+
+/**
+ * pk_test_client_progress_interval_func:
+ *
+ * The dummy install changes the percentage every 100ms, which should be
+ * merged down to about one callback a second.
+ **/
+static void
+pk_test_client_progress_interval_func (void)
+{
+	PkTestProgressHelper helper = { 0 };
+	gchar *package_ids[] = { (gchar *) "gtkhtml2;2.19.1-4.fc8;i386;fedora", NULL };
+	g_autoptr(GError) error = NULL;
+	g_autoptr(PkClient) client = NULL;
+	g_autoptr(PkResults) results = NULL;
+
+	client = pk_client_new ();
+	pk_client_set_progress_interval (client, 1000);
+	g_assert_cmpint (pk_client_get_progress_interval (client), ==, 1000);
+	results = pk_client_install_packages (client,
+					      pk_bitfield_value (PK_TRANSACTION_FLAG_ENUM_NONE),
+					      package_ids, NULL,
+					      pk_test_client_progress_interval_cb, &helper,
+					      &error);
+	g_assert_no_error (error);
+	g_assert (results != NULL);
+	g_assert_cmpint (pk_results_get_exit_code (results), ==, PK_EXIT_ENUM_SUCCESS);
+
+	/* fewer callbacks, but the last one is still accurate */
+	g_assert_cmpint (helper.percentage_cb, >, 0);
+	g_assert_cmpint (helper.percentage_cb, <, 30);
+	g_assert_cmpint (helper.percentage, ==, 100);
+}
+
+/**
+ * pk_test_client_latency_func:
+ *
+ * Measures the time of a cheap query, which is dominated by setting up
+ * the transaction on the daemon.
+ **/
+static void
+pk_test_client_latency_func (void)
+{
+	const guint loops = 100;
+	guint i;
+	gchar *packages[] = { (gchar *) "powertop", NULL };
+	g_autoptr(PkClient) client = NULL;
+
+	client = pk_client_new ();
+
+	g_test_timer_start ();
+	for (i = 0; i < loops; i++) {
+		g_autoptr(GError) error = NULL;
+		g_autoptr(PkResults) results = NULL;
+
+		results = pk_client_resolve (client,
+					     pk_bitfield_value (PK_FILTER_ENUM_NONE),
+					     packages, NULL, NULL, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (results != NULL);
+	}
+	g_test_minimized_result (g_test_timer_elapsed () * 1000 / loops,
+				 "Resolve took %.2fms per call",
+				 g_test_timer_last () * 1000 / loops);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -1438,11 +1725,17 @@ main (int argc, char **argv)
 	g_test_add_func ("/packagekit-glib2/transaction-list", pk_test_transaction_list_func);
 	g_test_add_func ("/packagekit-glib2/client-helper", pk_test_client_helper_func);
 	g_test_add_func ("/packagekit-glib2/client", pk_test_client_func);
+	g_test_add_func ("/packagekit-glib2/client-stream", pk_test_client_stream_func);
+	g_test_add_func ("/packagekit-glib2/client-progress", pk_test_client_progress_func);
+	g_test_add_func ("/packagekit-glib2/client-progress-interval", pk_test_client_progress_interval_func);
 	g_test_add_func ("/packagekit-glib2/package-sack", pk_test_package_sack_func);
+	g_test_add_func ("/packagekit-glib2/package-sack-remove", pk_test_package_sack_remove_func);
 	g_test_add_func ("/packagekit-glib2/task", pk_test_task_func);
 	g_test_add_func ("/packagekit-glib2/task-wrapper", pk_test_task_wrapper_func);
 	g_test_add_func ("/packagekit-glib2/task-text", pk_test_task_text_func);
 	g_test_add_func ("/packagekit-glib2/console", pk_test_console_func);
+	if (g_test_perf ())
+		g_test_add_func ("/packagekit-glib2/client-latency", pk_test_client_latency_func);
 
 	return g_test_run ();
 }
@@ -21,9 +21,11 @@
 
 #include "config.h"
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
+#include "pk-client-private.h"
 #include "pk-common.h"
+#include "pk-control.h"
 #include "pk-debug.h"
 #include "pk-enum.h"
 #include "pk-offline.h"
@@ -31,8 +33,10 @@
 #include "pk-package.h"
 #include "pk-package-id.h"
 #include "pk-package-ids.h"
+#include "pk-progress.h"
 #include "pk-progress-bar.h"
 #include "pk-results.h"
+#include "pk-results-private.h"
 
 static void
 pk_test_bitfield_func (void)
@@ -323,6 +327,46 @@ pk_test_enum_func (void)
 			break;
 		}
 	}
+
+	/* invalid and missing strings give the fall through value */
+	g_assert_cmpint (pk_role_enum_from_string ("xxx"), ==, PK_ROLE_ENUM_UNKNOWN);
+	g_assert_cmpint (pk_role_enum_from_string (NULL), ==, PK_ROLE_ENUM_UNKNOWN);
+	g_assert_cmpint (pk_transaction_flag_enum_from_string ("xxx"), ==, PK_TRANSACTION_FLAG_ENUM_NONE);
+	g_assert_cmpstr (pk_info_enum_to_string (PK_INFO_ENUM_LAST + 100), ==, "unknown");
+}
+
+/* values without a string convert to the fall through string, so skip them */
+#define PK_TEST_ENUM_ROUND_TRIP(to_string, from_string, last)			\
+	for (i = 0; i < last; i++) {						\
+		string = to_string (i);						\
+		g_assert (string != NULL);					\
+		if (i != 0 && string == to_string (0))				\
+			continue;						\
+		g_assert_cmpint (from_string (string), ==, i);			\
+	}
+
+static void
+pk_test_enum_round_trip_func (void)
+{
+	const gchar *string;
+	guint i;
+
+	PK_TEST_ENUM_ROUND_TRIP (pk_exit_enum_to_string, pk_exit_enum_from_string, PK_EXIT_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_status_enum_to_string, pk_status_enum_from_string, PK_STATUS_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_role_enum_to_string, pk_role_enum_from_string, PK_ROLE_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_error_enum_to_string, pk_error_enum_from_string, PK_ERROR_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_restart_enum_to_string, pk_restart_enum_from_string, PK_RESTART_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_filter_enum_to_string, pk_filter_enum_from_string, PK_FILTER_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_group_enum_to_string, pk_group_enum_from_string, PK_GROUP_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_update_state_enum_to_string, pk_update_state_enum_from_string, PK_UPDATE_STATE_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_info_enum_to_string, pk_info_enum_from_string, PK_INFO_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_sig_type_enum_to_string, pk_sig_type_enum_from_string, PK_SIGTYPE_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_distro_upgrade_enum_to_string, pk_distro_upgrade_enum_from_string, PK_DISTRO_UPGRADE_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_network_enum_to_string, pk_network_enum_from_string, PK_NETWORK_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_media_type_enum_to_string, pk_media_type_enum_from_string, PK_MEDIA_TYPE_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_authorize_type_enum_to_string, pk_authorize_type_enum_from_string, PK_AUTHORIZE_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_upgrade_kind_enum_to_string, pk_upgrade_kind_enum_from_string, PK_UPGRADE_KIND_ENUM_LAST);
+	PK_TEST_ENUM_ROUND_TRIP (pk_transaction_flag_enum_to_string, pk_transaction_flag_enum_from_string, PK_TRANSACTION_FLAG_ENUM_LAST);
 }
 
 static void
@@ -331,6 +375,7 @@ pk_test_package_id_func (void)
 	gboolean ret;
 	gchar *text;
 	gchar **sections;
+	PkPackageIdView view;
 
 	/* check not valid - NULL */
 	ret = pk_package_id_check (NULL);
@@ -402,6 +447,78 @@ pk_test_package_id_func (void)
 	/* test fail missing first */
 	sections = pk_package_id_split (";0.1.2;i386;data");
 	g_assert (sections == NULL);
+
+	/* view into a valid id */
+	ret = pk_package_id_view_init (&view, "kde-i18n-csb;4:3.5.8~pre20071001-0ubuntu1;all;");
+	g_assert (ret);
+	g_assert (pk_package_id_view_section_equal (&view, PK_PACKAGE_ID_NAME, "kde-i18n-csb"));
+	g_assert (!pk_package_id_view_section_equal (&view, PK_PACKAGE_ID_NAME, "kde-i18n"));
+	g_assert (!pk_package_id_view_section_equal (&view, PK_PACKAGE_ID_NAME, "kde-i18n-csb-all"));
+	g_assert (pk_package_id_view_section_equal (&view, PK_PACKAGE_ID_ARCH, "all"));
+	g_assert (pk_package_id_view_section_equal (&view, PK_PACKAGE_ID_DATA, ""));
+	text = pk_package_id_view_dup_section (&view, PK_PACKAGE_ID_VERSION);
+	g_assert_cmpstr (text, ==, "4:3.5.8~pre20071001-0ubuntu1");
+	g_free (text);
+
+	/* view rejects what check rejects */
+	g_assert (!pk_package_id_view_init (&view, NULL));
+	g_assert (!pk_package_id_view_init (&view, "foo;moo"));
+	g_assert (!pk_package_id_view_init (&view, "foo;moo;dave;clive;dan"));
+	g_assert (!pk_package_id_view_init (&view, ";0.1.2;i386;data"));
+	g_assert (!pk_package_id_view_init (&view, "foo;\xff;i386;data"));
+	g_assert (pk_package_id_view_init (&view, "caf\xc3\xa9;0.1.2;i386;data"));
+
+	/* fuzzy arch */
+	g_assert (pk_package_id_equal_fuzzy_arch ("moo;0.0.1;i386;fedora", "moo;0.0.1;i686;updates"));
+	g_assert (pk_package_id_equal_fuzzy_arch ("moo;0.0.1;noarch;fedora", "moo;0.0.1;noarch;updates"));
+	g_assert (!pk_package_id_equal_fuzzy_arch ("moo;0.0.1;i386;fedora", "moo;0.0.1;x86_64;fedora"));
+	g_assert (!pk_package_id_equal_fuzzy_arch ("moo;0.0.1;i386;fedora", "moo;0.0.2;i386;fedora"));
+	g_assert (!pk_package_id_equal_fuzzy_arch ("moo;0.0.1;i386;fedora", "moo0;.0.1;i386;fedora"));
+	g_assert (!pk_package_id_equal_fuzzy_arch ("moo;0.0.1;i386;fedora", NULL));
+}
+
+/**
+ * pk_test_package_id_benchmark_func:
+ *
+ * Compares checking and reading PackageIDs using a view against the old
+ * way of splitting them into a new string array.
+ **/
+static void
+pk_test_package_id_benchmark_func (void)
+{
+	const gchar *package_id = "kde-i18n-csb;4:3.5.8~pre20071001-0ubuntu1;x86_64;installed:ubuntu-main";
+	const guint loops = 1000000;
+	gdouble elapsed_split;
+	gdouble elapsed_view;
+	guint found = 0;
+	guint i;
+
+	g_test_timer_start ();
+	for (i = 0; i < loops; i++) {
+		g_auto(GStrv) sections = NULL;
+		if (!g_utf8_validate (package_id, -1, NULL))
+			continue;
+		sections = g_strsplit (package_id, ";", -1);
+		if (g_strv_length (sections) == 4 &&
+		    g_strcmp0 (sections[PK_PACKAGE_ID_ARCH], "x86_64") == 0)
+			found++;
+	}
+	elapsed_split = g_test_timer_elapsed ();
+
+	g_test_timer_start ();
+	for (i = 0; i < loops; i++) {
+		PkPackageIdView view;
+		if (pk_package_id_view_init (&view, package_id) &&
+		    pk_package_id_view_section_equal (&view, PK_PACKAGE_ID_ARCH, "x86_64"))
+			found++;
+	}
+	elapsed_view = g_test_timer_elapsed ();
+	g_assert_cmpint (found, ==, loops * 2);
+
+	g_test_message ("g_strsplit took %.0fns per PackageID", elapsed_split * 1e9 / loops);
+	g_test_minimized_result (elapsed_view * 1e9 / loops,
+				 "PkPackageIdView took %.0fns per PackageID",
+				 elapsed_view * 1e9 / loops);
 }
 
 static void
@@ -532,9 +649,163 @@ pk_test_results_func (void)
 	g_free (package_id);
 	g_free (summary);
 
+	/* add compact packages, then a normal one after them */
+	pk_results_add_package_compact (results, PK_INFO_ENUM_INSTALLED,
+					"powertop;1.8-1;i386;installed",
+					"Power consumption monitor",
+					PK_ROLE_ENUM_RESOLVE, NULL);
+	pk_results_add_package_compact (results, PK_INFO_ENUM_AVAILABLE,
+					"powertop;1.9-1;i386;fedora",
+					"Power consumption monitor",
+					PK_ROLE_ENUM_RESOLVE, NULL);
+	item = pk_package_new ();
+	ret = pk_package_set_id (item, "kernel;2.6;i386;fedora", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	pk_package_set_info (item, PK_INFO_ENUM_AVAILABLE);
+	ret = pk_results_add_package (results, item);
+	g_object_unref (item);
+	g_assert (ret);
+
+	/* they are created in the order they were added */
+	packages = pk_results_get_package_array (results);
+	g_assert_cmpint (packages->len, ==, 4);
+	item = g_ptr_array_index (packages, 1);
+	g_assert_cmpstr (pk_package_get_id (item), ==, "powertop;1.8-1;i386;installed");
+	g_assert_cmpint (pk_package_get_info (item), ==, PK_INFO_ENUM_INSTALLED);
+	g_assert_cmpstr (pk_package_get_summary (item), ==, "Power consumption monitor");
+	item = g_ptr_array_index (packages, 2);
+	g_assert_cmpstr (pk_package_get_id (item), ==, "powertop;1.9-1;i386;fedora");
+	item = g_ptr_array_index (packages, 3);
+	g_assert_cmpstr (pk_package_get_id (item), ==, "kernel;2.6;i386;fedora");
+	g_ptr_array_unref (packages);
+
 	g_object_unref (results);
 }
 
+/**
+ * pk_test_client_signals_stream:
+ *
+ * Records a GetFiles-style signal stream that looks like a large query.
+ **/
+static GPtrArray *
+pk_test_client_signals_stream (GPtrArray **names)
+{
+	const gchar *files[] = { "/usr/bin/powertop", "/usr/share/man/man1/powertop.1.gz", NULL };
+	GPtrArray *stream;
+	guint i;
+
+	*names = g_ptr_array_new ();
+	stream = g_ptr_array_new_with_free_func ((GDestroyNotify) g_variant_unref);
+	for (i = 0; i < 1000; i++) {
+		g_autofree gchar *package_id = NULL;
+		package_id = g_strdup_printf ("powertop%u;1.8-1;i386;fedora", i);
+		g_ptr_array_add (*names, (gpointer) "Package");
+		g_ptr_array_add (stream, g_variant_ref_sink (g_variant_new ("(uss)",
+					PK_INFO_ENUM_AVAILABLE,
+					package_id,
+					"Power consumption monitor")));
+		g_ptr_array_add (*names, (gpointer) "ItemProgress");
+		g_ptr_array_add (stream, g_variant_ref_sink (g_variant_new ("(suu)",
+					package_id,
+					PK_STATUS_ENUM_DOWNLOAD,
+					50)));
+		g_ptr_array_add (*names, (gpointer) "Files");
+		g_ptr_array_add (stream, g_variant_ref_sink (g_variant_new ("(s^as)",
+					package_id,
+					files)));
+	}
+	g_ptr_array_add (*names, (gpointer) "RepoDetail");
+	g_ptr_array_add (stream, g_variant_ref_sink (g_variant_new ("(ssb)",
+				"fedora", "Fedora", TRUE)));
+	g_ptr_array_add (*names, (gpointer) "Plan");
+	g_ptr_array_add (stream, g_variant_ref_sink (g_variant_new ("(s)", "1_0badf00d")));
+	g_ptr_array_add (*names, (gpointer) "Destroy");
+	g_ptr_array_add (stream, g_variant_ref_sink (g_variant_new ("()")));
+	return stream;
+}
+
+/**
+ * pk_test_client_signals_replay:
+ *
+ * Replays the stream through the client signal handlers once, checks the
+ * results and returns how many signals were handled.
+ **/
+static guint
+pk_test_client_signals_replay (GPtrArray *names, GPtrArray *stream, PkProgress *progress)
+{
+	guint handled = 0;
+	guint i;
+	g_autoptr(PkResults) results = NULL;
+	g_autoptr(GPtrArray) packages = NULL;
+	g_autoptr(GPtrArray) files_array = NULL;
+	g_autoptr(GPtrArray) repos = NULL;
+
+	results = pk_results_new ();
+	for (i = 0; i < stream->len; i++) {
+		if (pk_client_replay_signal (results, progress,
+					     PK_ROLE_ENUM_GET_FILES,
+					     "/1_abc",
+					     g_ptr_array_index (names, i),
+					     g_ptr_array_index (stream, i)))
+			handled++;
+	}
+
+	/* everything but Destroy has a handler */
+	g_assert_cmpint (handled, ==, stream->len - 1);
+	packages = pk_results_get_package_array (results);
+	g_assert_cmpint (packages->len, ==, 1000);
+	g_assert_cmpstr (pk_package_get_id (g_ptr_array_index (packages, 999)), ==,
+			 "powertop999;1.8-1;i386;fedora");
+	files_array = pk_results_get_files_array (results);
+	g_assert_cmpint (files_array->len, ==, 1000);
+	g_assert_cmpstr (pk_files_get_files (g_ptr_array_index (files_array, 0))[1], ==,
+			 "/usr/share/man/man1/powertop.1.gz");
+	repos = pk_results_get_repo_detail_array (results);
+	g_assert_cmpint (repos->len, ==, 1);
+	g_assert_cmpstr (pk_results_get_plan_token (results), ==, "1_0badf00d");
+	return handled;
+}
+
+static void
+pk_test_client_signals_func (void)
+{
+	g_autoptr(GPtrArray) stream = NULL;
+	g_autoptr(GPtrArray) names = NULL;
+	g_autoptr(PkProgress) progress = NULL;
+
+	stream = pk_test_client_signals_stream (&names);
+	progress = pk_progress_new ();
+	pk_test_client_signals_replay (names, stream, progress);
+}
+
+/**
+ * pk_test_client_signals_benchmark_func:
+ *
+ * Reports how many signals per second the client signal handlers process.
+ **/
+static void
+pk_test_client_signals_benchmark_func (void)
+{
+	const guint loops = 20;
+	gdouble elapsed;
+	guint handled = 0;
+	guint j;
+	g_autoptr(GPtrArray) stream = NULL;
+	g_autoptr(GPtrArray) names = NULL;
+	g_autoptr(PkProgress) progress = NULL;
+
+	stream = pk_test_client_signals_stream (&names);
+	progress = pk_progress_new ();
+	g_test_timer_start ();
+	for (j = 0; j < loops; j++)
+		handled += pk_test_client_signals_replay (names, stream, progress);
+	elapsed = g_test_timer_elapsed ();
+	g_test_maximized_result (handled / MAX (elapsed, 0.000001),
+				 "Replayed %.0f signals per second",
+				 handled / MAX (elapsed, 0.000001));
+}
+
 static void
 pk_test_package_func (void)
 {
@@ -804,6 +1075,238 @@ pk_test_offline_func (void)
 	g_free (tmp);
 }
 
+static const gchar pk_test_control_introspection[] =
+	"<node>"
+	"  <interface name='" PK_DBUS_INTERFACE "'>"
+	"    <property name='VersionMajor' type='u' access='read'/>"
+	"    <property name='BackendName' type='s' access='read'/>"
+	"    <method name='GetDaemonState'>"
+	"      <arg type='s' name='state' direction='out'/>"
+	"    </method>"
+	"    <method name='GetTimeSinceAction'>"
+	"      <arg type='u' name='role' direction='in'/>"
+	"      <arg type='u' name='seconds' direction='out'/>"
+	"    </method>"
+	"  </interface>"
+	"</node>";
+
+typedef struct {
+	GMainLoop	*loop;
+	gint		 messages;
+	gint		 get_all;
+	gint		 get_daemon_state;
+	guint		 pending;
+} PkTestControlHelper;
+
+static void
+pk_test_control_method_cb (GDBusConnection *connection,
+			   const gchar *sender,
+			   const gchar *object_path,
+			   const gchar *interface_name,
+			   const gchar *method_name,
+			   GVariant *parameters,
+			   GDBusMethodInvocation *invocation,
+			   gpointer user_data)
+{
+	if (g_strcmp0 (method_name, "GetDaemonState") == 0) {
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new ("(s)", "idle"));
+		return;
+	}
+	g_dbus_method_invocation_return_value (invocation,
+					       g_variant_new ("(u)", 42));
+}
+
+static GVariant *
+pk_test_control_property_cb (GDBusConnection *connection,
+			     const gchar *sender,
+			     const gchar *object_path,
+			     const gchar *interface_name,
+			     const gchar *property_name,
+			     GError **error,
+			     gpointer user_data)
+{
+	if (g_strcmp0 (property_name, "VersionMajor") == 0)
+		return g_variant_new_uint32 (1);
+	return g_variant_new_string ("dummy");
+}
+
+static const GDBusInterfaceVTable pk_test_control_vtable = {
+	pk_test_control_method_cb,
+	pk_test_control_property_cb,
+	NULL
+};
+
+static GDBusMessage *
+pk_test_control_filter_cb (GDBusConnection *connection,
+			   GDBusMessage *message,
+			   gboolean incoming,
+			   gpointer user_data)
+{
+	PkTestControlHelper *helper = (PkTestControlHelper *) user_data;
+	const gchar *member;
+
+	if (incoming)
+		return message;
+	if (g_strcmp0 (g_dbus_message_get_destination (message), PK_DBUS_SERVICE) != 0)
+		return message;
+	g_atomic_int_inc (&helper->messages);
+	member = g_dbus_message_get_member (message);
+	if (g_strcmp0 (member, "GetAll") == 0)
+		g_atomic_int_inc (&helper->get_all);
+	else if (g_strcmp0 (member, "GetDaemonState") == 0)
+		g_atomic_int_inc (&helper->get_daemon_state);
+	return message;
+}
+
+static void
+pk_test_control_daemon_state_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	PkTestControlHelper *helper = (PkTestControlHelper *) user_data;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *state = NULL;
+
+	state = pk_control_get_daemon_state_finish (PK_CONTROL (source), res, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (state, ==, "idle");
+	if (--helper->pending == 0)
+		g_main_loop_quit (helper->loop);
+}
+
+static void
+pk_test_control_time_since_action_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	PkTestControlHelper *helper = (PkTestControlHelper *) user_data;
+	g_autoptr(GError) error = NULL;
+	guint seconds;
+
+	seconds = pk_control_get_time_since_action_finish (PK_CONTROL (source), res, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (seconds, ==, 42);
+	g_main_loop_quit (helper->loop);
+}
+
+static void
+pk_test_control_notify_cb (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	PkTestControlHelper *helper = (PkTestControlHelper *) user_data;
+	g_main_loop_quit (helper->loop);
+}
+
+static void
+pk_test_control_dbus_func (void)
+{
+	GTestDBus *dbus;
+	PkTestControlHelper helper = { 0 };
+	guint filter_id;
+	guint i;
+	guint registration_id;
+	g_autofree gchar *backend_name = NULL;
+	g_autofree gchar *dbus_daemon = NULL;
+	g_autoptr(GDBusConnection) connection = NULL;
+	g_autoptr(GDBusConnection) daemon = NULL;
+	g_autoptr(GDBusNodeInfo) introspection = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GMainLoop) loop = NULL;
+	g_autoptr(GVariantBuilder) changed = NULL;
+	g_autoptr(GVariant) reply = NULL;
+	g_autoptr(PkControl) control = NULL;
+
+	dbus_daemon = g_find_program_in_path ("dbus-daemon");
+	if (dbus_daemon == NULL) {
+		g_test_skip ("no dbus-daemon to run a private bus");
+		return;
+	}
+
+	/* run a fake daemon on a private bus standing in for the system bus */
+	dbus = g_test_dbus_new (G_TEST_DBUS_NONE);
+	g_test_dbus_up (dbus);
+	g_setenv ("DBUS_SYSTEM_BUS_ADDRESS", g_test_dbus_get_bus_address (dbus), TRUE);
+	daemon = g_dbus_connection_new_for_address_sync (g_test_dbus_get_bus_address (dbus),
+							 G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+							 G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+							 NULL, NULL, &error);
+	g_assert_no_error (error);
+	introspection = g_dbus_node_info_new_for_xml (pk_test_control_introspection, &error);
+	g_assert_no_error (error);
+	registration_id = g_dbus_connection_register_object (daemon,
+							     PK_DBUS_PATH,
+							     introspection->interfaces[0],
+							     &pk_test_control_vtable,
+							     NULL, NULL, &error);
+	g_assert_no_error (error);
+	reply = g_dbus_connection_call_sync (daemon,
+					     "org.freedesktop.DBus",
+					     "/org/freedesktop/DBus",
+					     "org.freedesktop.DBus",
+					     "RequestName",
+					     g_variant_new ("(su)", PK_DBUS_SERVICE, 0),
+					     G_VARIANT_TYPE ("(u)"),
+					     G_DBUS_CALL_FLAGS_NONE,
+					     -1, NULL, &error);
+	g_assert_no_error (error);
+
+	/* count what the client sends to the daemon */
+	connection = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
+	g_assert_no_error (error);
+	filter_id = g_dbus_connection_add_filter (connection,
+						  pk_test_control_filter_cb,
+						  &helper, NULL);
+
+	loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = loop;
+	control = pk_control_new ();
+
+	/* concurrent calls racing the first connect share one proxy */
+	helper.pending = 5;
+	for (i = 0; i < 5; i++) {
+		pk_control_get_daemon_state_async (control, NULL,
+						   pk_test_control_daemon_state_cb,
+						   &helper);
+	}
+	g_main_loop_run (loop);
+	g_assert_cmpint (g_atomic_int_get (&helper.get_all), ==, 1);
+	g_assert_cmpint (g_atomic_int_get (&helper.get_daemon_state), ==, 5);
+
+	/* once connected, a call is a single message */
+	g_atomic_int_set (&helper.messages, 0);
+	pk_control_get_time_since_action_async (control, PK_ROLE_ENUM_INSTALL_PACKAGES, NULL,
+						pk_test_control_time_since_action_cb,
+						&helper);
+	g_main_loop_run (loop);
+	g_assert_cmpint (g_atomic_int_get (&helper.messages), ==, 1);
+	g_assert_cmpint (g_atomic_int_get (&helper.get_all), ==, 1);
+
+	/* property changes update the cache without another GetAll */
+	g_signal_connect (control, "notify::backend-name",
+			  G_CALLBACK (pk_test_control_notify_cb), &helper);
+	changed = g_variant_builder_new (G_VARIANT_TYPE ("a{sv}"));
+	g_variant_builder_add (changed, "{sv}", "BackendName",
+			       g_variant_new_string ("aptcc"));
+	g_dbus_connection_emit_signal (daemon, NULL, PK_DBUS_PATH,
+				       "org.freedesktop.DBus.Properties",
+				       "PropertiesChanged",
+				       g_variant_new ("(sa{sv}as)",
+						      PK_DBUS_INTERFACE,
+						      changed, NULL),
+				       &error);
+	g_assert_no_error (error);
+	g_main_loop_run (loop);
+	g_object_get (control, "backend-name", &backend_name, NULL);
+	g_assert_cmpstr (backend_name, ==, "aptcc");
+	g_assert_cmpint (g_atomic_int_get (&helper.get_all), ==, 1);
+
+	g_signal_handlers_disconnect_by_data (control, &helper);
+	g_dbus_connection_remove_filter (connection, filter_id);
+	g_dbus_connection_unregister_object (daemon, registration_id);
+	g_clear_object (&control);
+	g_clear_object (&connection);
+	g_dbus_connection_close_sync (daemon, NULL, NULL);
+	g_test_dbus_down (dbus);
+	g_object_unref (dbus);
+	g_unsetenv ("DBUS_SYSTEM_BUS_ADDRESS");
+}
+
 int
 main (int argc, char **argv)
 {
@@ -818,14 +1321,21 @@ main (int argc, char **argv)
 	/* tests go here */
 	g_test_add_func ("/packagekit-glib2/common", pk_test_common_func);
 	g_test_add_func ("/packagekit-glib2/enum", pk_test_enum_func);
+	g_test_add_func ("/packagekit-glib2/enum-round-trip", pk_test_enum_round_trip_func);
 	g_test_add_func ("/packagekit-glib2/bitfield", pk_test_bitfield_func);
 	g_test_add_func ("/packagekit-glib2/package-id", pk_test_package_id_func);
+	if (g_test_perf ())
+		g_test_add_func ("/packagekit-glib2/package-id-benchmark", pk_test_package_id_benchmark_func);
 	g_test_add_func ("/packagekit-glib2/package-ids", pk_test_package_ids_func);
 	g_test_add_func ("/packagekit-glib2/progress", pk_test_progress_func);
 	g_test_add_func ("/packagekit-glib2/results", pk_test_results_func);
+	g_test_add_func ("/packagekit-glib2/client-signals", pk_test_client_signals_func);
+	if (g_test_perf ())
+		g_test_add_func ("/packagekit-glib2/client-signals-benchmark", pk_test_client_signals_benchmark_func);
 	g_test_add_func ("/packagekit-glib2/package", pk_test_package_func);
 	g_test_add_func ("/packagekit-glib2/progress-bar", pk_test_progress_bar);
 	g_test_add_func ("/packagekit-glib2/offline", pk_test_offline_func);
+	g_test_add_func ("/packagekit-glib2/control-dbus", pk_test_control_dbus_func);
 
 	return g_test_run ();
 }
@@ -85,6 +85,8 @@ struct PkBackendJobPrivate
 	gchar			*proxy_https;
 	gchar			*proxy_socks;
 	gpointer		 user_data;
+	gpointer		 plan;
+	GDestroyNotify		 plan_destroy;
 	guint64			 download_size_remaining;
 	guint			 cache_age;
 	guint			 download_files;
@@ -494,6 +496,65 @@ pk_backend_job_set_cache_age (PkBackendJob *job, guint cache_age)
 	job->priv->cache_age = cache_age;
 }
 
+/**
+ * pk_backend_job_get_plan:
+ *
+ * Gets the solved plan for the job. For a real transaction this is the plan
+ * the backend stored in the matching simulate, if the package database has
+ * not changed since; otherwise the backend has to depsolve again.
+ *
+ * Return value: the backend-specific plan, or %NULL
+ **/
+gpointer
+pk_backend_job_get_plan (PkBackendJob *job)
+{
+	g_return_val_if_fail (PK_IS_BACKEND_JOB (job), NULL);
+	return job->priv->plan;
+}
+
+/**
+ * pk_backend_job_set_plan:
+ * @plan: the backend-specific solved plan, or %NULL
+ * @destroy: the function to free @plan with, or %NULL
+ *
+ * Stores the result of depsolving in a simulate so that the real
+ * transaction can reuse it. This function can be called on any thread.
+ *
+ * Keeping a plan is optional. If the backend never sets one, no token is
+ * sent to the client and every transaction solves as before.
+ **/
+void
+pk_backend_job_set_plan (PkBackendJob *job, gpointer plan, GDestroyNotify destroy)
+{
+	g_return_if_fail (PK_IS_BACKEND_JOB (job));
+
+	if (job->priv->plan != NULL && job->priv->plan_destroy != NULL)
+		job->priv->plan_destroy (job->priv->plan);
+	job->priv->plan = plan;
+	job->priv->plan_destroy = destroy;
+}
+
+/**
+ * pk_backend_job_steal_plan:
+ * @destroy: (out): the function to free the plan with
+ *
+ * Return value: the plan, which is no longer owned by the job
+ **/
+gpointer
+pk_backend_job_steal_plan (PkBackendJob *job, GDestroyNotify *destroy)
+{
+	gpointer plan;
+
+	g_return_val_if_fail (PK_IS_BACKEND_JOB (job), NULL);
+	g_return_val_if_fail (destroy != NULL, NULL);
+
+	plan = job->priv->plan;
+	*destroy = job->priv->plan_destroy;
+	job->priv->plan = NULL;
+	job->priv->plan_destroy = NULL;
+	return plan;
+}
+
 /**
  * pk_backend_job_set_user_data:
  **/
@@ -1827,6 +1888,7 @@ pk_backend_job_finalize (GObject *object)
 	g_free (job->priv->cmdline);
 	g_free (job->priv->locale);
 	g_free (job->priv->frontend_socket);
+	pk_backend_job_set_plan (job, NULL, NULL);
 	if (job->priv->last_package != NULL) {
 		g_object_unref (job->priv->last_package);
 		job->priv->last_package = NULL;
@@ -144,6 +144,12 @@ const gchar	*pk_backend_job_get_pac			(PkBackendJob	*job);
 const gchar	*pk_backend_job_get_locale		(PkBackendJob	*job);
 const gchar	*pk_backend_job_get_frontend_socket	(PkBackendJob	*job);
 guint		 pk_backend_job_get_cache_age		(PkBackendJob	*job);
+gpointer	 pk_backend_job_get_plan		(PkBackendJob	*job);
+void		 pk_backend_job_set_plan		(PkBackendJob	*job,
+							 gpointer	 plan,
+							 GDestroyNotify	 destroy);
+gpointer	 pk_backend_job_steal_plan		(PkBackendJob	*job,
+							 GDestroyNotify	*destroy);
 
 /* transaction vfuncs */
 typedef void	 (*PkBackendJobVFunc)			(PkBackendJob	*job,
@@ -207,8 +207,23 @@ struct PkBackendPrivate
 	guint			 repo_list_changed_id;
 	guint			 installed_db_changed_id;
 	guint			 updates_changed_id;
+	GPtrArray		*plans;
+	guint			 plan_counter;
+	gint			 generation;
 };
 
+/* only the most recent simulates are kept, real transactions normally
+ * follow the simulate within seconds */
+#define PK_BACKEND_PLANS_MAX		8
+
+typedef struct {
+	gchar			*token;
+	gchar			*key;
+	guint			 generation;
+	gpointer		 data;
+	GDestroyNotify		 destroy;
+} PkBackendPlan;
+
 G_DEFINE_TYPE (PkBackend, pk_backend, G_TYPE_OBJECT)
 
 enum {
@@ -659,6 +674,9 @@ pk_backend_repo_list_changed (PkBackend *backend)
 	g_return_if_fail (PK_IS_BACKEND (backend));
 	g_return_if_fail (backend->priv->loaded);
 
+	/* any depsolve done before now is out of date */
+	pk_backend_invalidate_plans (backend);
+
 	/* already scheduled */
 	if (backend->priv->repo_list_changed_id != 0)
 		return;
@@ -757,6 +775,9 @@ pk_backend_installed_db_changed (PkBackend *backend)
 	g_return_if_fail (PK_IS_BACKEND (backend));
 	g_return_if_fail (backend->priv->loaded);
 
+	/* any depsolve done before now is out of date */
+	pk_backend_invalidate_plans (backend);
+
 	/* already scheduled */
 	if (backend->priv->installed_db_changed_id != 0)
 		return;
@@ -766,6 +787,168 @@ pk_backend_installed_db_changed (PkBackend *backend)
 		g_idle_add (pk_backend_installed_db_changed_cb, backend);
 }
 
+/**
+ * pk_backend_plan_free:
+ **/
+static void
+pk_backend_plan_free (PkBackendPlan *plan)
+{
+	if (plan->data != NULL && plan->destroy != NULL)
+		plan->destroy (plan->data);
+	g_free (plan->token);
+	g_free (plan->key);
+	g_slice_free (PkBackendPlan, plan);
+}
+
+/**
+ * pk_backend_get_generation:
+ *
+ * Gets the package database generation, which changes every time the
+ * installed packages, the repositories or the metadata may have changed.
+ *
+ * This function can be called on any thread.
+ **/
+guint
+pk_backend_get_generation (PkBackend *backend)
+{
+	g_return_val_if_fail (PK_IS_BACKEND (backend), 0);
+	return (guint) g_atomic_int_get (&backend->priv->generation);
+}
+
+/**
+ * pk_backend_invalidate_plans:
+ *
+ * Moves to a new package database generation, so that no plan solved
+ * against the old one is reused. The plans themselves are dropped the next
+ * time the cache is used, as this function can be called on any thread.
+ **/
+void
+pk_backend_invalidate_plans (PkBackend *backend)
+{
+	g_return_if_fail (PK_IS_BACKEND (backend));
+	g_atomic_int_inc (&backend->priv->generation);
+}
+
+/**
+ * pk_backend_expire_plans:
+ **/
+static void
+pk_backend_expire_plans (PkBackend *backend)
+{
+	PkBackendPlan *plan;
+	guint generation = pk_backend_get_generation (backend);
+	guint i;
+
+	for (i = 0; i < backend->priv->plans->len; ) {
+		plan = g_ptr_array_index (backend->priv->plans, i);
+		if (plan->generation != generation) {
+			g_ptr_array_remove_index (backend->priv->plans, i);
+			continue;
+		}
+		i++;
+	}
+}
+
+/**
+ * pk_backend_save_plan:
+ * @key: the role and parameters the plan was solved for
+ * @generation: the package database generation when the job started
+ *
+ * Takes the plan the backend stored on a simulate job and keeps it for the
+ * real transaction.
+ *
+ * Return value: the opaque token for the plan, or %NULL if there was no
+ * plan or the package database changed while solving it
+ **/
+gchar *
+pk_backend_save_plan (PkBackend *backend,
+		      PkBackendJob *job,
+		      const gchar *key,
+		      guint generation)
+{
+	GDestroyNotify destroy = NULL;
+	PkBackendPlan *plan;
+	gpointer data;
+
+	g_return_val_if_fail (PK_IS_BACKEND (backend), NULL);
+	g_return_val_if_fail (PK_IS_BACKEND_JOB (job), NULL);
+	g_return_val_if_fail (key != NULL, NULL);
+
+	data = pk_backend_job_steal_plan (job, &destroy);
+	if (data == NULL)
+		return NULL;
+
+	/* solved against a database that has since changed */
+	if (generation != pk_backend_get_generation (backend)) {
+		g_debug ("not saving plan for %s, database changed", key);
+		if (destroy != NULL)
+			destroy (data);
+		return NULL;
+	}
+
+	/* drop the oldest ones */
+	pk_backend_expire_plans (backend);
+	if (backend->priv->plans->len >= PK_BACKEND_PLANS_MAX)
+		g_ptr_array_remove_index (backend->priv->plans, 0);
+
+	plan = g_slice_new0 (PkBackendPlan);
+	plan->token = g_strdup_printf ("%u_%08x",
+				       ++backend->priv->plan_counter,
+				       g_random_int ());
+	plan->key = g_strdup (key);
+	plan->generation = generation;
+	plan->data = data;
+	plan->destroy = destroy;
+	g_ptr_array_add (backend->priv->plans, plan);
+	g_debug ("saved plan %s for %s", plan->token, key);
+	return g_strdup (plan->token);
+}
+
+/**
+ * pk_backend_restore_plan:
+ * @token: the token returned by the simulate
+ * @key: the role and parameters of the real transaction
+ *
+ * Moves the saved plan onto the job if it was solved for the same role and
+ * parameters and the package database has not changed since. A plan is
+ * only ever used once.
+ *
+ * Return value: %TRUE if the backend can skip the depsolve
+ **/
+gboolean
+pk_backend_restore_plan (PkBackend *backend,
+			 PkBackendJob *job,
+			 const gchar *token,
+			 const gchar *key)
+{
+	PkBackendPlan *plan;
+	guint i;
+
+	g_return_val_if_fail (PK_IS_BACKEND (backend), FALSE);
+	g_return_val_if_fail (PK_IS_BACKEND_JOB (job), FALSE);
+	g_return_val_if_fail (token != NULL, FALSE);
+	g_return_val_if_fail (key != NULL, FALSE);
+
+	pk_backend_expire_plans (backend);
+	for (i = 0; i < backend->priv->plans->len; i++) {
+		plan = g_ptr_array_index (backend->priv->plans, i);
+		if (g_strcmp0 (plan->token, token) != 0)
+			continue;
+		if (g_strcmp0 (plan->key, key) != 0) {
+			g_debug ("plan %s was solved for %s, not %s",
+				 token, plan->key, key);
+			break;
+		}
+		g_debug ("reusing plan %s", token);
+		pk_backend_job_set_plan (job, plan->data, plan->destroy);
+		plan->data = NULL;
+		g_ptr_array_remove_index (backend->priv->plans, i);
+		return TRUE;
+	}
+	g_debug ("no plan %s, backend will depsolve again", token);
+	return FALSE;
+}
+
 /**
  * pk_backend_transaction_inhibit_start:
  *
@@ -1141,6 +1324,7 @@ pk_backend_finalize (GObject *object)
 	backend = PK_BACKEND (object);
 
 	g_free (backend->priv->name);
+	g_ptr_array_unref (backend->priv->plans);
 
 	g_key_file_unref (backend->priv->conf);
 	g_hash_table_destroy (backend->priv->eulas);
@@ -1888,6 +2072,7 @@ pk_backend_init (PkBackend *backend)
 							    NULL,
 							    g_free);
 	g_mutex_init (&backend->priv->thread_hash_mutex);
+	backend->priv->plans = g_ptr_array_new_with_free_func ((GDestroyNotify) pk_backend_plan_free);
 }
 
 /**
@@ -85,6 +85,16 @@ gboolean	 pk_backend_is_implemented		(PkBackend	*backend,
 gchar		*pk_backend_get_accepted_eula_string	(PkBackend	*backend);
 void		 pk_backend_repo_list_changed		(PkBackend      *backend);
 void		 pk_backend_installed_db_changed	(PkBackend      *backend);
+guint		 pk_backend_get_generation		(PkBackend	*backend);
+void		 pk_backend_invalidate_plans		(PkBackend	*backend);
+gchar		*pk_backend_save_plan			(PkBackend	*backend,
+							 PkBackendJob	*job,
+							 const gchar	*key,
+							 guint		 generation);
+gboolean	 pk_backend_restore_plan		(PkBackend	*backend,
+							 PkBackendJob	*job,
+							 const gchar	*token,
+							 const gchar	*key);
 
 
 gboolean	 pk_backend_updates_changed		(PkBackend	*backend);
@@ -1409,6 +1409,41 @@ pk_engine_daemon_method_call (GDBusConnection *connection_, const gchar *sender,
 		return;
 	}
 
+	if (g_strcmp0 (method_name, "CreateTransactionWithHints") == 0) {
+		PkTransaction *transaction;
+		g_autofree gchar **hints = NULL;
+
+		g_debug ("CreateTransactionWithHints method called");
+		g_variant_get (parameters, "(^a&s)", &hints);
+		data = pk_transaction_db_generate_id (engine->priv->transaction_db);
+		g_assert (data != NULL);
+		ret = pk_scheduler_create (engine->priv->scheduler,
+					   data, sender, &error);
+		if (!ret) {
+			g_dbus_method_invocation_return_error (invocation,
+							       PK_ENGINE_ERROR,
+							       PK_ENGINE_ERROR_CANNOT_CHECK_AUTH,
+							       "could not create transaction %s: %s",
+							       data,
+							       error->message);
+			return;
+		}
+
+		/* the transaction is unused, so the scheduler will
+		 * remove it again if the hints are invalid */
+		transaction = pk_scheduler_get_transaction (engine->priv->scheduler, data);
+		if (!pk_transaction_set_hints_strv (transaction, hints, &error)) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+
+		g_debug ("sending object path: '%s'", data);
+		value = g_variant_new ("(o@a{sv})", data,
+				       pk_transaction_get_properties (transaction));
+		g_dbus_method_invocation_return_value (invocation, value);
+		return;
+	}
+
 	if (g_strcmp0 (method_name, "GetTransactionList") == 0) {
 		transaction_list = pk_scheduler_get_array (engine->priv->scheduler);
 		value = g_variant_new ("(^a&o)", transaction_list);
@@ -300,6 +300,67 @@ pk_test_backend_func (void)
 		         PK_EXIT_ENUM_NEED_UNTRUSTED);
 }
 
+static void
+pk_test_backend_plan_func (void)
+{
+	const gchar *key = "install-packages|none|hal;0.0.1;i386;fedora|0|0";
+	gboolean ret;
+	guint generation;
+	g_autofree gchar *token = NULL;
+	g_autofree gchar *token2 = NULL;
+	g_autoptr(GKeyFile) conf = NULL;
+	g_autoptr(PkBackend) backend = NULL;
+	g_autoptr(PkBackendJob) job = NULL;
+
+	conf = g_key_file_new ();
+	backend = pk_backend_new (conf);
+	generation = pk_backend_get_generation (backend);
+
+	/* nothing to save if the backend did not keep a plan */
+	job = pk_backend_job_new (conf);
+	token = pk_backend_save_plan (backend, job, key, generation);
+	g_assert (token == NULL);
+
+	/* save a plan from a simulate */
+	pk_backend_job_set_plan (job, g_strdup ("solved"), g_free);
+	token = pk_backend_save_plan (backend, job, key, generation);
+	g_assert (token != NULL);
+	g_assert (pk_backend_job_get_plan (job) == NULL);
+
+	/* a different request cannot use it */
+	g_object_unref (job);
+	job = pk_backend_job_new (conf);
+	ret = pk_backend_restore_plan (backend, job, token,
+				       "remove-packages|none|hal;0.0.1;i386;fedora|0|0");
+	g_assert (!ret);
+	g_assert (pk_backend_job_get_plan (job) == NULL);
+
+	/* the same request gets the plan, but only once */
+	ret = pk_backend_restore_plan (backend, job, token, key);
+	g_assert (ret);
+	g_assert_cmpstr (pk_backend_job_get_plan (job), ==, "solved");
+	g_object_unref (job);
+	job = pk_backend_job_new (conf);
+	ret = pk_backend_restore_plan (backend, job, token, key);
+	g_assert (!ret);
+
+	/* a plan is dropped when the database changes */
+	pk_backend_job_set_plan (job, g_strdup ("solved"), g_free);
+	token2 = pk_backend_save_plan (backend, job, key, generation);
+	g_assert (token2 != NULL);
+	g_assert_cmpstr (token, !=, token2);
+	pk_backend_invalidate_plans (backend);
+	g_assert_cmpint (pk_backend_get_generation (backend), !=, generation);
+	ret = pk_backend_restore_plan (backend, job, token2, key);
+	g_assert (!ret);
+
+	/* a plan solved before the database changed is not saved */
+	pk_backend_job_set_plan (job, g_strdup ("solved"), g_free);
+	g_free (token2);
+	token2 = pk_backend_save_plan (backend, job, key, generation);
+	g_assert (token2 == NULL);
+}
+
 static guint _backend_spawn_number_packages = 0;
 
 /**
@@ -1461,6 +1522,7 @@ main (int argc, char **argv)
 
 	/* backend stuff */
 	g_test_add_func ("/packagekit/backend", pk_test_backend_func);
+	g_test_add_func ("/packagekit/backend-plan", pk_test_backend_plan_func);
 	g_test_add_func ("/packagekit/backend_spawn", pk_test_backend_spawn_func);
 
 	return g_test_run ();
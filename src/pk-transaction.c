@@ -133,6 +133,8 @@ struct PkTransactionPrivate
 	gchar			*cached_directory;
 	gchar			*cached_cat_id;
 	PkUpgradeKindEnum	 cached_upgrade_kind;
+	gchar			*plan_token;
+	guint			 plan_generation;
 	GPtrArray		*supported_content_types;
 	guint			 registration_id;
 	GDBusConnection		*connection;
@@ -313,6 +315,33 @@ out:
 	return TRUE;
 }
 
+/**
+ * pk_transaction_role_changes_database:
+ *
+ * Return value: %TRUE if a depsolve done before the role ran may no longer
+ * be valid afterwards
+ **/
+static gboolean
+pk_transaction_role_changes_database (PkRoleEnum role)
+{
+	switch (role) {
+	case PK_ROLE_ENUM_INSTALL_FILES:
+	case PK_ROLE_ENUM_INSTALL_PACKAGES:
+	case PK_ROLE_ENUM_INSTALL_SIGNATURE:
+	case PK_ROLE_ENUM_REFRESH_CACHE:
+	case PK_ROLE_ENUM_REMOVE_PACKAGES:
+	case PK_ROLE_ENUM_REPAIR_SYSTEM:
+	case PK_ROLE_ENUM_REPO_ENABLE:
+	case PK_ROLE_ENUM_REPO_REMOVE:
+	case PK_ROLE_ENUM_REPO_SET_DATA:
+	case PK_ROLE_ENUM_UPDATE_PACKAGES:
+	case PK_ROLE_ENUM_UPGRADE_SYSTEM:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
 /**
  * pk_transaction_emit_property_changed:
  **/
@@ -439,6 +468,74 @@ pk_transaction_finished_emit (PkTransaction *transaction,
 	g_signal_emit (transaction, signals[SIGNAL_FINISHED], 0);
 }
 
+/**
+ * pk_transaction_get_plan_key:
+ *
+ * Describes the depsolve a plan was made for. Only downloading does not
+ * change the result, so it is not part of the key.
+ *
+ * Return value: the key, or %NULL if the role cannot reuse a plan
+ **/
+static gchar *
+pk_transaction_get_plan_key (PkTransaction *transaction)
+{
+	PkTransactionPrivate *priv = transaction->priv;
+	PkBitfield transaction_flags = priv->cached_transaction_flags;
+	g_autofree gchar *flags = NULL;
+	g_autofree gchar *package_ids = NULL;
+
+	if (priv->role != PK_ROLE_ENUM_INSTALL_PACKAGES &&
+	    priv->role != PK_ROLE_ENUM_UPDATE_PACKAGES &&
+	    priv->role != PK_ROLE_ENUM_REMOVE_PACKAGES)
+		return NULL;
+	if (priv->cached_package_ids == NULL)
+		return NULL;
+
+	pk_bitfield_remove (transaction_flags, PK_TRANSACTION_FLAG_ENUM_SIMULATE);
+	pk_bitfield_remove (transaction_flags, PK_TRANSACTION_FLAG_ENUM_ONLY_DOWNLOAD);
+	flags = pk_transaction_flag_bitfield_to_string (transaction_flags);
+	package_ids = pk_package_ids_to_string (priv->cached_package_ids);
+	return g_strdup_printf ("%s|%s|%s|%i|%i",
+				pk_role_enum_to_string (priv->role),
+				flags,
+				package_ids,
+				priv->cached_allow_deps,
+				priv->cached_autoremove);
+}
+
+/**
+ * pk_transaction_plan_emit:
+ *
+ * Keeps the depsolve of a successful simulate and sends the client the
+ * token for it.
+ **/
+static void
+pk_transaction_plan_emit (PkTransaction *transaction)
+{
+	PkTransactionPrivate *priv = transaction->priv;
+	g_autofree gchar *key = NULL;
+	g_autofree gchar *token = NULL;
+
+	key = pk_transaction_get_plan_key (transaction);
+	if (key == NULL)
+		return;
+	token = pk_backend_save_plan (priv->backend,
+				      priv->job,
+				      key,
+				      priv->plan_generation);
+	if (token == NULL)
+		return;
+
+	g_debug ("emitting plan %s", token);
+	g_dbus_connection_emit_signal (priv->connection,
+				       NULL,
+				       priv->tid,
+				       PK_DBUS_INTERFACE_TRANSACTION,
+				       "Plan",
+				       g_variant_new ("(s)", token),
+				       NULL);
+}
+
 /**
  * pk_transaction_error_code_emit:
  **/
@@ -1131,6 +1228,17 @@ pk_transaction_finished_cb (PkBackendJob *job, PkExitEnum exit_enum, PkTransacti
 	if (exit_enum == PK_EXIT_ENUM_SUCCESS)
 		pk_transaction_finish_invalidate_caches (transaction);
 
+	/* even a failed transaction may have changed the database */
+	if (!pk_bitfield_contain (transaction_flags, PK_TRANSACTION_FLAG_ENUM_SIMULATE) &&
+	    !pk_bitfield_contain (transaction_flags, PK_TRANSACTION_FLAG_ENUM_ONLY_DOWNLOAD) &&
+	    pk_transaction_role_changes_database (transaction->priv->role))
+		pk_backend_invalidate_plans (transaction->priv->backend);
+
+	/* the real transaction can reuse the depsolve */
+	if (exit_enum == PK_EXIT_ENUM_SUCCESS &&
+	    pk_bitfield_contain (transaction_flags, PK_TRANSACTION_FLAG_ENUM_SIMULATE))
+		pk_transaction_plan_emit (transaction);
+
 	/* find the length of time we have been running */
 	time_ms = pk_transaction_get_runtime (transaction);
 	g_debug ("backend was running for %i ms", time_ms);
@@ -1873,6 +1981,22 @@ pk_transaction_run (PkTransaction *transaction)
 				  (PkBackendJobVFunc) pk_transaction_category_cb,
 				  transaction);
 
+	/* a simulate only keeps its plan if nothing changed while solving */
+	priv->plan_generation = pk_backend_get_generation (priv->backend);
+
+	/* reuse the depsolve from the simulate if it still applies */
+	if (priv->plan_token != NULL &&
+	    !pk_bitfield_contain (priv->cached_transaction_flags,
+				  PK_TRANSACTION_FLAG_ENUM_SIMULATE)) {
+		g_autofree gchar *key = pk_transaction_get_plan_key (transaction);
+		if (key != NULL) {
+			pk_backend_restore_plan (priv->backend,
+						 priv->job,
+						 priv->plan_token,
+						 key);
+		}
+	}
+
 	/* do the correct action with the cached parameters */
 	switch (priv->role) {
 	case PK_ROLE_ENUM_DEPENDS_ON:
@@ -4830,12 +4954,52 @@ pk_transaction_set_hint (PkTransaction *transaction,
 		return TRUE;
 	}
 
+	/* plan-token=<token-from-simulate> */
+	if (g_strcmp0 (key, "plan-token") == 0) {
+		g_free (priv->plan_token);
+		priv->plan_token = g_strdup (value);
+		return TRUE;
+	}
+
 	/* to preserve forwards and backwards compatibility, we ignore
 	 * extra options here */
 	g_warning ("unknown option: %s with value %s", key, value);
 	return TRUE;
 }
 
+/**
+ * pk_transaction_set_hints_strv:
+ *
+ * Sets hints in the key=value form used by the SetHints method.
+ **/
+gboolean
+pk_transaction_set_hints_strv (PkTransaction *transaction,
+			       gchar **hints,
+			       GError **error)
+{
+	guint i;
+
+	g_return_val_if_fail (PK_IS_TRANSACTION (transaction), FALSE);
+	g_return_val_if_fail (hints != NULL, FALSE);
+
+	for (i = 0; hints[i] != NULL; i++) {
+		g_auto(GStrv) sections = NULL;
+		sections = g_strsplit (hints[i], "=", 2);
+		if (g_strv_length (sections) != 2) {
+			g_set_error (error, PK_TRANSACTION_ERROR,
+				     PK_TRANSACTION_ERROR_NOT_SUPPORTED,
+				     "Could not parse hint '%s'", hints[i]);
+			return FALSE;
+		}
+		if (!pk_transaction_set_hint (transaction,
+					      sections[0],
+					      sections[1],
+					      error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 /**
  * pk_transaction_set_hints:
  */
@@ -4844,8 +5008,6 @@ pk_transaction_set_hints (PkTransaction *transaction,
 			  GVariant *params,
 			  GDBusMethodInvocation *context)
 {
-	gboolean ret;
-	guint i;
 	g_autofree gchar **hints = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autofree gchar *dbg = NULL;
@@ -4857,25 +5019,7 @@ pk_transaction_set_hints (PkTransaction *transaction,
 	dbg = g_strjoinv (", ", (gchar**) hints);
 	g_debug ("SetHints method called: %s", dbg);
 
-	/* parse */
-	for (i = 0; hints[i] != NULL; i++) {
-		g_auto(GStrv) sections = NULL;
-		sections = g_strsplit (hints[i], "=", 2);
-		if (g_strv_length (sections) == 2) {
-			ret = pk_transaction_set_hint (transaction,
-						       sections[0],
-						       sections[1],
-						       &error);
-			if (!ret)
-				goto out;
-		} else {
-			g_set_error (&error, PK_TRANSACTION_ERROR,
-					     PK_TRANSACTION_ERROR_NOT_SUPPORTED,
-					     "Could not parse hint '%s'", hints[i]);
-			goto out;
-		}
-	}
-out:
+	pk_transaction_set_hints_strv (transaction, hints, &error);
 	pk_transaction_dbus_return (context, error);
 }
 
@@ -5179,6 +5323,33 @@ pk_transaction_get_property (GDBusConnection *connection_, const gchar *sender,
 	return NULL;
 }
 
+/**
+ * pk_transaction_get_properties:
+ *
+ * Return value: (transfer floating): all the properties as a{sv}
+ **/
+GVariant *
+pk_transaction_get_properties (PkTransaction *transaction)
+{
+	GDBusPropertyInfo **properties;
+	GVariantBuilder builder;
+	GVariant *value;
+	guint i;
+
+	g_return_val_if_fail (PK_IS_TRANSACTION (transaction), NULL);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+	properties = transaction->priv->introspection->interfaces[0]->properties;
+	for (i = 0; properties != NULL && properties[i] != NULL; i++) {
+		value = pk_transaction_get_property (NULL, NULL, NULL, NULL,
+						     properties[i]->name,
+						     NULL, transaction);
+		if (value != NULL)
+			g_variant_builder_add (&builder, "{sv}", properties[i]->name, value);
+	}
+	return g_variant_builder_end (&builder);
+}
+
 /**
  * pk_transaction_method_call:
  **/
@@ -5527,6 +5698,7 @@ pk_transaction_finalize (GObject *object)
 	g_strfreev (transaction->priv->cached_package_ids);
 	g_free (transaction->priv->cached_transaction_id);
 	g_free (transaction->priv->cached_directory);
+	g_free (transaction->priv->plan_token);
 	g_strfreev (transaction->priv->cached_values);
 	g_free (transaction->priv->cached_repo_id);
 	g_free (transaction->priv->cached_parameter);
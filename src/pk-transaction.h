@@ -92,6 +92,10 @@ void		 pk_transaction_reset_after_lock_error		(PkTransaction *transaction);
 void		 pk_transaction_make_exclusive			(PkTransaction *transaction);
 void		 pk_transaction_skip_auth_checks		(PkTransaction *transaction,
 								 gboolean skip_checks);
+gboolean	 pk_transaction_set_hints_strv			(PkTransaction	*transaction,
+								 gchar		**hints,
+								 GError		**error);
+GVariant	*pk_transaction_get_properties			(PkTransaction	*transaction);
 
 G_END_DECLS
 